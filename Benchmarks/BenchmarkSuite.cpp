@@ -0,0 +1,325 @@
+// Every parser path on a generated corpus: ns per object/frame/entry and peak RSS per case, optionally as JSON so
+// results can be compared across commits.
+// Usage: benchmark-suite [--json results.json] [--corpus directory] [--label text] [--min-time ms]
+//                        [--hit-objects N] [--timing-points N] [--storyboard-commands N] [--entries N] [--frames N]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <osu!parser/Parser.hpp>
+#include <osu!parser/Parser/Analysis/Similarity.hpp>
+#include <osu!parser/Parser/Analysis/SliderEvents.hpp>
+#include <osu!parser/Parser/Analysis/SliderPath.hpp>
+#include <osu!parser/Parser/Analysis/Stacking.hpp>
+#include <osu!parser/Parser/Analysis/StarRating.hpp>
+#include "Corpus.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::string Name;
+        std::string Unit; // what one item is
+        std::size_t Items = 0;
+        std::size_t Bytes = 0;
+        std::size_t Iterations = 0;
+        double MedianNs = 0; // per item
+        double MinNs = 0;
+        std::uint64_t PeakRssKiB = 0;
+        bool Valid = true;
+    };
+
+    /**
+     *  Linux can reset the high-water mark (clear_refs "5"), so each case reports its own peak. Elsewhere the peak
+     *  only grows and a case reports the largest footprint of itself and everything before it.
+     */
+    void ResetPeakRss()
+    {
+#if defined(__linux__)
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+    }
+
+    std::uint64_t GetPeakRssKiB()
+    {
+#if defined(__linux__)
+        std::ifstream Status("/proc/self/status");
+        std::string Line;
+        while (std::getline(Status, Line))
+            if (Line.rfind("VmHWM:", 0) == 0) return std::strtoull(Line.c_str() + 6, nullptr, 10);
+        return 0;
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS Counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters))) return 0;
+        return Counters.PeakWorkingSetSize / 1024;
+#elif defined(__unix__) || defined(__APPLE__)
+        rusage Usage{};
+        getrusage(RUSAGE_SELF, &Usage);
+#if defined(__APPLE__)
+        return static_cast<std::uint64_t>(Usage.ru_maxrss) / 1024; // bytes there
+#else
+        return static_cast<std::uint64_t>(Usage.ru_maxrss);
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    // Runs Function until MinTime has passed (at least 3 times); Function returns whether its output was right
+    template <typename Fn>
+    Result Measure(std::string Name, std::string Unit, const std::size_t Items, const std::size_t Bytes,
+                   const double MinTime, const Fn& Function)
+    {
+        Result Measured{std::move(Name), std::move(Unit), Items, Bytes};
+        std::vector<double> Samples;
+        ResetPeakRss();
+        const auto Start = Clock::now();
+        while (Samples.size() < 3 || std::chrono::duration<double, std::milli>(Clock::now() - Start).count() < MinTime)
+        {
+            const auto Before = Clock::now();
+            Measured.Valid &= Function();
+            Samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - Before).count());
+        }
+        Measured.PeakRssKiB = GetPeakRssKiB();
+        std::sort(Samples.begin(), Samples.end());
+        const double PerItem = static_cast<double>(std::max<std::size_t>(Items, 1));
+        Measured.Iterations = Samples.size();
+        Measured.MedianNs = Samples[Samples.size() / 2] / PerItem;
+        Measured.MinNs = Samples.front() / PerItem;
+        return Measured;
+    }
+
+    std::string Escape(const std::string_view Text)
+    {
+        std::string Escaped;
+        for (const char Character : Text)
+        {
+            if (Character == '"' || Character == '\\') Escaped += '\\';
+            if (static_cast<unsigned char>(Character) >= 0x20) Escaped += Character;
+        }
+        return Escaped;
+    }
+
+    void WriteJson(std::ostream& Stream, const std::string& Label, const Corpus::BeatmapShape& Shape,
+                   const std::size_t Entries, const std::size_t Frames, const std::vector<Result>& Results)
+    {
+        OsuParser::TextWriter Writer(Stream);
+        Writer.SetLineEnding("\n");
+        Writer << "{\"label\":\"" << Escape(Label) << "\",\"corpus\":{\"hit_objects\":" << Shape.HitObjects
+            << ",\"timing_points\":" << Shape.TimingPoints << ",\"storyboard_commands\":" << Shape.StoryboardCommands
+            << ",\"entries\":" << Entries << ",\"frames\":" << Frames << ",\"seed\":" << Shape.Seed << "},";
+        Writer.NewLine();
+        Writer << "\"results\":[";
+        for (std::size_t i = 0; i < Results.size(); i++)
+        {
+            const Result& Case = Results[i];
+            Writer.NewLine();
+            Writer << "{\"name\":\"" << Escape(Case.Name) << "\",\"unit\":\"" << Case.Unit << "\",\"items\":"
+                << Case.Items << ",\"bytes\":" << Case.Bytes << ",\"iterations\":" << Case.Iterations
+                << ",\"ns_per_item\":" << Case.MedianNs << ",\"min_ns_per_item\":" << Case.MinNs
+                << ",\"mb_per_s\":" << static_cast<double>(Case.Bytes) / (Case.MedianNs * static_cast<double>(
+                    std::max<std::size_t>(Case.Items, 1))) * 1e3
+                << ",\"peak_rss_kib\":" << Case.PeakRssKiB << ",\"valid\":" << (Case.Valid ? "true" : "false") << '}'
+                << (i + 1 < Results.size() ? "," : "");
+        }
+        Writer << "]}";
+        Writer.NewLine();
+    }
+
+    std::span<const std::byte> Bytes(const std::string& Buffer)
+    {
+        return OsuParser::Utilities::AsBytes(Buffer);
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Corpus::BeatmapShape Shape;
+    std::size_t Entries = 20000, Frames = 100000;
+    double MinTime = 500;
+    std::string JsonPath, CorpusPath, Label;
+    for (int i = 1; i < argc; i += 2)
+    {
+        const std::string_view Option = argv[i];
+        if (i + 1 == argc)
+        {
+            std::cerr << "missing value for " << Option << '\n';
+            return 2;
+        }
+        const char* Value = argv[i + 1];
+        if (Option == "--json") JsonPath = Value;
+        else if (Option == "--corpus") CorpusPath = Value;
+        else if (Option == "--label") Label = Value;
+        else if (Option == "--min-time") MinTime = std::atof(Value);
+        else if (Option == "--hit-objects") Shape.HitObjects = std::strtoull(Value, nullptr, 10);
+        else if (Option == "--timing-points") Shape.TimingPoints = std::strtoull(Value, nullptr, 10);
+        else if (Option == "--storyboard-commands") Shape.StoryboardCommands = std::strtoull(Value, nullptr, 10);
+        else if (Option == "--entries") Entries = std::strtoull(Value, nullptr, 10);
+        else if (Option == "--frames") Frames = std::strtoull(Value, nullptr, 10);
+        else
+        {
+            std::cerr << "unknown option " << Option << '\n';
+            return 2;
+        }
+    }
+
+    namespace Beatmap = OsuParser::Beatmap;
+    using Beatmap::Section;
+    const std::string Map = Corpus::MakeBeatmap(Shape);
+    const std::size_t Sprites = (Shape.StoryboardCommands + 5) / 6;
+    std::vector<Result> Results;
+
+    Results.push_back(Measure("beatmap/full", "line", Shape.HitObjects + Shape.TimingPoints + Shape.StoryboardCommands
+        + Sprites, Map.size(), MinTime, [&]
+    {
+        const Beatmap::Beatmap Parsed(Bytes(Map));
+        return Parsed.HitObjects.data.size() == Shape.HitObjects
+            && Parsed.TimingPoints.data.size() == Shape.TimingPoints;
+    }));
+    Results.push_back(Measure("beatmap/hit-objects", "object", Shape.HitObjects, Map.size(), MinTime, [&]
+    {
+        const Beatmap::Beatmap Parsed(Bytes(Map), Section::HitObjects);
+        return Parsed.HitObjects.data.size() == Shape.HitObjects;
+    }));
+    Results.push_back(Measure("beatmap/timing-points", "point", Shape.TimingPoints, Map.size(), MinTime, [&]
+    {
+        const Beatmap::Beatmap Parsed(Bytes(Map), Section::TimingPoints);
+        return Parsed.TimingPoints.data.size() == Shape.TimingPoints;
+    }));
+    Results.push_back(Measure("beatmap/storyboard", "command", Shape.StoryboardCommands, Map.size(), MinTime, [&]
+    {
+        const Beatmap::Beatmap Parsed(Bytes(Map), Section::Events);
+        return Parsed.Events.objects.size() == Sprites + 1; // and the background
+    }));
+    Results.push_back(Measure("beatmap/tokenize", "line", Shape.HitObjects + Shape.TimingPoints
+        + Shape.StoryboardCommands + Sprites, Map.size(), MinTime, [&]
+    {
+        const OsuParser::Tokenizer Tokens(Map);
+        return Tokens["HitObjects"].size() == Shape.HitObjects;
+    }));
+    Beatmap::Beatmap Loaded(Bytes(Map));
+    Results.push_back(Measure("beatmap/pack", "object", Shape.HitObjects, Map.size(), MinTime, [&]
+    {
+        const Beatmap::Objects::HitObject::PackedHitObjects Packed(Loaded.HitObjects);
+        return Packed.size() == Shape.HitObjects;
+    }));
+    const std::size_t Sliders = std::ranges::count_if(Loaded.HitObjects.data, [](const auto& Object)
+    {
+        return Object.SliderParameters.has_value();
+    });
+    Results.push_back(Measure("beatmap/slider-paths", "slider", Sliders, Map.size(), MinTime, [&]
+    {
+        OsuParser::Analysis::SliderPath::SliderPaths Paths(Loaded.HitObjects);
+        Paths.BuildAll();
+        return !Sliders || Paths.GetEndPositions().size() == Shape.HitObjects;
+    }));
+    Results.push_back(Measure("beatmap/slider-events", "slider", Sliders, Map.size(), MinTime, [&]
+    {
+        const auto Events = OsuParser::Analysis::SliderEvents::Generate(Loaded);
+        return Events.Sliders == Sliders && Events.MaxCombo >= Shape.HitObjects;
+    }));
+    Results.push_back(Measure("beatmap/stacking", "object", Shape.HitObjects, Map.size(), MinTime, [&]
+    {
+        const OsuParser::Analysis::Stacking::Stacks Stacks(Loaded);
+        return Stacks.size() == Shape.HitObjects;
+    }));
+    Results.push_back(Measure("beatmap/star-rating", "object", Shape.HitObjects, Map.size(), MinTime, [&]
+    {
+        const OsuParser::Analysis::StarRating::DifficultyCalculator Calculator(Loaded);
+        return Calculator.Calculate().MaxCombo >= Shape.HitObjects;
+    }));
+    Results.push_back(Measure("beatmap/write", "line", Shape.HitObjects + Shape.TimingPoints
+        + Shape.StoryboardCommands + Sprites, Map.size(), MinTime, [&] { return !Loaded.ToString().empty(); }));
+
+    std::vector<std::string> Databases;
+    for (const Corpus::DatabaseLayout& Layout : Corpus::DATABASE_LAYOUTS)
+    {
+        Databases.push_back(Corpus::MakeDatabase(Entries, Layout.Version));
+        const std::string& Database = Databases.back();
+        Results.push_back(Measure(std::string("database/") + Layout.Name, "entry", Entries, Database.size(), MinTime,
+            [&]
+        {
+            const OsuParser::Database Parsed(Bytes(Database));
+            // the last entry only reads back right if every entry before it was laid out as the parser expects
+            return Parsed.Beatmaps.size() == Entries
+                && (!Entries || Parsed.Beatmaps.back().BeatmapID == static_cast<std::int32_t>((Entries - 1) / 4));
+        }));
+    }
+
+    const std::string FrameText = Corpus::MakeFrames(Frames);
+    const std::string Osr = Corpus::MakeReplay(Frames);
+    Results.push_back(Measure("replay/frames", "frame", Frames, FrameText.size(), MinTime, [&]
+    {
+        OsuParser::FrameParser Parser;
+        Parser.Push(FrameText);
+        Parser.Finish();
+        return Parser.Actions.size() == Frames;
+    }));
+    Results.push_back(Measure("replay/full", "frame", Frames, Osr.size(), MinTime, [&]
+    {
+        const OsuParser::Replay Parsed(Bytes(Osr));
+        return Parsed.Actions.size() == Frames && Parsed.OnlineScoreID == 42;
+    }));
+
+    // the same 5 minute path played 9 ms late with 2 px of noise has to come out as a near-duplicate with most
+    // signature rows equal, whatever --frames is; random frames must not
+    constexpr std::size_t PathFrames = 20000;
+    const OsuParser::Replay Original(Bytes(Corpus::MakeReplay(Corpus::MakeCursorFrames(PathFrames))));
+    const OsuParser::Replay Shifted(Bytes(Corpus::MakeReplay(Corpus::MakeCursorFrames(PathFrames, 9, 2.0f, 7), 7)));
+    const OsuParser::Replay Unrelated(Bytes(Corpus::MakeReplay(PathFrames)));
+    Results.push_back(Measure("replay/similarity", "frame", PathFrames * 3, 0, MinTime, [&]
+    {
+        namespace Similarity = OsuParser::Analysis::Similarity;
+        const auto First = Similarity::MakeFingerprint(Original).Signature;
+        const auto Second = Similarity::MakeFingerprint(Shifted).Signature;
+        const auto Equal = std::inner_product(First.begin(), First.end(), Second.begin(), std::size_t{0},
+                                              std::plus<>(), std::equal_to<>());
+        const auto Pairs = Similarity::FindSimilar({&Original, &Shifted, &Unrelated});
+        return Equal >= Similarity::SIGNATURE_SIZE * 3 / 4 && Pairs.size() == 1 && Pairs.front().First == 0
+            && Pairs.front().Second == 1 && Pairs.front().Similarity >= 0.9;
+    }));
+
+    if (!CorpusPath.empty())
+    {
+        std::filesystem::create_directories(CorpusPath);
+        const std::filesystem::path Directory(CorpusPath);
+        std::ofstream(Directory / "corpus.osu", std::ios::binary) << Map;
+        for (std::size_t i = 0; i < Databases.size(); i++)
+            std::ofstream(Directory / (std::string("osu!.") + Corpus::DATABASE_LAYOUTS[i].Name + ".db"),
+                          std::ios::binary) << Databases[i];
+        std::ofstream(Directory / "corpus.osr", std::ios::binary) << Osr;
+    }
+
+    bool Valid = true;
+    for (const Result& Case : Results)
+    {
+        Valid &= Case.Valid;
+        std::cout << Case.Name << std::string(Case.Name.size() < 26 ? 26 - Case.Name.size() : 1, ' ')
+            << Case.MedianNs << " ns/" << Case.Unit << ", peak " << Case.PeakRssKiB / 1024 << " MiB"
+            << (Case.Valid ? "" : " (WRONG OUTPUT)") << '\n';
+    }
+    if (!JsonPath.empty())
+    {
+        std::ofstream Json(JsonPath);
+        WriteJson(Json, Label, Shape, Entries, Frames, Results);
+    }
+    return Valid ? 0 : 1;
+}
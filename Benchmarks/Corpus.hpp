@@ -0,0 +1,304 @@
+// Deterministic synthetic inputs for the benchmarks: .osu maps, osu!.db files and .osr replays of a given size.
+// The same shape and seed always produce the same bytes, so results stay comparable across commits.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <osu!parser/Parser/Writer/TextWriter.hpp>
+#include <osu!parser/Parser/Replay.hpp> // pocketlzma, with its implementation compiled in
+
+namespace Corpus
+{
+    struct BeatmapShape
+    {
+        std::size_t HitObjects = 20000;
+        std::size_t TimingPoints = 2000;
+        std::size_t StoryboardCommands = 100000; // spread over sprites, six commands each
+        std::uint32_t Seed = 42;
+    };
+
+    // osu!.db layouts the parser tells apart by version
+    struct DatabaseLayout
+    {
+        const char* Name;
+        std::int32_t Version;
+    };
+
+    inline constexpr DatabaseLayout DATABASE_LAYOUTS[] = {
+        {"v20131216", 20131216}, // byte difficulties, no star ratings, trailing short
+        {"v20160408", 20160408}, // float difficulties, int-double star ratings, entry size
+        {"v20191106", 20191106}, // entry size dropped
+        {"v20250108", 20250108}, // int-float star ratings
+    };
+
+    inline constexpr std::int32_t LEGACY_VERSION = 20140609;
+
+    // Little-endian primitives and osu! strings (0x0B, ULEB128 length, bytes)
+    class BinaryWriter
+    {
+    public:
+        template <typename T>
+        void Write(const T Value)
+        {
+            char Bytes[sizeof(T)];
+            std::memcpy(Bytes, &Value, sizeof(T));
+            this->Buffer.append(Bytes, sizeof(T));
+        }
+
+        void WriteString(const std::string_view Text)
+        {
+            this->Write<std::uint8_t>(0x0B);
+            std::uint64_t Size = Text.size();
+            do
+            {
+                const auto Byte = static_cast<std::uint8_t>(Size & 0x7F);
+                Size >>= 7;
+                this->Write<std::uint8_t>(Size ? Byte | 0x80 : Byte);
+            }
+            while (Size);
+            this->Buffer.append(Text);
+        }
+
+        std::string Buffer;
+    };
+
+    inline std::string MakeBeatmap(const BeatmapShape& Shape)
+    {
+        std::mt19937 Random(Shape.Seed);
+        OsuParser::TextWriter Writer;
+        Writer << "osu file format v14\r\n\r\n[General]\r\nAudioFilename: audio.mp3\r\nAudioLeadIn: 0\r\n"
+            << "PreviewTime: 1000\r\nSampleSet: Soft\r\nStackLeniency: 0.7\r\nMode: 0\r\n\r\n"
+            << "[Editor]\r\nDistanceSpacing: 1.2\r\nBeatDivisor: 4\r\nGridSize: 32\r\n\r\n"
+            << "[Metadata]\r\nTitle:Synthetic\r\nArtist:osu!parser\r\nCreator:Corpus\r\nVersion:Benchmark\r\n"
+            << "BeatmapID:1\r\nBeatmapSetID:1\r\n\r\n"
+            << "[Difficulty]\r\nHPDrainRate:5\r\nCircleSize:4\r\nOverallDifficulty:8\r\nApproachRate:9\r\n"
+            << "SliderMultiplier:1.4\r\nSliderTickRate:1\r\n\r\n[Events]\r\n0,0,\"bg.jpg\",0,0\r\n";
+
+        const std::size_t Sprites = (Shape.StoryboardCommands + 5) / 6;
+        std::size_t Commands = 0;
+        for (std::size_t i = 0; i < Sprites; i++)
+        {
+            const auto Time = static_cast<std::int64_t>(i * 10);
+            Writer << "Sprite,Foreground,Centre,\"sb\\p" << static_cast<std::uint32_t>(i % 16) << ".png\","
+                << Random() % 640 << ',' << Random() % 480 << "\r\n";
+            const std::size_t Count = std::min<std::size_t>(6, Shape.StoryboardCommands - Commands);
+            for (std::size_t Command = 0; Command < Count; Command++)
+            {
+                switch (Command)
+                {
+                case 0: Writer << " F,0," << Time << ',' << Time + 500 << ",0,1\r\n"; break;
+                case 1:
+                    Writer << " M,1," << Time << ',' << Time + 500 << ',' << Random() % 640 << ',' << Random() % 480
+                        << ",320,240\r\n";
+                    break;
+                case 2: Writer << " S,0," << Time << ",," << 0.5 + Random() % 100 / 100.0 << "\r\n"; break;
+                case 3: Writer << " R,0," << Time << ',' << Time + 250 << ",0,3.14\r\n"; break;
+                case 4: Writer << " C,0," << Time << ",,255,255,255,0,128,255\r\n"; break;
+                default: Writer << " P,0," << Time << ',' << Time + 500 << ",A\r\n"; break;
+                }
+            }
+            Commands += Count;
+        }
+
+        Writer << "\r\n[TimingPoints]\r\n";
+        const std::size_t Length = std::max<std::size_t>(Shape.HitObjects, 1) * 150 + 1000;
+        for (std::size_t i = 0; i < Shape.TimingPoints; i++)
+        {
+            const std::size_t Time = i * Length / std::max<std::size_t>(Shape.TimingPoints, 1);
+            if (i % 4 == 0) Writer << Time << ',' << 300 + Random() % 200 << ",4,2,1,60,1,0\r\n";
+            else Writer << Time << ',' << -(25.0 + Random() % 300) << ",4,2,1," << 40 + Random() % 60 << ",0,0\r\n";
+        }
+
+        Writer << "\r\n[HitObjects]\r\n";
+        for (std::size_t i = 0; i < Shape.HitObjects; i++)
+        {
+            const std::size_t Time = 1000 + i * 150;
+            const std::uint32_t X = Random() % 512, Y = Random() % 384, Kind = Random() % 10;
+            if (Kind < 6) Writer << X << ',' << Y << ',' << Time << ",1," << Random() % 4 * 2 << ",0:0:0:0:\r\n";
+            else if (Kind < 9)
+            {
+                Writer << X << ',' << Y << ',' << Time << ",2,0,B";
+                for (std::uint32_t Point = 0, Points = 2 + Random() % 4; Point < Points; Point++)
+                    Writer << '|' << Random() % 512 << ':' << Random() % 384;
+                Writer << ',' << 1 + Random() % 2 << ',' << 70 + Random() % 140 << ",2|0,0:0|0:0,0:0:0:0:\r\n";
+            }
+            else Writer << "256,192," << Time << ",12,0," << Time + 100 << ",0:0:0:0:\r\n";
+        }
+        return Writer.Take();
+    }
+
+    inline std::string MakeDatabase(const std::size_t Entries, const std::int32_t Version,
+                                    const std::uint32_t Seed = 42)
+    {
+        std::mt19937 Random(Seed);
+        BinaryWriter Writer;
+        Writer.Write<std::int32_t>(Version);
+        Writer.Write<std::int32_t>(static_cast<std::int32_t>(Entries / 4));
+        Writer.Write<bool>(true);
+        Writer.Write<std::int64_t>(638000000000000000);
+        Writer.WriteString("Corpus");
+        Writer.Write<std::int32_t>(static_cast<std::int32_t>(Entries));
+
+        BinaryWriter Entry;
+        for (std::size_t i = 0; i < Entries; i++)
+        {
+            Entry.Buffer.clear();
+            const std::string Set = std::to_string(i / 4);
+            const std::string Difficulty = "Difficulty " + std::to_string(i % 4);
+            Entry.WriteString("Artist " + Set);
+            Entry.WriteString("Artist " + Set);
+            Entry.WriteString("Title " + Set);
+            Entry.WriteString("Title " + Set);
+            Entry.WriteString("Corpus");
+            Entry.WriteString(Difficulty);
+            Entry.WriteString("audio.mp3");
+            char Hash[32];
+            for (int Digit = 0; Digit < 32; Digit++) Hash[Digit] = "0123456789abcdef"[Random() % 16];
+            Entry.WriteString(std::string_view(Hash, 32));
+            Entry.WriteString("Artist " + Set + " - Title " + Set + " (Corpus) [" + Difficulty + "].osu");
+            Entry.Write<std::uint8_t>(4);
+            Entry.Write<std::int16_t>(static_cast<std::int16_t>(Random() % 1000));
+            Entry.Write<std::int16_t>(static_cast<std::int16_t>(Random() % 500));
+            Entry.Write<std::int16_t>(static_cast<std::int16_t>(Random() % 10));
+            Entry.Write<std::int64_t>(638000000000000000 + static_cast<std::int64_t>(i));
+            if (Version >= LEGACY_VERSION)
+            {
+                for (int Value = 0; Value < 4; Value++) Entry.Write<float>(static_cast<float>(Random() % 100) / 10);
+            }
+            else
+            {
+                for (int Value = 0; Value < 4; Value++) Entry.Write<std::uint8_t>(Random() % 10);
+            }
+            Entry.Write<double>(1.4);
+            if (Version >= LEGACY_VERSION)
+            {
+                // star ratings per mod combination, for each mode
+                for (int Mode = 0; Mode < 4; Mode++)
+                {
+                    Entry.Write<std::int32_t>(2);
+                    for (std::int32_t Mods : {0, 64})
+                    {
+                        Entry.Write<std::uint8_t>(0x08);
+                        Entry.Write<std::int32_t>(Mods);
+                        if (Version >= 20250107)
+                        {
+                            Entry.Write<std::uint8_t>(0x0C);
+                            Entry.Write<float>(static_cast<float>(Random() % 1000) / 100);
+                        }
+                        else
+                        {
+                            Entry.Write<std::uint8_t>(0x0D);
+                            Entry.Write<double>(static_cast<double>(Random() % 1000) / 100);
+                        }
+                    }
+                }
+            }
+            Entry.Write<std::int32_t>(180);
+            Entry.Write<std::int32_t>(185000);
+            Entry.Write<std::int32_t>(60000);
+            Entry.Write<std::int32_t>(3);
+            for (int Point = 0; Point < 3; Point++)
+            {
+                Entry.Write<double>(Point == 0 ? 333.33 : -100.0);
+                Entry.Write<double>(Point * 1000.0);
+                Entry.Write<bool>(Point == 0);
+            }
+            Entry.Write<std::int32_t>(static_cast<std::int32_t>(i));
+            Entry.Write<std::int32_t>(static_cast<std::int32_t>(i / 4));
+            Entry.Write<std::int32_t>(0);
+            for (int Mode = 0; Mode < 4; Mode++) Entry.Write<std::uint8_t>(9);
+            Entry.Write<std::int16_t>(0);
+            Entry.Write<float>(0.7f);
+            Entry.Write<std::uint8_t>(0);
+            Entry.WriteString("");
+            Entry.WriteString("synthetic corpus tags");
+            Entry.Write<std::int16_t>(0);
+            Entry.WriteString("");
+            Entry.Write<bool>(true);
+            Entry.Write<std::int64_t>(0);
+            Entry.Write<bool>(false);
+            Entry.WriteString(Set + " Artist " + Set + " - Title " + Set);
+            Entry.Write<std::int64_t>(0);
+            for (int Flag = 0; Flag < 5; Flag++) Entry.Write<bool>(false);
+            if (Version < LEGACY_VERSION) Entry.Write<std::int16_t>(0);
+            Entry.Write<std::int32_t>(0);
+            Entry.Write<std::uint8_t>(0);
+
+            if (Version < 20191106) Writer.Write<std::int32_t>(static_cast<std::int32_t>(Entry.Buffer.size()));
+            Writer.Buffer.append(Entry.Buffer);
+        }
+        Writer.Write<std::int32_t>(0);
+        return Writer.Buffer;
+    }
+
+    // Uncompressed replay frame text: the two leading frames osu! writes, Frames real ones, and the seed frame
+    inline std::string MakeFrames(const std::size_t Frames, const std::uint32_t Seed = 42)
+    {
+        std::mt19937 Random(Seed);
+        OsuParser::TextWriter Writer;
+        Writer << "0|256|-500|0,-1|256|-500|0,";
+        for (std::size_t i = 0; i < Frames; i++)
+            Writer << 1 + Random() % 16 << '|' << static_cast<float>(Random() % 51200) / 100 << '|'
+                << static_cast<float>(Random() % 38400) / 100 << '|' << Random() % 16 << ',';
+        Writer << "-12345|0|0|" << Seed;
+        return Writer.Take();
+    }
+
+    // A smooth cursor path at ~60 fps, played Offset ms late with up to Jitter osu!pixels of noise per frame
+    inline std::string MakeCursorFrames(const std::size_t Frames, const std::int64_t Offset = 0,
+                                        const float Jitter = 0, const std::uint32_t Seed = 42)
+    {
+        std::mt19937 Random(Seed);
+        std::uniform_real_distribution<float> Noise(-Jitter, Jitter);
+        OsuParser::TextWriter Writer;
+        Writer << "0|256|-500|0,-1|256|-500|0,";
+        for (std::size_t i = 0; i < Frames; i++)
+        {
+            const double Time = static_cast<double>(i) * 16 / 1000;
+            const double X = 256 + 200 * std::sin(2.1 * Time + 0.5 * std::sin(0.7 * Time));
+            const double Y = 192 + 150 * std::sin(2.9 * Time + 1);
+            Writer << (i ? 16 : 16 + Offset) << '|' << static_cast<float>(X) + Noise(Random) << '|'
+                << static_cast<float>(Y) + Noise(Random) << '|' << (i / 20 % 2 ? 1 : 0) << ',';
+        }
+        Writer << "-12345|0|0|" << Seed;
+        return Writer.Take();
+    }
+
+    // A .osr around already formatted frame text
+    inline std::string MakeReplay(const std::string& Text, const std::uint32_t Seed = 42)
+    {
+        std::vector<std::uint8_t> Compressed;
+        plz::PocketLzma Lzma;
+        Lzma.usePreset(plz::Preset::Fast);
+        Lzma.compress(std::vector<std::uint8_t>(Text.begin(), Text.end()), Compressed);
+
+        BinaryWriter Writer;
+        Writer.Write<std::uint8_t>(0);
+        Writer.Write<std::uint32_t>(20250108);
+        Writer.WriteString("0123456789abcdef0123456789abcdef");
+        Writer.WriteString("Corpus");
+        Writer.WriteString("fedcba9876543210fedcba9876543210");
+        for (const std::uint16_t Count : {1000, 50, 5, 200, 20, 3}) Writer.Write<std::uint16_t>(Count);
+        Writer.Write<std::uint32_t>(12345678);
+        Writer.Write<std::uint16_t>(1500);
+        Writer.Write<std::uint8_t>(0);
+        Writer.Write<std::uint32_t>(0);
+        Writer.WriteString("0|1,10000|0.95,");
+        Writer.Write<std::uint64_t>(638000000000000000);
+        Writer.Write<std::uint32_t>(static_cast<std::uint32_t>(Compressed.size()));
+        Writer.Buffer.append(reinterpret_cast<const char*>(Compressed.data()), Compressed.size());
+        Writer.Write<std::uint64_t>(Seed);
+        return Writer.Buffer;
+    }
+
+    inline std::string MakeReplay(const std::size_t Frames, const std::uint32_t Seed = 42)
+    {
+        return MakeReplay(MakeFrames(Frames, Seed), Seed);
+    }
+}
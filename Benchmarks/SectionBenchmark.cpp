@@ -0,0 +1,158 @@
+// Key dispatch tables vs. the previous std::map<std::string, std::string> + stod/stoi path, on the "Key: Value"
+// sections of a typical map.
+// Usage: section-benchmark [iterations]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <osu!parser/Parser/Beatmap.hpp>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    namespace Sections = OsuParser::Beatmap::Sections;
+
+    constexpr std::string_view HEADER =
+        "osu file format v14\r\n\r\n"
+        "[General]\r\nAudioFilename: audio.mp3\r\nAudioLeadIn: 0\r\nPreviewTime: 84201\r\nCountdown: 0\r\n"
+        "SampleSet: Soft\r\nStackLeniency: 0.7\r\nMode: 0\r\nLetterboxInBreaks: 0\r\nEpilepsyWarning: 1\r\n"
+        "WidescreenStoryboard: 1\r\n\r\n"
+        "[Editor]\r\nBookmarks: 1234,5678\r\nDistanceSpacing: 1.1\r\nBeatDivisor: 4\r\nGridSize: 32\r\n"
+        "TimelineZoom: 2.4\r\n\r\n"
+        "[Metadata]\r\nTitle:Benchmark\r\nTitleUnicode:Benchmark\r\nArtist:osu!parser\r\nArtistUnicode:osu!parser\r\n"
+        "Creator:someone\r\nVersion:Insane\r\nSource:\r\nTags:bench mark section key table\r\nBeatmapID:123456\r\n"
+        "BeatmapSetID:54321\r\n\r\n"
+        "[Difficulty]\r\nHPDrainRate:6\r\nCircleSize:4\r\nOverallDifficulty:8.5\r\nApproachRate:9.3\r\n"
+        "SliderMultiplier:1.8\r\nSliderTickRate:1\r\n\r\n"
+        "[Colours]\r\nCombo1 : 255,128,64\r\nCombo2 : 0,202,0\r\nCombo3 : 18,124,255\r\nCombo4 : 242,24,57\r\n"
+        "SliderBorder : 255,255,255\r\n";
+
+    // What the sections did before the key tables: every line copied into a map, then one lookup per member
+    std::map<std::string, std::string> LegacyAttributes(const OsuParser::Lines& Lines)
+    {
+        std::map<std::string, std::string> Attributes;
+        for (const std::string_view Line : Lines)
+        {
+            if (Line.find(':') == std::string_view::npos) continue;
+            const std::vector<std::string_view> SplitLine = OsuParser::Utilities::Split(Line, ':', true);
+            Attributes[std::string(OsuParser::Utilities::Trim(SplitLine[0]))] =
+                OsuParser::Utilities::Trim(SplitLine[1]);
+        }
+        return Attributes;
+    }
+
+    double LegacyNumber(const std::map<std::string, std::string>& Attributes, const std::string& Key,
+                        const double Fallback)
+    {
+        const auto Iterator = Attributes.find(Key);
+        if (Iterator == Attributes.end() || Iterator->second.empty()) return Fallback;
+        try
+        {
+            return std::stod(Iterator->second);
+        }
+        catch (...)
+        {
+            return Fallback;
+        }
+    }
+
+    std::string LegacyString(const std::map<std::string, std::string>& Attributes, const std::string& Key)
+    {
+        const auto Iterator = Attributes.find(Key);
+        return Iterator != Attributes.end() ? Iterator->second : "";
+    }
+
+    // Legacy versions of the members that are compared afterwards; the rest are looked up the same way
+    struct LegacyResult
+    {
+        double StackLeniency = 0.7;
+        double OverallDifficulty = 0;
+        double ApproachRate = 0;
+        std::string Version;
+        std::size_t Lookups = 0;
+    };
+
+    LegacyResult LegacyParse(const OsuParser::Tokenizer& Tokens)
+    {
+        LegacyResult Result;
+        const auto General = LegacyAttributes(Tokens["General"]);
+        for (const char* Key : {"AudioFilename", "SampleSet", "SkinPreference"})
+            Result.Lookups += LegacyString(General, Key).size();
+        for (const char* Key : {"AudioLeadIn", "PreviewTime", "Countdown", "Mode", "LetterboxInBreaks",
+                                "UseSkinSprites", "OverlayPosition", "EpilepsyWarning", "CountdownOffset",
+                                "SpecialStyle", "WidescreenStoryboard", "SamplesMatchPlaybackRate"})
+            Result.Lookups += static_cast<std::size_t>(LegacyNumber(General, Key, 0));
+        Result.StackLeniency = LegacyNumber(General, "StackLeniency", Result.StackLeniency);
+
+        const auto Editor = LegacyAttributes(Tokens["Editor"]);
+        for (const char* Key : {"DistanceSpacing", "BeatDivisor", "GridSize", "TimelineZoom"})
+            Result.Lookups += LegacyString(Editor, Key).size();
+
+        const auto Metadata = LegacyAttributes(Tokens["Metadata"]);
+        for (const char* Key : {"Title", "TitleUnicode", "Artist", "ArtistUnicode", "Creator", "Source", "Tags",
+                                "BeatmapID", "BeatmapSetID"})
+            Result.Lookups += LegacyString(Metadata, Key).size();
+        Result.Version = LegacyString(Metadata, "Version");
+
+        const auto Difficulty = LegacyAttributes(Tokens["Difficulty"]);
+        for (const char* Key : {"HPDrainRate", "CircleSize", "SliderMultiplier", "SliderTickRate"})
+            Result.Lookups += static_cast<std::size_t>(LegacyNumber(Difficulty, Key, 0));
+        Result.OverallDifficulty = LegacyNumber(Difficulty, "OverallDifficulty", 0);
+        Result.ApproachRate = LegacyNumber(Difficulty, "ApproachRate", 0);
+
+        const auto Colours = LegacyAttributes(Tokens["Colours"]);
+        for (const char* Key : {"Combo1", "Combo2", "Combo3", "Combo4", "Combo5", "Combo6", "Combo7", "Combo8",
+                                "SliderTrackOverride", "SliderBorder"})
+        {
+            const std::string Value = LegacyString(Colours, Key);
+            if (Value.empty()) continue;
+            for (const std::string_view Part : OsuParser::Utilities::Split(std::string_view(Value), ','))
+                Result.Lookups += static_cast<std::size_t>(std::stoi(std::string(Part)));
+        }
+        return Result;
+    }
+
+    template <typename Fn>
+    double Measure(const int Iterations, const Fn& Function)
+    {
+        const auto Start = Clock::now();
+        for (int i = 0; i < Iterations; i++) Function();
+        return std::chrono::duration<double, std::micro>(Clock::now() - Start).count() / Iterations;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    const int Iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const OsuParser::Tokenizer Tokens(HEADER);
+
+    LegacyResult Legacy;
+    const double LegacyTime = Measure(Iterations, [&] { Legacy = LegacyParse(Tokens); });
+
+    Sections::General::GeneralSection General;
+    Sections::Metadata::MetadataSection Metadata;
+    Sections::Difficulty::DifficultySection Difficulty;
+    std::size_t Read = 0;
+    const double TableTime = Measure(Iterations, [&]
+    {
+        General = {};
+        Sections::Editor::EditorSection Editor;
+        Metadata = {};
+        Difficulty = {};
+        Sections::Colour::ColourSection Colours;
+        Read = General.Parse(Tokens["General"]).value_or(0) + Editor.Parse(Tokens["Editor"]).value_or(0)
+            + Metadata.Parse(Tokens["Metadata"]).value_or(0) + Difficulty.Parse(Tokens["Difficulty"]).value_or(0)
+            + Colours.Parse(Tokens["Colours"]).value_or(0);
+    });
+
+    const bool Match = General.StackLeniency == Legacy.StackLeniency && Metadata.Version == Legacy.Version
+        && Difficulty.OverallDifficulty == Legacy.OverallDifficulty && Difficulty.ApproachRate == Legacy.ApproachRate;
+    std::cout << "key lines: " << Read << '\n'
+        << "legacy map + stod: " << LegacyTime << " us per map\n"
+        << "key tables:        " << TableTime << " us per map (" << LegacyTime / TableTime << "x)"
+        << (Match ? "" : " (MISMATCH)") << '\n';
+    return Match ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+// Tokenizer vs. the previous getline/Trim/std::string line path, on a generated storyboard-heavy map.
+// Usage: tokenizer-benchmark [beatmap.osu]  (a synthetic map is written to the working directory if omitted)
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <osu!parser/Parser/Beatmap.hpp>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string WriteStoryboardMap(const std::string& Path, const std::size_t Sprites)
+    {
+        std::mt19937 Random(42);
+        std::ofstream Stream(Path, std::ios::binary);
+        Stream << "osu file format v14\r\n\r\n[General]\r\nAudioFilename: audio.mp3\r\nMode: 0\r\n\r\n"
+            << "[Metadata]\r\nTitle:Benchmark\r\nArtist:osu!parser\r\nVersion:Storyboard\r\n\r\n"
+            << "[Difficulty]\r\nCircleSize:4\r\nOverallDifficulty:8\r\nSliderMultiplier:1.4\r\n\r\n[Events]\r\n";
+        for (std::size_t i = 0; i < Sprites; i++)
+        {
+            const auto Time = static_cast<int>(i * 10);
+            Stream << "Sprite,Foreground,Centre,\"sb\\p.png\"," << Random() % 640 << ',' << Random() % 480 << "\r\n"
+                << " F,0," << Time << ',' << Time + 500 << ",0,1\r\n"
+                << " M,1," << Time << ',' << Time + 500 << ",320,240,330,250\r\n"
+                << " L," << Time << ",4\r\n"
+                << "  S,0,0,100,0.5,1\r\n"
+                << "  R,0,0,100,0,3.14\r\n";
+        }
+        Stream << "\r\n[TimingPoints]\r\n0,500,4,2,0,60,1,0\r\n\r\n[HitObjects]\r\n";
+        for (std::size_t i = 0; i < Sprites / 4; i++)
+            Stream << Random() % 512 << ',' << Random() % 384 << ',' << i * 100 << ",1,0,0:0:0:0:\r\n";
+        return Path;
+    }
+
+    // The line path Beatmap used before Tokenizer: one std::string per line, trimmed by value, stored per section
+    std::unordered_map<std::string, std::vector<std::string>> LegacyTokenize(const std::string& Path)
+    {
+        std::unordered_map<std::string, std::vector<std::string>> Sections;
+        std::ifstream Stream(Path);
+        std::string CurrentLine;
+        std::string CurrentSection = {};
+        while (std::getline(Stream, CurrentLine))
+        {
+            if (!CurrentLine.empty() && CurrentLine.back() == '\r') CurrentLine.pop_back();
+            if (CurrentSection == "Events")
+            {
+                CurrentLine = OsuParser::Utilities::Trim(CurrentLine, true);
+                const auto CurrentLineIfAllTrimmed = OsuParser::Utilities::Trim(CurrentLine);
+                if (CurrentLineIfAllTrimmed.size() < 3) continue;
+                if (CurrentLineIfAllTrimmed[0] == '/' && CurrentLineIfAllTrimmed[1] == '/') continue;
+            }
+            else
+            {
+                CurrentLine = OsuParser::Utilities::Trim(CurrentLine);
+                if (CurrentLine.size() < 3) continue;
+                if (CurrentLine[0] == '/' && CurrentLine[1] == '/') continue;
+            }
+            if (CurrentLine.front() == '[' && CurrentLine.back() == ']')
+            {
+                CurrentSection = OsuParser::Utilities::Split(OsuParser::Utilities::Split(CurrentLine, '[')[1], ']')[0];
+                continue;
+            }
+            Sections[CurrentSection].push_back(CurrentLine);
+        }
+        return Sections;
+    }
+
+    template <typename Fn>
+    double Measure(const int Iterations, const Fn& Function)
+    {
+        const auto Start = Clock::now();
+        for (int i = 0; i < Iterations; i++) Function();
+        return std::chrono::duration<double, std::milli>(Clock::now() - Start).count() / Iterations;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    const std::string Path = argc > 1 ? argv[1] : WriteStoryboardMap("tokenizer-benchmark.osu", 20000);
+    constexpr int Iterations = 10;
+
+    std::size_t LegacyLines = 0, Lines = 0;
+    const double Legacy = Measure(Iterations, [&]
+    {
+        LegacyLines = 0;
+        for (const auto& [Name, Section] : LegacyTokenize(Path)) LegacyLines += Section.size();
+    });
+    const double Tokenized = Measure(Iterations, [&]
+    {
+        const std::string Buffer = OsuParser::Tokenizer::ReadFile(Path);
+        const OsuParser::Tokenizer Tokens(Buffer);
+        Lines = 0;
+        for (const auto& [Name, Section] : Tokens.Sections) Lines += Section.size();
+    });
+
+    // Structural index per scan backend; every backend has to produce the same offsets
+    const std::string Buffer = OsuParser::Tokenizer::ReadFile(Path);
+    const OsuParser::StructuralIndex Reference(Buffer, OsuParser::ScanBackend::Scalar);
+    bool BackendsMatch = true;
+    std::cout << "structural index (" << Buffer.size() / 1024 << " KiB):\n";
+    for (const auto& [Backend, Name] : {std::pair{OsuParser::ScanBackend::Scalar, "scalar"},
+                                        std::pair{OsuParser::ScanBackend::SSE2, "sse2"},
+                                        std::pair{OsuParser::ScanBackend::AVX2, "avx2"}})
+    {
+        if (Backend == OsuParser::ScanBackend::AVX2 && OsuParser::StructuralIndex::GetBestBackend() != Backend)
+            continue;
+        OsuParser::StructuralIndex Index;
+        const double Time = Measure(Iterations, [&] { Index.Build(Buffer, Backend); });
+        const bool Match = Index.Newlines == Reference.Newlines && Index.Commas == Reference.Commas
+            && Index.Pipes == Reference.Pipes && Index.Colons == Reference.Colons;
+        BackendsMatch &= Match;
+        std::cout << "  " << Name << ": " << Time << " ms, " << Buffer.size() / Time / 1e6 << " GB/s"
+            << (Match ? "" : " (MISMATCH)") << '\n';
+    }
+
+    // Numeric fields through std::stod on a temporary string, as the parsers did, and through from_chars
+    const OsuParser::Tokenizer Tokens(Buffer);
+    std::vector<std::string_view> Numbers;
+    for (const char* Name : {"Events", "HitObjects"})
+        for (const std::string_view Line : Tokens[Name])
+            for (const std::string_view Field : OsuParser::Utilities::Split(Line, ','))
+                if (OsuParser::Utilities::ParseNumber<double>(Field)) Numbers.push_back(Field);
+    double StodSum = 0, FromCharsSum = 0;
+    const double Stod = Measure(Iterations, [&]
+    {
+        StodSum = 0;
+        for (const std::string_view Field : Numbers) StodSum += std::stod(std::string(Field));
+    });
+    const double FromChars = Measure(Iterations, [&]
+    {
+        FromCharsSum = 0;
+        for (const std::string_view Field : Numbers) FromCharsSum += *OsuParser::Utilities::ParseNumber<double>(Field);
+    });
+
+    const double Full = Measure(Iterations, [&] { const OsuParser::Beatmap::Beatmap Beatmap(Path); });
+    const double LazyMetadata = Measure(Iterations, [&]
+    {
+        OsuParser::Beatmap::Beatmap Beatmap(Path, OsuParser::Beatmap::LoadMode::Lazy);
+        static_cast<void>(Beatmap.GetMetadata());
+    });
+
+    // Writing it back; what is written has to read back to the same text
+    OsuParser::Beatmap::Beatmap Loaded(Path);
+    std::string Written;
+    const double Write = Measure(Iterations, [&] { Written = Loaded.ToString(); });
+    OsuParser::Beatmap::Beatmap Reloaded(std::span(reinterpret_cast<const std::byte*>(Written.data()), Written.size()));
+    const bool RoundTrip = Reloaded.ToString() == Written;
+
+    // MD5 of 64 maps: one after another, and side by side in SIMD lanes; both have to agree
+    const std::vector<std::string_view> Maps(64, Buffer);
+    std::vector<OsuParser::Md5::Digest> ScalarDigests, LaneDigests;
+    const double ScalarHash = Measure(Iterations, [&]
+    {
+        ScalarDigests = OsuParser::Md5::HashMany(Maps, OsuParser::ScanBackend::Scalar);
+    });
+    const double LaneHash = Measure(Iterations, [&] { LaneDigests = OsuParser::Md5::HashMany(Maps); });
+    const bool HashesMatch = ScalarDigests == LaneDigests;
+    const double HashedMB = static_cast<double>(Maps.size() * Buffer.size()) / 1e3;
+
+    std::cout << "lines: " << Lines << " (legacy " << LegacyLines << ")\n"
+        << "legacy getline path: " << Legacy << " ms\n"
+        << "tokenizer:           " << Tokenized << " ms (" << Legacy / Tokenized << "x)\n"
+        << "numbers (" << Numbers.size() << "): stod " << Stod << " ms, from_chars " << FromChars << " ms ("
+        << Stod / FromChars << "x)\n"
+        << "full Beatmap load:   " << Full << " ms\n"
+        << "lazy Metadata only:  " << LazyMetadata << " ms\n"
+        << "Beatmap write:       " << Write << " ms, " << Written.size() / Write / 1e3 << " MB/s"
+        << (RoundTrip ? "" : " (ROUND TRIP MISMATCH)") << '\n'
+        << "md5 scalar:          " << HashedMB / ScalarHash << " MB/s\n"
+        << "md5 multi-buffer:    " << HashedMB / LaneHash << " MB/s (" << ScalarHash / LaneHash << "x)"
+        << (HashesMatch ? "" : " (MISMATCH)") << '\n';
+    return Lines == LegacyLines && BackendsMatch && StodSum == FromCharsSum && RoundTrip && HashesMatch ? 0 : 1;
+}
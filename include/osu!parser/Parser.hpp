@@ -1,4 +1,7 @@
 #pragma once
 #include "Parser/Beatmap.hpp"
 #include "Parser/Replay.hpp"
-#include "Parser/Database.hpp"
\ No newline at end of file
+#include "Parser/Database.hpp"
+#include "Parser/Osz.hpp"
+#include "Parser/Library.hpp"
+#include "Parser/LibraryCache.hpp"
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSU_PARSER_HEATMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "osu!parser/Parser/Replay.hpp"
+#include "osu!parser/Parser/Utilities.hpp"
+#include "osu!parser/Parser/Structures/Replay/Mods.hpp"
+
+namespace OsuParser::Analysis::Heatmap
+{
+    static constexpr float PLAYFIELD_WIDTH = 512.0f;
+    static constexpr float PLAYFIELD_HEIGHT = 384.0f;
+
+    struct HeatmapOptions
+    {
+        std::uint32_t Width = 128;
+        std::uint32_t Height = 96;
+        std::int64_t StartTime = std::numeric_limits<std::int64_t>::min();
+        std::int64_t EndTime = std::numeric_limits<std::int64_t>::max(); // exclusive
+        bool NormalizeHardRock = true; // flip HR replays back onto the unflipped playfield
+        std::uint32_t Threads = 0; // 0 = hardware concurrency
+    };
+
+    /**
+     *  Cursor density grid over the 512x384 playfield.
+     *
+     *  Frames outside the playfield are dropped. Replay frames are sorted by time, so the time window is
+     *  resolved with two binary searches; binning itself runs 4 frames at a time with SSE2 when available.
+     */
+    class Heatmap
+    {
+    public:
+        Heatmap(const std::uint32_t Width, const std::uint32_t Height)
+            : Width(Width), Height(Height), Cells(static_cast<std::size_t>(Width) * Height, 0)
+        {
+        }
+
+        void Accumulate(const std::vector<ReplayAction>& Actions, const std::uint32_t Mods,
+                        const std::int64_t StartTime = std::numeric_limits<std::int64_t>::min(),
+                        const std::int64_t EndTime = std::numeric_limits<std::int64_t>::max(),
+                        const bool NormalizeHardRock = true)
+        {
+            const auto Begin = std::ranges::lower_bound(Actions, StartTime, {}, &ReplayAction::Offset);
+            const auto End = std::ranges::lower_bound(Begin, Actions.end(), EndTime, {}, &ReplayAction::Offset);
+            const ReplayAction* Frames = Actions.data() + (Begin - Actions.begin());
+            const std::size_t Count = static_cast<std::size_t>(End - Begin);
+            const bool FlipY = NormalizeHardRock && HasMod(Mods, Mod::HardRock);
+
+            const float ScaleX = static_cast<float>(this->Width) / PLAYFIELD_WIDTH;
+            const float ScaleY = static_cast<float>(this->Height) / PLAYFIELD_HEIGHT;
+            std::size_t i = 0;
+
+#ifdef OSU_PARSER_HEATMAP_SSE2
+            const __m128 VecScaleX = _mm_set1_ps(ScaleX), VecScaleY = _mm_set1_ps(ScaleY);
+            const __m128 VecWidth = _mm_set1_ps(PLAYFIELD_WIDTH), VecHeight = _mm_set1_ps(PLAYFIELD_HEIGHT);
+            const __m128 VecRowStride = _mm_set1_ps(static_cast<float>(this->Width));
+            const __m128 LastColumn = _mm_set1_ps(static_cast<float>(this->Width - 1));
+            const __m128 LastRow = _mm_set1_ps(static_cast<float>(this->Height - 1));
+            const __m128 Zero = _mm_setzero_ps();
+            alignas(16) std::int32_t Indices[4];
+
+            for (; i + 4 <= Count; i += 4)
+            {
+                const ReplayAction* Frame = Frames + i;
+                const __m128 X = _mm_set_ps(Frame[3].X, Frame[2].X, Frame[1].X, Frame[0].X);
+                __m128 Y = _mm_set_ps(Frame[3].Y, Frame[2].Y, Frame[1].Y, Frame[0].Y);
+                if (FlipY) Y = _mm_sub_ps(VecHeight, Y);
+
+                const __m128 Inside = _mm_and_ps(
+                    _mm_and_ps(_mm_cmpge_ps(X, Zero), _mm_cmplt_ps(X, VecWidth)),
+                    _mm_and_ps(_mm_cmpge_ps(Y, Zero), _mm_cmplt_ps(Y, VecHeight)));
+                const int Mask = _mm_movemask_ps(Inside);
+                if (!Mask) continue;
+
+                // truncated cell coordinates are small integers, so row * Width + column is exact in float
+                const __m128 Column = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(X, VecScaleX))),
+                                                 LastColumn);
+                const __m128 Row = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(Y, VecScaleY))), LastRow);
+                _mm_store_si128(reinterpret_cast<__m128i*>(Indices),
+                                _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Row, VecRowStride), Column)));
+
+                for (int Lane = 0; Lane < 4; Lane++)
+                    if (Mask & (1 << Lane)) ++this->Cells[Indices[Lane]];
+                this->Total += static_cast<std::uint64_t>(std::popcount(static_cast<unsigned>(Mask)));
+            }
+#endif
+            for (; i < Count; i++)
+            {
+                const float X = Frames[i].X;
+                const float Y = FlipY ? PLAYFIELD_HEIGHT - Frames[i].Y : Frames[i].Y;
+                if (!(X >= 0 && X < PLAYFIELD_WIDTH && Y >= 0 && Y < PLAYFIELD_HEIGHT)) continue;
+
+                const auto Column = std::min(static_cast<std::uint32_t>(X * ScaleX), this->Width - 1);
+                const auto Row = std::min(static_cast<std::uint32_t>(Y * ScaleY), this->Height - 1);
+                ++this->Cells[static_cast<std::size_t>(Row) * this->Width + Column];
+                ++this->Total;
+            }
+        }
+
+        void Accumulate(const Replay& Replay, const HeatmapOptions& Options = {})
+        {
+            this->Accumulate(Replay.Actions, Replay.Mods, Options.StartTime, Options.EndTime,
+                             Options.NormalizeHardRock);
+        }
+
+        void Merge(const Heatmap& Other)
+        {
+            for (std::size_t i = 0; i < this->Cells.size(); i++)
+                this->Cells[i] += Other.Cells[i];
+            this->Total += Other.Total;
+        }
+
+        // Cursor x/y in playfield coordinates, edges included; 0 outside the playfield
+        [[nodiscard]] std::uint32_t At(const float X, const float Y) const
+        {
+            if (!(X >= 0 && X <= PLAYFIELD_WIDTH && Y >= 0 && Y <= PLAYFIELD_HEIGHT)) return 0;
+
+            const auto Column = std::min(static_cast<std::uint32_t>(X * static_cast<float>(this->Width)
+                                             / PLAYFIELD_WIDTH), this->Width - 1);
+            const auto Row = std::min(static_cast<std::uint32_t>(Y * static_cast<float>(this->Height)
+                                          / PLAYFIELD_HEIGHT), this->Height - 1);
+            return this->Cells[static_cast<std::size_t>(Row) * this->Width + Column];
+        }
+
+        // Each worker bins its share of the replays into a private grid, grids are merged at the end
+        static Heatmap Build(const std::vector<const Replay*>& Replays, const HeatmapOptions& Options = {})
+        {
+            std::uint32_t ThreadCount = Options.Threads ? Options.Threads : std::thread::hardware_concurrency();
+            ThreadCount = static_cast<std::uint32_t>(std::max<std::size_t>(1, std::min<std::size_t>(
+                                                         ThreadCount, Replays.size())));
+
+            std::vector<Heatmap> Partials(ThreadCount, Heatmap(Options.Width, Options.Height));
+            Utilities::ParallelFor(Replays.size(), ThreadCount, [&](const std::size_t Index, const std::uint32_t Worker)
+            {
+                Partials[Worker].Accumulate(*Replays[Index], Options);
+            });
+
+            Heatmap Result = std::move(Partials.front());
+            for (std::size_t i = 1; i < Partials.size(); i++)
+                Result.Merge(Partials[i]);
+            return Result;
+        }
+
+    public:
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::vector<std::uint32_t> Cells; // row-major, Height rows of Width cells
+        std::uint64_t Total = 0; // frames binned
+    };
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "osu!parser/Parser/Beatmap.hpp"
+#include "osu!parser/Parser/Replay.hpp"
+#include "osu!parser/Parser/Structures/Replay/Mods.hpp"
+#include "Stacking.hpp"
+
+namespace OsuParser::Analysis::Judgement
+{
+    static constexpr double PLAYFIELD_HEIGHT = 384.0;
+
+    enum class HitResult : std::uint8_t
+    {
+        None = 0, // not judged (spinners, osu!mania hold notes)
+        Miss,
+        Meh, // 50
+        Ok, // 100
+        Great // 300
+    };
+
+    struct ObjectJudgement
+    {
+        HitResult Result = HitResult::None;
+        std::int32_t HitError = 0; // press time - object time, only meaningful for hits
+    };
+
+    struct JudgementResult
+    {
+        std::vector<ObjectJudgement> Objects; // same order as Beatmap::HitObjects.data
+        std::uint32_t Count300 = 0;
+        std::uint32_t Count100 = 0;
+        std::uint32_t Count50 = 0;
+        std::uint32_t CountMiss = 0;
+        double MeanOffset = 0; // negative = early; in real time, like UnstableRate
+        double UnstableRate = 0; // 10 * standard deviation of hit errors, in real time
+    };
+
+    struct HitWindows
+    {
+        double Great = 0;
+        double Ok = 0;
+        double Meh = 0;
+
+        HitWindows() = default;
+        explicit HitWindows(const double OverallDifficulty)
+            : Great(80.0 - 6.0 * OverallDifficulty),
+              Ok(140.0 - 8.0 * OverallDifficulty),
+              Meh(200.0 - 10.0 * OverallDifficulty)
+        {
+        }
+
+        [[nodiscard]] HitResult Get(const double HitError) const
+        {
+            const double Error = std::abs(HitError);
+            if (Error <= Great) return HitResult::Great;
+            if (Error <= Ok) return HitResult::Ok;
+            if (Error <= Meh) return HitResult::Meh;
+            return HitResult::Miss;
+        }
+    };
+
+    inline double GetCircleRadius(const double CircleSize)
+    {
+        return 54.4 - 4.48 * CircleSize;
+    }
+
+    /**
+     *  Recomputes osu!standard judgements of replays against one beatmap.
+     *
+     *  The beatmap is flattened once on construction, so any number of replays of the same map can be judged
+     *  without touching the parsed Beatmap again. Key presses and objects are swept together in time order;
+     *  only the earliest unjudged object is hittable (notelock), which keeps every replay linear in frames + objects.
+     *
+     *  Objects are hit where they are drawn, stack offsets included. Stack heights come from the map as it is,
+     *  without mods; only the offset per level follows the modded CircleSize. HardRock flips the object before
+     *  the offset is applied, like osu! does.
+     *
+     *  Sliders are judged on their head only, spinners are not judged.
+     */
+    class JudgementEngine
+    {
+    public:
+        explicit JudgementEngine(const Beatmap::Beatmap& Beatmap)
+            : m_ObjectCount(Beatmap.HitObjects.data.size()),
+              m_OverallDifficulty(Beatmap.Difficulty.OverallDifficulty),
+              m_CircleSize(Beatmap.Difficulty.CircleSize)
+        {
+            const auto& Objects = Beatmap.HitObjects.data;
+            const Stacking::Stacks Stacks(Beatmap);
+            this->m_Targets.reserve(Objects.size());
+            for (std::size_t i = 0; i < Objects.size(); i++)
+            {
+                const auto& Object = Objects[i];
+                if (!Object.type.HitCircle && !Object.type.Slider) continue;
+                this->m_Targets.push_back({
+                    Object.Time, static_cast<float>(Object.Pos.x), static_cast<float>(Object.Pos.y),
+                    static_cast<std::uint32_t>(i), Stacks.GetHeight(i)
+                });
+            }
+        }
+
+        [[nodiscard]] JudgementResult Judge(const std::vector<ReplayAction>& Actions, const std::uint32_t Mods) const
+        {
+            JudgementResult Result;
+            Result.Objects.resize(this->m_ObjectCount);
+
+            const HitWindows Windows(ApplyDifficultyMods(this->m_OverallDifficulty, Mods));
+            const double Radius = GetCircleRadius(ApplyDifficultyMods(this->m_CircleSize, Mods, 1.3));
+            const double RadiusSquared = Radius * Radius;
+            const double StackOffset = Stacking::STACK_OFFSET
+                * Stacking::Stacks::GetScale(ApplyDifficultyMods(this->m_CircleSize, Mods, 1.3));
+            const bool FlipY = HasMod(Mods, Mod::HardRock);
+
+            // Welford accumulators for hit errors
+            std::uint32_t HitCount = 0;
+            double Mean = 0, M2 = 0;
+
+            std::size_t Next = 0;
+            bool LeftHeld = false, RightHeld = false;
+            for (const ReplayAction& Action : Actions)
+            {
+                const double Time = static_cast<double>(Action.Offset);
+
+                // everything whose last chance has passed is a miss
+                while (Next < this->m_Targets.size() && Time > this->m_Targets[Next].Time + Windows.Meh)
+                    Result.Objects[this->m_Targets[Next++].Index].Result = HitResult::Miss;
+
+                // K1/K2 always carry M1/M2 bits as well
+                const bool Left = (Action.Keys & 0b0101) != 0;
+                const bool Right = (Action.Keys & 0b1010) != 0;
+                std::int32_t Presses = (Left && !LeftHeld) + (Right && !RightHeld);
+                LeftHeld = Left;
+                RightHeld = Right;
+
+                while (Presses-- > 0 && Next < this->m_Targets.size())
+                {
+                    const Target& Object = this->m_Targets[Next];
+                    const double HitError = Time - Object.Time;
+                    if (HitError < -Windows.Meh) break; // too early, nothing hittable yet
+
+                    const double Offset = Object.StackHeight * StackOffset;
+                    const double ObjectX = Object.X + Offset;
+                    const double ObjectY = (FlipY ? PLAYFIELD_HEIGHT - Object.Y : Object.Y) + Offset;
+                    const double DeltaX = Action.X - ObjectX, DeltaY = Action.Y - ObjectY;
+                    if (DeltaX * DeltaX + DeltaY * DeltaY > RadiusSquared) break; // shake
+
+                    auto& Judgement = Result.Objects[Object.Index];
+                    Judgement.Result = Windows.Get(HitError);
+                    Judgement.HitError = static_cast<std::int32_t>(HitError);
+                    ++Next;
+
+                    ++HitCount;
+                    const double Delta = HitError - Mean;
+                    Mean += Delta / HitCount;
+                    M2 += Delta * (HitError - Mean);
+                }
+            }
+            while (Next < this->m_Targets.size())
+                Result.Objects[this->m_Targets[Next++].Index].Result = HitResult::Miss;
+
+            for (const auto& [Judged, HitError] : Result.Objects)
+            {
+                switch (Judged)
+                {
+                case HitResult::Great: ++Result.Count300;
+                    break;
+                case HitResult::Ok: ++Result.Count100;
+                    break;
+                case HitResult::Meh: ++Result.Count50;
+                    break;
+                case HitResult::Miss: ++Result.CountMiss;
+                    break;
+                default: break;
+                }
+            }
+            if (HitCount > 0)
+            {
+                const double ClockRate = GetClockRate(Mods);
+                Result.MeanOffset = Mean / ClockRate;
+                Result.UnstableRate = 10.0 * std::sqrt(M2 / HitCount) / ClockRate;
+            }
+            return Result;
+        }
+
+        [[nodiscard]] JudgementResult Judge(const Replay& Replay) const
+        {
+            return this->Judge(Replay.Actions, Replay.Mods);
+        }
+
+        [[nodiscard]] std::vector<JudgementResult> Judge(const std::vector<const Replay*>& Replays) const
+        {
+            std::vector<JudgementResult> Results;
+            Results.reserve(Replays.size());
+            for (const Replay* Replay : Replays)
+                Results.push_back(this->Judge(*Replay));
+            return Results;
+        }
+
+    private:
+        struct Target
+        {
+            std::int32_t Time;
+            float X, Y;
+            std::uint32_t Index; // into Beatmap::HitObjects.data
+            std::int32_t StackHeight;
+        };
+
+        std::vector<Target> m_Targets;
+        std::size_t m_ObjectCount = 0;
+        double m_OverallDifficulty = 0;
+        double m_CircleSize = 0;
+    };
+}
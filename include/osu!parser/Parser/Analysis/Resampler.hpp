@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "osu!parser/Parser/Replay.hpp"
+#include "osu!parser/Parser/Utilities.hpp"
+
+namespace OsuParser::Analysis::Resampler
+{
+    // Every sample is written as [X, Y, Keys]
+    static constexpr std::size_t CHANNELS = 3;
+
+    struct ResampleOptions
+    {
+        double Rate = 1000.0; // samples per second of map time
+        double StartTime = 0; // map time of the first sample
+        std::size_t SampleCount = 0; // 0 = up to the last frame of the longest replay
+        std::uint32_t Threads = 0; // 0 = hardware concurrency
+    };
+
+    // Number of samples needed to cover Actions from StartTime at Rate
+    inline std::size_t GetSampleCount(const std::vector<ReplayAction>& Actions, const double Rate,
+                                      const double StartTime = 0)
+    {
+        if (Actions.empty()) return 0;
+        const double Duration = static_cast<double>(Actions.back().Offset) - StartTime;
+        return Duration < 0 ? 0 : static_cast<std::size_t>(Duration * Rate / 1000.0) + 1;
+    }
+
+    /**
+     *  Writes SampleCount * CHANNELS floats to Output: cursor position linearly interpolated between the frames
+     *  around each sample time, keys held from the last frame at or before it. Samples before the first frame
+     *  take the first frame, samples after the last frame hold the last frame.
+     */
+    inline void Resample(const std::vector<ReplayAction>& Actions, const double Rate, const double StartTime,
+                         const std::size_t SampleCount, float* Output)
+    {
+        if (Actions.empty())
+        {
+            std::memset(Output, 0, SampleCount * CHANNELS * sizeof(float));
+            return;
+        }
+
+        const double Step = 1000.0 / Rate;
+        std::size_t Frame = 0; // last frame with Offset <= Time
+        for (std::size_t Sample = 0; Sample < SampleCount; Sample++, Output += CHANNELS)
+        {
+            const double Time = StartTime + static_cast<double>(Sample) * Step;
+            while (Frame + 1 < Actions.size() && static_cast<double>(Actions[Frame + 1].Offset) <= Time) ++Frame;
+
+            const ReplayAction& Current = Actions[Frame];
+            if (Frame + 1 < Actions.size() && static_cast<double>(Current.Offset) <= Time)
+            {
+                const ReplayAction& Next = Actions[Frame + 1];
+                const auto Progress = static_cast<float>(
+                    (Time - static_cast<double>(Current.Offset)) / static_cast<double>(Next.Offset - Current.Offset));
+                Output[0] = Current.X + (Next.X - Current.X) * Progress;
+                Output[1] = Current.Y + (Next.Y - Current.Y) * Progress;
+            }
+            else
+            {
+                Output[0] = Current.X;
+                Output[1] = Current.Y;
+            }
+            Output[2] = static_cast<float>(static_cast<double>(Current.Offset) <= Time ? Current.Keys : 0);
+        }
+    }
+
+    // Options.SampleCount, or enough samples to cover the longest replay when it is 0
+    inline std::size_t GetSampleCount(const std::vector<const Replay*>& Replays, const ResampleOptions& Options)
+    {
+        if (Options.SampleCount) return Options.SampleCount;
+        std::size_t SampleCount = 0;
+        for (const Replay* Replay : Replays)
+            SampleCount = std::max(SampleCount, GetSampleCount(Replay->Actions, Options.Rate, Options.StartTime));
+        return SampleCount;
+    }
+
+    /**
+     *  Resamples every replay into one contiguous [Replays][SampleCount][CHANNELS] buffer, in parallel.
+     *  Output must hold Replays.size() * GetSampleCount(Replays, Options) * CHANNELS floats.
+     */
+    inline void ResampleBatch(const std::vector<const Replay*>& Replays, const ResampleOptions& Options, float* Output)
+    {
+        const std::size_t SampleCount = GetSampleCount(Replays, Options);
+        Utilities::ParallelFor(Replays.size(), Options.Threads, [&](const std::size_t Index, std::uint32_t)
+        {
+            Resample(Replays[Index]->Actions, Options.Rate, Options.StartTime, SampleCount,
+                     Output + Index * SampleCount * CHANNELS);
+        });
+    }
+
+    /**
+     *  Writes a float32 array as an uncompressed NumPy .npy (format 1.0, C order).
+     *  Data is written in host byte order, which is little-endian on every platform osu! runs on.
+     */
+    inline bool WriteNpy(const std::string& Path, const float* Data, const std::vector<std::size_t>& Shape)
+    {
+        std::string ShapeString;
+        std::size_t Count = 1;
+        for (std::size_t i = 0; i < Shape.size(); i++)
+        {
+            if (i) ShapeString.append(", ");
+            ShapeString.append(std::to_string(Shape[i]));
+            Count *= Shape[i];
+        }
+        if (Shape.size() == 1) ShapeString.push_back(','); // 1-tuple
+        std::string Header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + ShapeString + "), }";
+
+        // magic (6) + version (2) + header length (2) + header, padded with spaces to 64 bytes and ended by '\n'
+        const std::size_t Unpadded = 10 + Header.size() + 1;
+        Header.append((64 - Unpadded % 64) % 64, ' ');
+        Header.push_back('\n');
+
+        std::ofstream Stream(Path, std::ios::binary);
+        if (!Stream.good()) return false;
+
+        const auto HeaderLength = static_cast<std::uint16_t>(Header.size());
+        const char Preamble[] = {
+            '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+            static_cast<char>(HeaderLength & 0xFF), static_cast<char>(HeaderLength >> 8)
+        };
+        Stream.write(Preamble, sizeof(Preamble));
+        Stream.write(Header.data(), static_cast<std::streamsize>(Header.size()));
+        Stream.write(reinterpret_cast<const char*>(Data), static_cast<std::streamsize>(Count * sizeof(float)));
+        return Stream.good();
+    }
+
+    // Resamples a batch of replays into a [Replays, SampleCount, CHANNELS] .npy file
+    inline bool ExportNpy(const std::string& Path, const std::vector<const Replay*>& Replays,
+                          const ResampleOptions& Options)
+    {
+        const std::size_t SampleCount = GetSampleCount(Replays, Options);
+        std::vector<float> Samples(Replays.size() * SampleCount * CHANNELS);
+        ResampleBatch(Replays, Options, Samples.data());
+        return WriteNpy(Path, Samples.data(), {Replays.size(), SampleCount, CHANNELS});
+    }
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSU_PARSER_SIMILARITY_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "osu!parser/Parser/Replay.hpp"
+#include "osu!parser/Parser/Utilities.hpp"
+#include "osu!parser/Parser/Analysis/Resampler.hpp"
+#include "osu!parser/Parser/Structures/Replay/Mods.hpp"
+
+namespace OsuParser::Analysis::Similarity
+{
+    static constexpr std::size_t SIGNATURE_SIZE = 64;
+    static constexpr float PLAYFIELD_HEIGHT = 384.0f;
+
+    struct SimilarityOptions
+    {
+        double Rate = 60.0; // cursor path sampling rate, samples per second
+        float CellSize = 32.0f; // quantization grid for fingerprints, in osu!pixels
+        std::uint32_t WindowSamples = 8; // samples one fingerprint token spans
+        std::uint32_t RowsPerBand = 2; // LSH banding: SIGNATURE_SIZE / RowsPerBand bands
+        std::int32_t MaxShift = 6; // alignment band, in samples either way
+        float Tolerance = 8.0f; // samples closer than this count as matching, in osu!pixels
+        double MaxMeanDistance = 12.0; // pairs at or below this are reported
+        bool NormalizeHardRock = true;
+        std::uint32_t Threads = 0; // 0 = hardware concurrency
+    };
+
+    struct Fingerprint
+    {
+        std::array<std::uint64_t, SIGNATURE_SIZE> Signature{}; // MinHash over time-windowed path tokens
+        std::vector<float> X; // resampled cursor path, structure of arrays for the alignment check
+        std::vector<float> Y;
+    };
+
+    struct SuspiciousPair
+    {
+        std::size_t First; // indices into the input replays, First < Second
+        std::size_t Second;
+        double MeanDistance; // mean cursor distance at the best shift, in osu!pixels
+        double Similarity; // fraction of samples within Tolerance at the best shift
+        std::int32_t Shift; // Second is Shift samples behind First
+    };
+
+    inline std::uint64_t Mix(std::uint64_t Value)
+    {
+        // splitmix64 finalizer
+        Value += 0x9E3779B97F4A7C15ull;
+        Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+        return Value ^ (Value >> 31);
+    }
+
+    inline Fingerprint MakeFingerprint(const Replay& Replay, const SimilarityOptions& Options = {})
+    {
+        Fingerprint Result;
+        Result.Signature.fill(std::numeric_limits<std::uint64_t>::max());
+
+        const std::size_t SampleCount = Resampler::GetSampleCount(Replay.Actions, Options.Rate);
+        std::vector<float> Samples(SampleCount * Resampler::CHANNELS);
+        Resampler::Resample(Replay.Actions, Options.Rate, 0, SampleCount, Samples.data());
+
+        const bool FlipY = Options.NormalizeHardRock && HasMod(Replay.Mods, Mod::HardRock);
+        Result.X.resize(SampleCount);
+        Result.Y.resize(SampleCount);
+        for (std::size_t i = 0; i < SampleCount; i++)
+        {
+            Result.X[i] = Samples[i * Resampler::CHANNELS];
+            Result.Y[i] = FlipY ? PLAYFIELD_HEIGHT - Samples[i * Resampler::CHANNELS + 1]
+                              : Samples[i * Resampler::CHANNELS + 1];
+        }
+
+        // A window starts at every sample and its token is the window's first cell plus its movement from there,
+        // never the start time, so a replay shifted by a few samples keeps nearly all its tokens. The first
+        // sample is binned into the two nearest cells per axis, so two samples less than half a cell apart always
+        // share a token however the grid falls between them; the movement is rounded to whole cells.
+        const std::size_t Window = std::max<std::uint32_t>(1, Options.WindowSamples);
+        for (std::size_t Start = 0; Start + Window <= SampleCount; Start++)
+        {
+            const std::size_t Last = Start + Window - 1;
+            const auto MoveX = static_cast<std::int64_t>(std::lround((Result.X[Last] - Result.X[Start])
+                                                                     / Options.CellSize));
+            const auto MoveY = static_cast<std::int64_t>(std::lround((Result.Y[Last] - Result.Y[Start])
+                                                                     / Options.CellSize));
+            const std::uint64_t Movement = Mix(static_cast<std::uint64_t>(MoveX * 83492791 ^ MoveY * 2654435761));
+
+            const auto CellX = static_cast<std::int64_t>(std::floor(Result.X[Start] / Options.CellSize - 0.5f));
+            const auto CellY = static_cast<std::int64_t>(std::floor(Result.Y[Start] / Options.CellSize - 0.5f));
+            for (std::int64_t Neighbour = 0; Neighbour < 4; Neighbour++)
+            {
+                const std::int64_t X = CellX + (Neighbour & 1), Y = CellY + (Neighbour >> 1);
+                const std::uint64_t Token = Mix(Movement ^ static_cast<std::uint64_t>(X * 73856093 ^ Y * 19349663));
+                for (std::size_t Hash = 0; Hash < SIGNATURE_SIZE; Hash++)
+                    Result.Signature[Hash] = std::min(Result.Signature[Hash],
+                                                      Mix(Token ^ (Hash * 0xD6E8FEB86659FD93ull)));
+            }
+        }
+        return Result;
+    }
+
+    /**
+     *  Mean cursor distance between two paths, minimised over time shifts in [-MaxShift, MaxShift].
+     *  Each shift is a straight SSE2 pass over the overlapping samples.
+     */
+    inline SuspiciousPair Align(const Fingerprint& First, const Fingerprint& Second, const SimilarityOptions& Options)
+    {
+        SuspiciousPair Best{0, 0, std::numeric_limits<double>::infinity(), 0, 0};
+        for (std::int32_t Shift = -Options.MaxShift; Shift <= Options.MaxShift; Shift++)
+        {
+            // First[i] against Second[i + Shift]
+            const std::size_t FirstBegin = Shift < 0 ? static_cast<std::size_t>(-Shift) : 0;
+            const std::size_t SecondBegin = Shift > 0 ? static_cast<std::size_t>(Shift) : 0;
+            if (FirstBegin >= First.X.size() || SecondBegin >= Second.X.size()) continue;
+            const std::size_t Count = std::min(First.X.size() - FirstBegin, Second.X.size() - SecondBegin);
+
+            const float* AX = First.X.data() + FirstBegin;
+            const float* AY = First.Y.data() + FirstBegin;
+            const float* BX = Second.X.data() + SecondBegin;
+            const float* BY = Second.Y.data() + SecondBegin;
+            double Distance = 0;
+            std::size_t Matching = 0;
+            std::size_t i = 0;
+
+#ifdef OSU_PARSER_SIMILARITY_SSE2
+            const __m128 Tolerance = _mm_set1_ps(Options.Tolerance);
+            const __m128 One = _mm_set1_ps(1.0f);
+            __m128 DistanceSum = _mm_setzero_ps(), MatchingSum = _mm_setzero_ps();
+            for (; i + 4 <= Count; i += 4)
+            {
+                const __m128 DeltaX = _mm_sub_ps(_mm_loadu_ps(AX + i), _mm_loadu_ps(BX + i));
+                const __m128 DeltaY = _mm_sub_ps(_mm_loadu_ps(AY + i), _mm_loadu_ps(BY + i));
+                const __m128 Length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(DeltaX, DeltaX), _mm_mul_ps(DeltaY, DeltaY)));
+                DistanceSum = _mm_add_ps(DistanceSum, Length);
+                MatchingSum = _mm_add_ps(MatchingSum, _mm_and_ps(_mm_cmple_ps(Length, Tolerance), One));
+            }
+            alignas(16) float Lanes[4];
+            _mm_store_ps(Lanes, DistanceSum);
+            Distance = static_cast<double>(Lanes[0]) + Lanes[1] + Lanes[2] + Lanes[3];
+            _mm_store_ps(Lanes, MatchingSum);
+            Matching = static_cast<std::size_t>(Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3]);
+#endif
+            for (; i < Count; i++)
+            {
+                const float Length = std::hypot(AX[i] - BX[i], AY[i] - BY[i]);
+                Distance += Length;
+                Matching += Length <= Options.Tolerance;
+            }
+
+            if (const double Mean = Distance / static_cast<double>(Count); Mean < Best.MeanDistance)
+            {
+                Best.MeanDistance = Mean;
+                Best.Similarity = static_cast<double>(Matching) / static_cast<double>(Count);
+                Best.Shift = Shift;
+            }
+        }
+        return Best;
+    }
+
+    /**
+     *  Flags near-duplicate replays.
+     *
+     *  Replays are grouped by BeatmapHash and fingerprinted; replays whose MinHash signatures collide in at least
+     *  one LSH band become candidates, and only candidates get the banded alignment check. Results are sorted by
+     *  MeanDistance, most similar first.
+     */
+    inline std::vector<SuspiciousPair> FindSimilar(const std::vector<const Replay*>& Replays,
+                                                   const SimilarityOptions& Options = {})
+    {
+        std::vector<Fingerprint> Fingerprints(Replays.size());
+        Utilities::ParallelFor(Replays.size(), Options.Threads, [&](const std::size_t Index, std::uint32_t)
+        {
+            Fingerprints[Index] = MakeFingerprint(*Replays[Index], Options);
+        });
+
+        std::unordered_map<std::string, std::vector<std::size_t>> Groups;
+        for (std::size_t i = 0; i < Replays.size(); i++)
+            Groups[Replays[i]->BeatmapHash].push_back(i);
+
+        const std::size_t Rows = std::clamp<std::size_t>(Options.RowsPerBand, 1, SIGNATURE_SIZE);
+        std::vector<std::pair<std::size_t, std::size_t>> Candidates;
+        std::unordered_set<std::uint64_t> Seen;
+        for (const auto& [BeatmapHash, Members] : Groups)
+        {
+            if (Members.size() < 2) continue;
+            for (std::size_t Band = 0; Band + Rows <= SIGNATURE_SIZE; Band += Rows)
+            {
+                std::unordered_map<std::uint64_t, std::vector<std::size_t>> Buckets;
+                for (const std::size_t Member : Members)
+                {
+                    std::uint64_t Key = Band;
+                    for (std::size_t Row = Band; Row < Band + Rows; Row++)
+                        Key = Mix(Key ^ Fingerprints[Member].Signature[Row]);
+                    Buckets[Key].push_back(Member);
+                }
+                for (const auto& [Key, Bucket] : Buckets)
+                    for (std::size_t A = 0; A < Bucket.size(); A++)
+                        for (std::size_t B = A + 1; B < Bucket.size(); B++)
+                        {
+                            const std::size_t First = std::min(Bucket[A], Bucket[B]);
+                            const std::size_t Second = std::max(Bucket[A], Bucket[B]);
+                            if (Seen.insert(static_cast<std::uint64_t>(First) << 32 | Second).second)
+                                Candidates.emplace_back(First, Second);
+                        }
+            }
+        }
+
+        std::vector<SuspiciousPair> Checked(Candidates.size());
+        Utilities::ParallelFor(Candidates.size(), Options.Threads, [&](const std::size_t Index, std::uint32_t)
+        {
+            const auto [First, Second] = Candidates[Index];
+            Checked[Index] = Align(Fingerprints[First], Fingerprints[Second], Options);
+            Checked[Index].First = First;
+            Checked[Index].Second = Second;
+        });
+
+        std::vector<SuspiciousPair> Result;
+        for (const SuspiciousPair& Pair : Checked)
+            if (Pair.MeanDistance <= Options.MaxMeanDistance) Result.push_back(Pair);
+        std::ranges::sort(Result, {}, &SuspiciousPair::MeanDistance);
+        return Result;
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "osu!parser/Parser/Beatmap.hpp"
+#include "SliderPath.hpp"
+
+namespace OsuParser::Analysis::SliderEvents
+{
+    static constexpr double BASE_SCORING_DISTANCE = 100.0;
+    static constexpr double LEGACY_LAST_TICK_OFFSET = 36.0; // ms before the end where stable judges the tail
+    static constexpr double MAX_TICK_LENGTH = 100000.0; // longer sliders only get ticks along this much
+
+    enum class SliderEventType : std::uint8_t
+    {
+        Head,
+        Tick,
+        Repeat,
+        LegacyLastTick, // where osu!stable judges the end; no combo of its own, the tail has it
+        Tail
+    };
+
+    struct SliderEvent
+    {
+        double Time = 0;
+        double PathProgress = 0; // 0 at the head, 1 at the end of the path; see SliderPath::Path::PositionAt
+        std::uint32_t Object = 0; // into HitObjects.data
+        std::uint32_t Span = 0; // slide the event is on
+        SliderEventType Type = SliderEventType::Head;
+    };
+
+    struct SliderEventList
+    {
+        std::vector<SliderEvent> Events; // of every slider, sorted by time
+        std::uint32_t MaxCombo = 0; // osu!standard: circles, spinners, and every slider event but LegacyLastTick
+        std::uint32_t Circles = 0;
+        std::uint32_t Sliders = 0;
+        std::uint32_t Spinners = 0;
+        std::uint32_t Ticks = 0;
+        std::uint32_t Repeats = 0;
+    };
+
+    /**
+     *  Appends the events of one slider, the way osu! places them: ticks every SliderTickRate-th of a beat along
+     *  each slide (none in the last 10 ms of one), a repeat at the end of every slide but the last, the legacy
+     *  last tick 36 ms before the end (or halfway, for short sliders) and the tail. Events of a slide that runs
+     *  backwards are still in time order.
+     */
+    inline void Generate(std::vector<SliderEvent>& Events, const std::uint32_t Object, const double StartTime,
+                         const double SpanDuration, const double Velocity, double TickDistance, const double Length,
+                         const std::int32_t Spans)
+    {
+        const double TickLength = std::min(MAX_TICK_LENGTH, Length);
+        TickDistance = std::clamp(TickDistance, 0.0, TickLength);
+        const double MinDistanceFromEnd = Velocity * 10;
+
+        Events.push_back({StartTime, 0, Object, 0, SliderEventType::Head});
+        for (std::int32_t Span = 0; Span < Spans; Span++)
+        {
+            const double SpanStart = StartTime + Span * SpanDuration;
+            const bool Reversed = Span % 2 == 1;
+            const auto SpanIndex = static_cast<std::uint32_t>(Span);
+            if (TickDistance > 0)
+            {
+                const std::size_t First = Events.size();
+                for (double Distance = TickDistance; Distance <= TickLength; Distance += TickDistance)
+                {
+                    if (Distance >= TickLength - MinDistanceFromEnd) break;
+                    const double Progress = Distance / TickLength;
+                    const double TimeProgress = Reversed ? 1 - Progress : Progress;
+                    Events.push_back({SpanStart + TimeProgress * SpanDuration, Progress, Object, SpanIndex,
+                                      SliderEventType::Tick});
+                }
+                if (Reversed) std::reverse(Events.begin() + static_cast<std::ptrdiff_t>(First), Events.end());
+            }
+            if (Span + 1 < Spans)
+                Events.push_back({SpanStart + SpanDuration, (Span + 1) % 2 ? 1.0 : 0.0, Object, SpanIndex,
+                                  SliderEventType::Repeat});
+        }
+
+        const double TotalDuration = Spans * SpanDuration;
+        const double FinalSpanEnd = StartTime + TotalDuration;
+        const auto LastSpan = static_cast<std::uint32_t>(std::max(Spans - 1, 0));
+        const double EndProgress = Spans % 2 ? 1.0 : 0.0;
+        const double LegacyLastTick = std::max(StartTime + TotalDuration / 2, FinalSpanEnd - LEGACY_LAST_TICK_OFFSET);
+
+        // where the ball is at the legacy last tick, on a last slide that runs backwards for even span counts
+        double LegacyProgress = EndProgress;
+        if (SpanDuration > 0)
+        {
+            const double FinalSpanStart = FinalSpanEnd - SpanDuration;
+            const double Progress = std::clamp((LegacyLastTick - FinalSpanStart) / SpanDuration, 0.0, 1.0);
+            LegacyProgress = Spans % 2 ? Progress : 1 - Progress;
+        }
+        Events.push_back({LegacyLastTick, LegacyProgress, Object, LastSpan, SliderEventType::LegacyLastTick});
+        Events.push_back({FinalSpanEnd, EndProgress, Object, LastSpan, SliderEventType::Tail});
+    }
+
+    /**
+     *  The nested events of every slider of a map in one pass over the objects, sorted by time, with object counts
+     *  and max combo. Beat length and slider velocity come from a cursor over the timing points, so the objects
+     *  should be sorted by time as HitObjects::Parse leaves them. FormatVersion is the .osu version: before v8
+     *  tick spacing did not follow slider velocity.
+     */
+    inline SliderEventList Generate(const Beatmap::Objects::HitObject::HitObjects& Objects,
+                                    const Beatmap::Sections::Difficulty::DifficultySection& Difficulty,
+                                    const Beatmap::Objects::TimingPoint::TimingPoints& TimingPoints,
+                                    const std::int32_t FormatVersion = 14)
+    {
+        SliderEventList Result;
+        const Beatmap::Objects::TimingPoint::Timeline Timeline(TimingPoints);
+        auto Cursor = Timeline.GetCursor();
+        Result.Events.reserve(Objects.data.size() * 3);
+
+        for (std::size_t i = 0; i < Objects.data.size(); i++)
+        {
+            const auto& Object = Objects.data[i];
+            if (!Object.SliderParameters)
+            {
+                Result.Circles += Object.type.HitCircle;
+                Result.Spinners += Object.type.Spinner;
+                Result.MaxCombo += 1;
+                continue;
+            }
+
+            const auto& Parameters = *Object.SliderParameters;
+            const auto& State = Cursor.Advance(Object.Time);
+            const double ScoringDistance = BASE_SCORING_DISTANCE * Difficulty.SliderMultiplier * State.SliderVelocity;
+            const double Velocity = State.BeatLength > 0 ? ScoringDistance / State.BeatLength : 0;
+            const double Length = Parameters.Length > 0 ? Parameters.Length
+                : SliderPath::Path::FromHitObject(Object).GetLength();
+            const double SpanDuration = Velocity > 0 ? Length / Velocity : 0;
+            double TickDistance = Difficulty.SliderTickRate > 0 && Velocity > 0
+                ? ScoringDistance / Difficulty.SliderTickRate : 0;
+            if (FormatVersion < 8) TickDistance /= State.SliderVelocity;
+            const std::int32_t Spans = std::max(Parameters.Slides, 1);
+
+            const std::size_t First = Result.Events.size();
+            Generate(Result.Events, static_cast<std::uint32_t>(i), Object.Time, SpanDuration, Velocity, TickDistance,
+                     Length, Spans);
+
+            ++Result.Sliders;
+            for (std::size_t Event = First; Event < Result.Events.size(); Event++)
+            {
+                const SliderEventType Type = Result.Events[Event].Type;
+                Result.Ticks += Type == SliderEventType::Tick;
+                Result.Repeats += Type == SliderEventType::Repeat;
+                Result.MaxCombo += Type != SliderEventType::LegacyLastTick;
+            }
+        }
+
+        // ticks near the end of a slide and later sliders can fall before earlier events
+        if (!std::ranges::is_sorted(Result.Events, {}, &SliderEvent::Time))
+            std::ranges::stable_sort(Result.Events, {}, &SliderEvent::Time);
+        return Result;
+    }
+
+    inline SliderEventList Generate(const Beatmap::Beatmap& Beatmap)
+    {
+        return Generate(Beatmap.HitObjects, Beatmap.Difficulty, Beatmap.TimingPoints, Beatmap.Version);
+    }
+}
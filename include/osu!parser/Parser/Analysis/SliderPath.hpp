@@ -0,0 +1,589 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "osu!parser/Parser/Beatmap.hpp"
+#include "osu!parser/Parser/Utilities.hpp"
+
+namespace OsuParser::Analysis::SliderPath
+{
+    using Beatmap::Objects::HitObject::Point;
+    using CurveType = Beatmap::Objects::HitObject::HitObject::SliderParams::Curve::Type;
+
+    static constexpr double BEZIER_TOLERANCE = 0.25;
+    static constexpr double CIRCULAR_ARC_TOLERANCE = 0.1;
+    static constexpr std::int32_t CATMULL_DETAIL = 50;
+
+    struct Vector2
+    {
+        double X = 0;
+        double Y = 0;
+
+        Vector2 operator+(const Vector2 Other) const { return {X + Other.X, Y + Other.Y}; }
+        Vector2 operator-(const Vector2 Other) const { return {X - Other.X, Y - Other.Y}; }
+        Vector2 operator*(const double Scale) const { return {X * Scale, Y * Scale}; }
+        bool operator==(const Vector2&) const = default;
+
+        [[nodiscard]] double Dot(const Vector2 Other) const { return X * Other.X + Y * Other.Y; }
+        [[nodiscard]] double LengthSquared() const { return X * X + Y * Y; }
+        [[nodiscard]] double Length() const { return std::sqrt(this->LengthSquared()); }
+    };
+
+    /**
+     *  The path a slider ball follows, as polyline vertices with their distance along the path.
+     *
+     *  Built the way osu! builds it: each curve type is flattened to line segments (Bezier by subdivision with
+     *  segments split at repeated control points, Catmull-Rom at 50 steps per segment, Perfect as a circular arc
+     *  through its three points, falling back to Bezier when those are collinear), then cut or extended along the
+     *  last segment to the slider's length. Positions are looked up by binary search in the distances.
+     *
+     *  Vertices are kept as separate X, Y and distance arrays, so interpolating a batch of positions is a plain
+     *  loop over arrays the compiler vectorizes.
+     */
+    class Path
+    {
+    public:
+        Path() = default;
+
+        // Start is the head of the slider, Points the curve points after it; a Length of 0 or less keeps the path
+        Path(const CurveType Type, const Point Start, const std::span<const Point> Points, const double Length)
+        {
+            std::vector<Vector2> Controls;
+            Controls.reserve(Points.size() + 1);
+            Controls.push_back({static_cast<double>(Start.x), static_cast<double>(Start.y)});
+            for (const Point& Control : Points)
+                Controls.push_back({static_cast<double>(Control.x), static_cast<double>(Control.y)});
+
+            std::vector<Vector2> Vertices;
+            Flatten(Type, Controls, Vertices);
+            // consecutive equal vertices add nothing to the path
+            Vertices.erase(std::unique(Vertices.begin(), Vertices.end()), Vertices.end());
+            // osu! does not extend a path whose last two control points are equal
+            const bool EndsOnRepeat = Controls.size() >= 2 && Controls.back() == Controls[Controls.size() - 2];
+            this->SetVertices(Vertices, Length, EndsOnRepeat);
+        }
+
+        // An empty path for anything that is not a slider with parameters
+        static Path FromHitObject(const Beatmap::Objects::HitObject::HitObject& Object)
+        {
+            if (!Object.SliderParameters) return {};
+            const auto& Parameters = *Object.SliderParameters;
+            return {Parameters.Curve.type, Object.Pos, Parameters.Curve.Points, Parameters.Length};
+        }
+
+        [[nodiscard]] double GetLength() const
+        {
+            return this->m_Distance.empty() ? 0 : this->m_Distance.back();
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Distance.size(); }
+        [[nodiscard]] bool empty() const { return this->m_Distance.empty(); }
+        [[nodiscard]] std::span<const double> GetX() const { return this->m_X; }
+        [[nodiscard]] std::span<const double> GetY() const { return this->m_Y; }
+        [[nodiscard]] std::span<const double> GetDistances() const { return this->m_Distance; }
+
+        [[nodiscard]] Vector2 GetVertex(const std::size_t Index) const
+        {
+            return {this->m_X[Index], this->m_Y[Index]};
+        }
+
+        // Position Distance along the path, clamped to its ends
+        [[nodiscard]] Vector2 PositionAtDistance(const double Distance) const
+        {
+            if (this->m_Distance.empty()) return {};
+            const std::size_t Index = this->FindSegment(Distance);
+            return this->Interpolate(Index, Distance);
+        }
+
+        // Position at Progress from 0 (head) to 1 (end of the path), for a single slide
+        [[nodiscard]] Vector2 PositionAt(const double Progress) const
+        {
+            return this->PositionAtDistance(std::clamp(Progress, 0.0, 1.0) * this->GetLength());
+        }
+
+        /**
+         *  Position of the ball at Progress from 0 to 1 through the whole slider, Slides times over the path: odd
+         *  slides run backwards.
+         */
+        [[nodiscard]] Vector2 BallPositionAt(const double Progress, const std::int32_t Slides) const
+        {
+            return this->PositionAt(GetSlideProgress(Progress, Slides));
+        }
+
+        static double GetSlideProgress(const double Progress, const std::int32_t Slides)
+        {
+            const double Spans = std::clamp(Progress, 0.0, 1.0) * std::max(Slides, 1);
+            const double Slide = std::fmod(Spans, 1.0);
+            return static_cast<std::int64_t>(Spans) % 2 == 1 ? 1 - Slide : Slide;
+        }
+
+        /**
+         *  Positions at every progress value of Progresses (0 to 1 of the path) into Output, which must be as large.
+         *  Ascending progress values are walked in one pass, others are binary searched.
+         */
+        void PositionsAt(const std::span<const double> Progresses, const std::span<Vector2> Output) const
+        {
+            const std::size_t Count = std::min(Progresses.size(), Output.size());
+            if (this->m_Distance.empty())
+            {
+                std::fill_n(Output.begin(), Count, Vector2{});
+                return;
+            }
+
+            std::vector<std::uint32_t> Segments(Count);
+            std::vector<double> Weights(Count);
+            const double Length = this->GetLength();
+            const bool Ascending = std::ranges::is_sorted(Progresses.first(Count));
+            std::size_t Segment = 0;
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                const double Distance = std::clamp(Progresses[i], 0.0, 1.0) * Length;
+                if (Ascending)
+                {
+                    while (Segment < this->m_Distance.size() && this->m_Distance[Segment] < Distance) ++Segment;
+                }
+                else Segment = this->FindSegment(Distance);
+                this->GetWeight(Segment, Distance, Segments[i], Weights[i]);
+            }
+
+            const double* X = this->m_X.data();
+            const double* Y = this->m_Y.data();
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                const std::uint32_t To = Segments[i];
+                const std::uint32_t From = To ? To - 1 : 0;
+                Output[i] = {X[From] + (X[To] - X[From]) * Weights[i], Y[From] + (Y[To] - Y[From]) * Weights[i]};
+            }
+        }
+
+        /**
+         *  Flattens the control points of one curve into Output, without cutting it to length. Bezier, Perfect with
+         *  anything but three points and unknown types split at repeated points; Linear keeps every point.
+         */
+        static void Flatten(const CurveType Type, const std::span<const Vector2> Controls,
+                            std::vector<Vector2>& Output)
+        {
+            if (Controls.empty()) return;
+            switch (Type)
+            {
+            case CurveType::LINEAR:
+                Output.insert(Output.end(), Controls.begin(), Controls.end());
+                return;
+            case CurveType::CATMULL:
+                FlattenCatmull(Controls, Output);
+                return;
+            case CurveType::PERFECT:
+                if (Controls.size() == 3 && FlattenCircularArc(Controls, Output)) return;
+                break;
+            default:
+                break;
+            }
+
+            // Bezier segments end at a repeated control point
+            std::size_t SegmentStart = 0;
+            for (std::size_t i = 0; i < Controls.size(); i++)
+            {
+                if (i + 1 != Controls.size() && Controls[i] != Controls[i + 1]) continue;
+                const std::span<const Vector2> Segment = Controls.subspan(SegmentStart, i + 1 - SegmentStart);
+                SegmentStart = i + 1;
+                if (Segment.size() == 1) Output.push_back(Segment.front());
+                else FlattenBezier(Segment, Output);
+            }
+        }
+
+    private:
+        void SetVertices(std::vector<Vector2>& Vertices, const double Length, const bool EndsOnRepeat)
+        {
+            std::vector<double> Distances;
+            Distances.reserve(Vertices.size());
+            double Calculated = 0;
+            if (!Vertices.empty()) Distances.push_back(0);
+            for (std::size_t i = 1; i < Vertices.size(); i++)
+            {
+                Calculated += (Vertices[i] - Vertices[i - 1]).Length();
+                Distances.push_back(Calculated);
+            }
+
+            // cut or extend along the last segment to the length from the file
+            if (Length > 0 && Calculated != Length && !(EndsOnRepeat && Length > Calculated) && Vertices.size() >= 2)
+            {
+                Distances.pop_back();
+                std::size_t End = Vertices.size() - 1;
+                if (Calculated > Length)
+                {
+                    while (!Distances.empty() && Distances.back() >= Length)
+                    {
+                        Distances.pop_back();
+                        Vertices.pop_back();
+                        --End;
+                    }
+                }
+                if (End == 0 || Distances.empty())
+                {
+                    Vertices.resize(1);
+                    Distances.assign(1, 0);
+                }
+                else
+                {
+                    const Vector2 Direction = Vertices[End] - Vertices[End - 1];
+                    const double DirectionLength = Direction.Length();
+                    const double Remaining = Length - Distances.back();
+                    Vertices[End] = DirectionLength > 0
+                        ? Vertices[End - 1] + Direction * (Remaining / DirectionLength) : Vertices[End - 1];
+                    Distances.push_back(Length);
+                }
+            }
+
+            this->m_X.resize(Vertices.size());
+            this->m_Y.resize(Vertices.size());
+            for (std::size_t i = 0; i < Vertices.size(); i++)
+            {
+                this->m_X[i] = Vertices[i].X;
+                this->m_Y[i] = Vertices[i].Y;
+            }
+            this->m_Distance = std::move(Distances);
+        }
+
+        // Index of the first vertex at or past Distance, size() past the end
+        [[nodiscard]] std::size_t FindSegment(const double Distance) const
+        {
+            return static_cast<std::size_t>(
+                std::ranges::lower_bound(this->m_Distance, Distance) - this->m_Distance.begin());
+        }
+
+        // The vertex to interpolate towards from the one before it, and how far
+        void GetWeight(const std::size_t Index, const double Distance, std::uint32_t& To, double& Weight) const
+        {
+            if (Index == 0 || Index >= this->m_Distance.size())
+            {
+                // before the head or past the end: the vertex there
+                To = static_cast<std::uint32_t>(Index == 0 ? 0 : this->m_Distance.size() - 1);
+                Weight = Index == 0 ? 0 : 1;
+                return;
+            }
+            To = static_cast<std::uint32_t>(Index);
+            const double From = this->m_Distance[Index - 1], Until = this->m_Distance[Index];
+            Weight = Until - From > 1e-9 ? (Distance - From) / (Until - From) : 0;
+        }
+
+        [[nodiscard]] Vector2 Interpolate(const std::size_t Index, const double Distance) const
+        {
+            std::uint32_t To;
+            double Weight;
+            this->GetWeight(Index, Distance, To, Weight);
+            const std::uint32_t From = To ? To - 1 : 0;
+            return {this->m_X[From] + (this->m_X[To] - this->m_X[From]) * Weight,
+                    this->m_Y[From] + (this->m_Y[To] - this->m_Y[From]) * Weight};
+        }
+
+        // De Casteljau at t = 0.5: Left gets the first half of the curve, Right the second
+        static void Subdivide(const std::span<const Vector2> Controls, std::vector<Vector2>& Left,
+                              std::vector<Vector2>& Right, std::vector<Vector2>& Midpoints)
+        {
+            const std::size_t Count = Controls.size();
+            Midpoints.assign(Controls.begin(), Controls.end());
+            Left.resize(Count);
+            Right.resize(Count);
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                Left[i] = Midpoints[0];
+                Right[Count - i - 1] = Midpoints[Count - i - 1];
+                for (std::size_t j = 0; j + 1 < Count - i; j++)
+                    Midpoints[j] = (Midpoints[j] + Midpoints[j + 1]) * 0.5;
+            }
+        }
+
+        static bool IsFlatEnough(const std::span<const Vector2> Controls)
+        {
+            for (std::size_t i = 1; i + 1 < Controls.size(); i++)
+            {
+                const Vector2 Bend = Controls[i - 1] - Controls[i] * 2 + Controls[i + 1];
+                if (Bend.LengthSquared() > BEZIER_TOLERANCE * BEZIER_TOLERANCE * 4) return false;
+            }
+            return true;
+        }
+
+        static void FlattenBezier(const std::span<const Vector2> Controls, std::vector<Vector2>& Output)
+        {
+            const std::size_t Count = Controls.size();
+            std::vector<std::vector<Vector2>> Pending;
+            std::vector<std::vector<Vector2>> Free;
+            std::vector<Vector2> Left, Right, Midpoints;
+            Pending.emplace_back(Controls.begin(), Controls.end());
+
+            while (!Pending.empty())
+            {
+                std::vector<Vector2> Parent = std::move(Pending.back());
+                Pending.pop_back();
+                if (IsFlatEnough(Parent))
+                {
+                    // the curve through the flattened control points, at every other subdivided point
+                    Subdivide(Parent, Left, Right, Midpoints);
+                    Left.resize(Count * 2 - 1);
+                    for (std::size_t i = 0; i + 1 < Count; i++) Left[Count + i] = Right[i + 1];
+                    Output.push_back(Parent[0]);
+                    for (std::size_t i = 1; i + 1 < Count; i++)
+                        Output.push_back((Left[2 * i - 1] + Left[2 * i] * 2 + Left[2 * i + 1]) * 0.25);
+                    Free.push_back(std::move(Parent));
+                    continue;
+                }
+
+                std::vector<Vector2> Second;
+                if (!Free.empty())
+                {
+                    Second = std::move(Free.back());
+                    Free.pop_back();
+                }
+                Subdivide(Parent, Left, Second, Midpoints);
+                Parent.assign(Left.begin(), Left.end());
+                Pending.push_back(std::move(Second));
+                Pending.push_back(std::move(Parent));
+            }
+            Output.push_back(Controls.back());
+        }
+
+        static Vector2 CatmullPoint(const Vector2 A, const Vector2 B, const Vector2 C, const Vector2 D, const double T)
+        {
+            const double T2 = T * T, T3 = T2 * T;
+            return {
+                0.5 * (2 * B.X + (-A.X + C.X) * T + (2 * A.X - 5 * B.X + 4 * C.X - D.X) * T2
+                    + (-A.X + 3 * B.X - 3 * C.X + D.X) * T3),
+                0.5 * (2 * B.Y + (-A.Y + C.Y) * T + (2 * A.Y - 5 * B.Y + 4 * C.Y - D.Y) * T2
+                    + (-A.Y + 3 * B.Y - 3 * C.Y + D.Y) * T3)
+            };
+        }
+
+        static void FlattenCatmull(const std::span<const Vector2> Controls, std::vector<Vector2>& Output)
+        {
+            const std::size_t Count = Controls.size();
+            if (Count == 1)
+            {
+                Output.push_back(Controls[0]);
+                return;
+            }
+            Output.reserve(Output.size() + (Count - 1) * CATMULL_DETAIL * 2);
+            for (std::size_t i = 0; i + 1 < Count; i++)
+            {
+                const Vector2 A = i > 0 ? Controls[i - 1] : Controls[i];
+                const Vector2 B = Controls[i];
+                const Vector2 C = i + 1 < Count ? Controls[i + 1] : B * 2 - A;
+                const Vector2 D = i + 2 < Count ? Controls[i + 2] : C * 2 - B;
+                for (std::int32_t Step = 0; Step < CATMULL_DETAIL; Step++)
+                {
+                    Output.push_back(CatmullPoint(A, B, C, D, static_cast<double>(Step) / CATMULL_DETAIL));
+                    Output.push_back(CatmullPoint(A, B, C, D, static_cast<double>(Step + 1) / CATMULL_DETAIL));
+                }
+            }
+        }
+
+        // False when the three points do not make a circle
+        static bool FlattenCircularArc(const std::span<const Vector2> Controls, std::vector<Vector2>& Output)
+        {
+            const Vector2 A = Controls[0], B = Controls[1], C = Controls[2];
+            const double ASquared = (B - C).LengthSquared();
+            const double BSquared = (A - C).LengthSquared();
+            const double CSquared = (A - B).LengthSquared();
+            if (ASquared < 1e-3 || BSquared < 1e-3 || CSquared < 1e-3) return false;
+
+            const double S = ASquared * (BSquared + CSquared - ASquared);
+            const double T = BSquared * (ASquared + CSquared - BSquared);
+            const double U = CSquared * (ASquared + BSquared - CSquared);
+            const double Sum = S + T + U;
+            if (std::abs(Sum) < 1e-3) return false;
+
+            const Vector2 Centre = (A * S + B * T + C * U) * (1 / Sum);
+            const Vector2 FromCentreA = A - Centre;
+            const Vector2 FromCentreC = C - Centre;
+            const double Radius = FromCentreA.Length();
+            const double ThetaStart = std::atan2(FromCentreA.Y, FromCentreA.X);
+            double ThetaEnd = std::atan2(FromCentreC.Y, FromCentreC.X);
+            while (ThetaEnd < ThetaStart) ThetaEnd += 2 * std::numbers::pi;
+
+            double Direction = 1;
+            double ThetaRange = ThetaEnd - ThetaStart;
+            // B on the other side of AC than the counter-clockwise arc: go the other way round
+            const Vector2 Normal{C.Y - A.Y, -(C.X - A.X)};
+            if (Normal.Dot(B - A) < 0)
+            {
+                Direction = -1;
+                ThetaRange = 2 * std::numbers::pi - ThetaRange;
+            }
+
+            const std::size_t Points = 2 * Radius <= CIRCULAR_ARC_TOLERANCE
+                ? 2
+                : std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(
+                    ThetaRange / (2 * std::acos(1 - CIRCULAR_ARC_TOLERANCE / Radius)))));
+            Output.reserve(Output.size() + Points);
+            for (std::size_t i = 0; i < Points; i++)
+            {
+                const double Theta = ThetaStart + Direction * static_cast<double>(i) / (Points - 1) * ThetaRange;
+                Output.push_back(Centre + Vector2{std::cos(Theta), std::sin(Theta)} * Radius);
+            }
+            return true;
+        }
+
+        std::vector<double> m_X;
+        std::vector<double> m_Y;
+        std::vector<double> m_Distance;
+    };
+
+    /**
+     *  The paths of every slider of a map, built on first use and kept. The curves are copied on construction,
+     *  so the hit objects can be released afterwards.
+     *
+     *  Get() builds and is not thread safe; after BuildAll() every path exists and Find() can be called from
+     *  any thread.
+     */
+    class SliderPaths
+    {
+    public:
+        explicit SliderPaths(const Beatmap::Objects::HitObject::HitObjects& Objects)
+        {
+            this->m_Sliders.reserve(Objects.data.size());
+            for (const auto& Object : Objects.data)
+            {
+                if (!Object.SliderParameters)
+                {
+                    this->AddObject(Object.Pos);
+                    continue;
+                }
+                const auto& Parameters = *Object.SliderParameters;
+                this->AddSlider(Parameters.Curve.type, Object.Pos, Parameters.Curve.Points, Parameters.Length,
+                                Parameters.Slides);
+            }
+            this->m_Paths.resize(this->m_Sliders.size());
+        }
+
+        explicit SliderPaths(const Beatmap::Objects::HitObject::PackedHitObjects& Objects)
+        {
+            this->m_Sliders.reserve(Objects.size());
+            for (const auto Object : Objects)
+            {
+                if (!Objects.GetSlider(Object.GetIndex()))
+                {
+                    this->AddObject(Object.GetPosition());
+                    continue;
+                }
+                this->AddSlider(Object.GetCurveType(), Object.GetPosition(), Object.GetCurvePoints(),
+                                Object.GetLength(), Object.GetSlides());
+            }
+            this->m_Paths.resize(this->m_Sliders.size());
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Sliders.size(); }
+
+        [[nodiscard]] bool IsSlider(const std::size_t Index) const
+        {
+            return this->m_Sliders[Index].IsSlider;
+        }
+
+        // The path of object Index, built now if it was not yet; nullptr for anything that is not a slider
+        const Path* Get(const std::size_t Index)
+        {
+            if (!this->m_Sliders[Index].IsSlider) return nullptr;
+            if (!this->m_Paths[Index]) this->Build(Index);
+            return &*this->m_Paths[Index];
+        }
+
+        // The path of object Index if it was built
+        [[nodiscard]] const Path* Find(const std::size_t Index) const
+        {
+            return this->m_Paths[Index] ? &*this->m_Paths[Index] : nullptr;
+        }
+
+        // Builds every path not built yet, on Threads threads (0 = hardware concurrency)
+        void BuildAll(const std::uint32_t Threads = 1)
+        {
+            std::vector<std::uint32_t> Missing;
+            for (std::size_t i = 0; i < this->m_Sliders.size(); i++)
+                if (this->m_Sliders[i].IsSlider && !this->m_Paths[i]) Missing.push_back(static_cast<std::uint32_t>(i));
+            if (Threads == 1)
+            {
+                for (const std::uint32_t Index : Missing) this->Build(Index);
+                return;
+            }
+            Utilities::ParallelFor(Missing.size(), Threads, [&](const std::size_t Index, std::uint32_t)
+            {
+                this->Build(Missing[Index]);
+            });
+        }
+
+        /**
+         *  Where every object ends: the ball position after the last slide for sliders, the object position for
+         *  everything else. Builds the paths it needs.
+         */
+        [[nodiscard]] std::vector<Vector2> GetEndPositions()
+        {
+            this->BuildAll();
+            std::vector<Vector2> Positions(this->m_Sliders.size());
+            for (std::size_t i = 0; i < this->m_Sliders.size(); i++)
+            {
+                const Slider& Object = this->m_Sliders[i];
+                Positions[i] = Object.IsSlider ? this->m_Paths[i]->BallPositionAt(1, Object.Slides) : Object.Start;
+            }
+            return Positions;
+        }
+
+        [[nodiscard]] std::int32_t GetSlides(const std::size_t Index) const
+        {
+            return this->m_Sliders[Index].Slides;
+        }
+
+        [[nodiscard]] Vector2 GetStart(const std::size_t Index) const
+        {
+            return this->m_Sliders[Index].Start;
+        }
+
+    private:
+        struct Slider
+        {
+            Vector2 Start;
+            Point Head{0, 0};
+            double Length = 0;
+            std::uint32_t FirstPoint = 0;
+            std::uint32_t PointCount = 0;
+            std::int32_t Slides = 1;
+            CurveType Type = CurveType::BEZIER;
+            bool IsSlider = false;
+        };
+
+        void AddObject(const Point Position)
+        {
+            Slider Object;
+            Object.Start = {static_cast<double>(Position.x), static_cast<double>(Position.y)};
+            Object.Head = Position;
+            this->m_Sliders.push_back(Object);
+        }
+
+        void AddSlider(const CurveType Type, const Point Head, const std::span<const Point> Points,
+                       const double Length, const std::int32_t Slides)
+        {
+            this->AddObject(Head);
+            Slider& Object = this->m_Sliders.back();
+            Object.IsSlider = true;
+            Object.Type = Type;
+            Object.Length = Length;
+            Object.Slides = Slides;
+            Object.FirstPoint = static_cast<std::uint32_t>(this->m_Points.size());
+            Object.PointCount = static_cast<std::uint32_t>(Points.size());
+            this->m_Points.insert(this->m_Points.end(), Points.begin(), Points.end());
+        }
+
+        void Build(const std::size_t Index)
+        {
+            const Slider& Object = this->m_Sliders[Index];
+            this->m_Paths[Index].emplace(Object.Type, Object.Head,
+                                         std::span(this->m_Points).subspan(Object.FirstPoint, Object.PointCount),
+                                         Object.Length);
+        }
+
+        std::vector<Slider> m_Sliders; // one per hit object
+        std::vector<Point> m_Points;
+        std::vector<std::optional<Path>> m_Paths;
+    };
+}
@@ -0,0 +1,367 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "osu!parser/Parser/Beatmap.hpp"
+#include "SliderPath.hpp"
+
+namespace OsuParser::Analysis::Stacking
+{
+    using SliderPath::Vector2;
+
+    static constexpr double STACK_DISTANCE = 3; // objects closer than this stack
+    static constexpr double STACK_OFFSET = -6.4; // per stack level at scale 1, on both axes
+    static constexpr std::int32_t STACKING_VERSION = 6; // maps before this use the original stacking pass
+
+    /**
+     *  Stack heights of every object of a map, from osu!standard's stacking pass: objects within 3 osu!pixels of
+     *  an earlier one, or of the end of an earlier slider, and within StackLeniency of the approach time after it,
+     *  are drawn shifted up and left by a few pixels per level, circles under a slider end down and right.
+     *
+     *  The pass walks the objects backwards like osu! does, but finds the previous object in range through a
+     *  spatial hash of object and slider end positions instead of checking every object in the time window, so a
+     *  long stream costs about the same per object as a sparse map. Maps before v6 use osu!'s original pass.
+     *
+     *  Slider end times come from HitObject::EndTime, which Beatmap fills in while loading; objects without one
+     *  end where they start.
+     */
+    class Stacks
+    {
+    public:
+        // Paths are those of Objects, built here if they were not yet
+        Stacks(const Beatmap::Objects::HitObject::HitObjects& Objects, SliderPath::SliderPaths& Paths,
+               const double StackLeniency, const double ApproachRate, const double CircleSize,
+               const std::int32_t FormatVersion = 14)
+        {
+            this->Compute(Objects, Paths, StackLeniency, ApproachRate, CircleSize, FormatVersion);
+        }
+
+        // Maps before v8 have no ApproachRate; osu! uses OverallDifficulty for it there
+        explicit Stacks(const Beatmap::Beatmap& Beatmap)
+        {
+            SliderPath::SliderPaths Paths(Beatmap.HitObjects);
+            const double ApproachRate = Beatmap.Version < 8 ? Beatmap.Difficulty.OverallDifficulty
+                : Beatmap.Difficulty.ApproachRate;
+            this->Compute(Beatmap.HitObjects, Paths, Beatmap.General.StackLeniency, ApproachRate,
+                          Beatmap.Difficulty.CircleSize, Beatmap.Version);
+        }
+
+        // How long before its time an object appears, in ms
+        [[nodiscard]] static double GetPreempt(const double ApproachRate)
+        {
+            if (ApproachRate > 5) return 1200 + (450 - 1200) * (ApproachRate - 5) / 5;
+            if (ApproachRate < 5) return 1200 + (1200 - 1800) * (ApproachRate - 5) / 5;
+            return 1200;
+        }
+
+        // Object size relative to CircleSize 5, with osu!'s allowance for playfield rounding
+        [[nodiscard]] static double GetScale(const double CircleSize)
+        {
+            return (1.0 - 0.7 * (CircleSize - 5) / 5) / 2 * 1.00041;
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Heights.size(); }
+
+        // Negative for circles stacked under a slider end
+        [[nodiscard]] std::int32_t GetHeight(const std::size_t Index) const { return this->m_Heights[Index]; }
+
+        [[nodiscard]] std::span<const std::int32_t> GetHeights() const { return this->m_Heights; }
+
+        [[nodiscard]] Vector2 GetOffset(const std::size_t Index) const
+        {
+            const double Offset = this->m_Heights[Index] * this->m_StackOffset;
+            return {Offset, Offset};
+        }
+
+        // Where object Index is drawn
+        [[nodiscard]] Vector2 GetPosition(const std::size_t Index) const
+        {
+            return this->m_Positions[Index] + this->GetOffset(Index);
+        }
+
+        // Where object Index ends once stacked: the ball position after the last slide for sliders
+        [[nodiscard]] Vector2 GetEndPosition(const std::size_t Index) const
+        {
+            return this->m_EndPositions[Index] + this->GetOffset(Index);
+        }
+
+    private:
+        enum class Kind : std::uint8_t
+        {
+            Circle,
+            Slider,
+            Spinner
+        };
+
+        /**
+         *  Indices of objects bucketed by the cell their position falls in, ascending within a cell. Cells are twice
+         *  STACK_DISTANCE wide, so everything near a point is in the two by two cells around it, and the latest
+         *  object near it before some index is a binary search in each. The cells cover the positions' bounds
+         *  within a margin around the playfield, as one array counting-sorted in a pass; positions further out
+         *  share the edge cells.
+         */
+        class Grid
+        {
+        public:
+            template <typename Include>
+            Grid(const std::span<const Vector2> Positions, Include&& Accept)
+            {
+                std::vector<std::pair<std::uint32_t, std::pair<std::int32_t, std::int32_t>>> Included;
+                Included.reserve(Positions.size());
+                for (std::size_t i = 0; i < Positions.size(); i++)
+                {
+                    if (!Accept(i)) continue;
+                    const std::int32_t X = Cell(Positions[i].X, MIN_X, MAX_X);
+                    const std::int32_t Y = Cell(Positions[i].Y, MIN_Y, MAX_Y);
+                    Included.push_back({static_cast<std::uint32_t>(i), {X, Y}});
+                    this->m_Left = std::min(this->m_Left, X);
+                    this->m_Right = std::max(this->m_Right, X);
+                    this->m_Top = std::min(this->m_Top, Y);
+                    this->m_Bottom = std::max(this->m_Bottom, Y);
+                }
+                if (Included.empty()) return;
+
+                this->m_Width = this->m_Right - this->m_Left + 1;
+                const auto Cells = static_cast<std::size_t>(this->m_Width) * (this->m_Bottom - this->m_Top + 1);
+                this->m_Starts.assign(Cells + 1, 0);
+                for (const auto& [Index, Cell] : Included)
+                    this->m_Starts[this->CellIndex(Cell.first, Cell.second) + 1]++;
+                for (std::size_t i = 0; i < Cells; i++) this->m_Starts[i + 1] += this->m_Starts[i];
+                std::vector<std::uint32_t> Next(this->m_Starts.begin(), this->m_Starts.end() - 1);
+                this->m_Indices.resize(Included.size());
+                for (const auto& [Index, Cell] : Included)
+                    this->m_Indices[Next[this->CellIndex(Cell.first, Cell.second)]++] = Index;
+            }
+
+            // The largest index in [Low, High) closer than STACK_DISTANCE to Center that Accept takes, or -1
+            template <typename Filter>
+            [[nodiscard]] std::int64_t FindLast(const std::span<const Vector2> Positions, const Vector2 Center,
+                                                const std::int64_t Low, const std::int64_t High,
+                                                Filter&& Accept) const
+            {
+                std::int64_t Found = -1;
+                this->VisitCells(Center, [&](const std::uint32_t* Begin, const std::uint32_t* End)
+                {
+                    const std::uint32_t* Cursor = std::lower_bound(Begin, End, High,
+                        [](const std::uint32_t Index, const std::int64_t Value) { return Index < Value; });
+                    while (Cursor != Begin)
+                    {
+                        const std::int64_t Index = *--Cursor;
+                        if (Index < Low || Index <= Found) break;
+                        if (IsNear(Positions[Index], Center) && Accept(Index))
+                        {
+                            Found = Index;
+                            break;
+                        }
+                    }
+                });
+                return Found;
+            }
+
+            // Calls Visit with every index in [Low, High) closer than STACK_DISTANCE to Center
+            template <typename Callback>
+            void ForEach(const std::span<const Vector2> Positions, const Vector2 Center, const std::int64_t Low,
+                         const std::int64_t High, Callback&& Visit) const
+            {
+                this->VisitCells(Center, [&](const std::uint32_t* Begin, const std::uint32_t* End)
+                {
+                    for (const std::uint32_t* Cursor = std::lower_bound(Begin, End, Low,
+                             [](const std::uint32_t Index, const std::int64_t Value) { return Index < Value; });
+                         Cursor != End && *Cursor < High; ++Cursor)
+                        if (IsNear(Positions[*Cursor], Center)) Visit(*Cursor);
+                });
+            }
+
+            static bool IsNear(const Vector2 A, const Vector2 B)
+            {
+                return (A - B).LengthSquared() < STACK_DISTANCE * STACK_DISTANCE;
+            }
+
+        private:
+            static constexpr double CELL_SIZE = STACK_DISTANCE * 2;
+            // a playfield's width and height on every side of it
+            static constexpr std::int32_t MIN_X = -512 / 6, MAX_X = 1024 / 6;
+            static constexpr std::int32_t MIN_Y = -384 / 6, MAX_Y = 768 / 6;
+
+            static std::int32_t Cell(const double Value, const std::int32_t Min, const std::int32_t Max)
+            {
+                const double Cell = std::floor(Value * (1 / CELL_SIZE));
+                return Cell < Min ? Min : Cell > Max ? Max : static_cast<std::int32_t>(Cell);
+            }
+
+            [[nodiscard]] std::size_t CellIndex(const std::int32_t X, const std::int32_t Y) const
+            {
+                return static_cast<std::size_t>(Y - this->m_Top) * this->m_Width + (X - this->m_Left);
+            }
+
+            template <typename Callback>
+            void VisitCells(const Vector2 Center, Callback&& Visit) const
+            {
+                if (this->m_Indices.empty()) return;
+                // clamped like the positions were, then to the cells there are
+                const std::int32_t Left = std::max(Cell(Center.X - STACK_DISTANCE, MIN_X, MAX_X), this->m_Left);
+                const std::int32_t Right = std::min(Cell(Center.X + STACK_DISTANCE, MIN_X, MAX_X), this->m_Right);
+                const std::int32_t Top = std::max(Cell(Center.Y - STACK_DISTANCE, MIN_Y, MAX_Y), this->m_Top);
+                const std::int32_t Bottom = std::min(Cell(Center.Y + STACK_DISTANCE, MIN_Y, MAX_Y), this->m_Bottom);
+                for (std::int32_t Row = Top; Row <= Bottom; Row++)
+                {
+                    for (std::int32_t Column = Left; Column <= Right; Column++)
+                    {
+                        const std::size_t Index = this->CellIndex(Column, Row);
+                        Visit(this->m_Indices.data() + this->m_Starts[Index],
+                              this->m_Indices.data() + this->m_Starts[Index + 1]);
+                    }
+                }
+            }
+
+            std::int32_t m_Left = MAX_X, m_Right = MIN_X, m_Top = MAX_Y, m_Bottom = MIN_Y, m_Width = 0;
+            std::vector<std::uint32_t> m_Starts; // of each cell in m_Indices, row by row, and the end
+            std::vector<std::uint32_t> m_Indices;
+        };
+
+        void Compute(const Beatmap::Objects::HitObject::HitObjects& Objects, SliderPath::SliderPaths& Paths,
+                     const double StackLeniency, const double ApproachRate, const double CircleSize,
+                     const std::int32_t FormatVersion)
+        {
+            const std::size_t Count = Objects.data.size();
+            this->m_Heights.assign(Count, 0);
+            this->m_Positions.resize(Count);
+            this->m_Times.resize(Count);
+            this->m_EndTimes.resize(Count);
+            this->m_Kinds.resize(Count);
+            this->m_EndPositions = Paths.GetEndPositions();
+            this->m_Threshold = GetPreempt(ApproachRate) * StackLeniency;
+            this->m_StackOffset = GetScale(CircleSize) * STACK_OFFSET;
+
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                const auto& Object = Objects.data[i];
+                this->m_Positions[i] = {static_cast<double>(Object.Pos.x), static_cast<double>(Object.Pos.y)};
+                this->m_Times[i] = Object.Time;
+                this->m_EndTimes[i] = std::max(Object.EndTime.value_or(Object.Time), this->m_Times[i]);
+                this->m_Kinds[i] = Object.type.Spinner ? Kind::Spinner
+                    : Object.SliderParameters ? Kind::Slider : Kind::Circle;
+            }
+
+            if (FormatVersion >= STACKING_VERSION) this->ApplyStacking();
+            else this->ApplyStackingOld(Paths);
+        }
+
+        // The first object that starts within stacking range before the object at Index
+        [[nodiscard]] std::int64_t FindFirstInRange(const std::int64_t Index) const
+        {
+            const double Time = this->m_Times[Index];
+            return std::partition_point(this->m_Times.begin(), this->m_Times.begin() + Index,
+                [&](const double Start) { return Time - Start > this->m_Threshold; }) - this->m_Times.begin();
+        }
+
+        // The latest object before Index that ends too long before the object at Index to stack under it, or -1
+        [[nodiscard]] std::int64_t FindOutOfRange(const std::int64_t Index) const
+        {
+            const double Time = this->m_Times[Index];
+            // objects are sorted by start, so everything that starts in range also ends in range
+            std::int64_t Before = this->FindFirstInRange(Index);
+            while (--Before >= 0)
+            {
+                if (this->m_Kinds[Before] != Kind::Spinner && Time - this->m_EndTimes[Before] > this->m_Threshold)
+                    return Before;
+            }
+            return -1;
+        }
+
+        void ApplyStacking()
+        {
+            const auto Count = static_cast<std::int64_t>(this->m_Heights.size());
+            const std::span<const Vector2> Positions = this->m_Positions;
+            const std::span<const Vector2> EndPositions = this->m_EndPositions;
+            const auto NotSpinner = [&](const std::int64_t Index) { return this->m_Kinds[Index] != Kind::Spinner; };
+            const auto IsSlider = [&](const std::int64_t Index) { return this->m_Kinds[Index] == Kind::Slider; };
+            const Grid Heads(Positions, [](std::size_t) { return true; });
+            const Grid Ends(EndPositions, NotSpinner);
+
+            for (std::int64_t i = Count - 1; i > 0; i--)
+            {
+                if (this->m_Heights[i] != 0 || this->m_Kinds[i] == Kind::Spinner) continue;
+                std::int64_t Current = i;
+
+                if (this->m_Kinds[i] == Kind::Circle)
+                {
+                    // a stack of circles, possibly under the end of the last slider before them
+                    while (true)
+                    {
+                        const std::int64_t Low = this->FindOutOfRange(Current) + 1;
+                        const Vector2 Position = Positions[Current];
+                        const std::int64_t Head = Heads.FindLast(Positions, Position, Low, Current, NotSpinner);
+                        const std::int64_t Tail = Ends.FindLast(EndPositions, Position, std::max(Low, Head), Current,
+                                                                IsSlider);
+                        if (Tail >= 0)
+                        {
+                            // circles under a slider end move down and right of it instead
+                            const std::int32_t Offset = this->m_Heights[Current] - this->m_Heights[Tail] + 1;
+                            Heads.ForEach(Positions, EndPositions[Tail], Tail + 1, i + 1,
+                                          [&](const std::uint32_t Index) { this->m_Heights[Index] -= Offset; });
+                            break;
+                        }
+                        if (Head < 0) break;
+                        this->m_Heights[Head] = this->m_Heights[Current] + 1;
+                        Current = Head;
+                    }
+                    continue;
+                }
+
+                // the first slider of a stack: everything ending on it stacks up from here
+                while (true)
+                {
+                    const std::int64_t Below = Ends.FindLast(EndPositions, Positions[Current],
+                                                             this->FindFirstInRange(Current), Current, NotSpinner);
+                    if (Below < 0) break;
+                    this->m_Heights[Below] = this->m_Heights[Current] + 1;
+                    Current = Below;
+                }
+            }
+        }
+
+        // osu!'s pass for maps before v6, which looks forward from each object
+        void ApplyStackingOld(SliderPath::SliderPaths& Paths)
+        {
+            const std::size_t Count = this->m_Heights.size();
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                if (this->m_Heights[i] != 0 && this->m_Kinds[i] != Kind::Slider) continue;
+
+                double EndTime = this->m_EndTimes[i];
+                std::int32_t SliderStack = 0;
+                // the end of the path rather than of the last slide, as osu! did then
+                const SliderPath::Path* Path = this->m_Kinds[i] == Kind::Slider ? Paths.Get(i) : nullptr;
+                const Vector2 PathEnd = Path ? Path->PositionAt(1) : this->m_Positions[i];
+                for (std::size_t j = i + 1; j < Count; j++)
+                {
+                    if (this->m_Times[j] - this->m_Threshold > EndTime) break;
+                    if (Grid::IsNear(this->m_Positions[j], this->m_Positions[i]))
+                    {
+                        this->m_Heights[i]++;
+                        EndTime = this->m_Times[j];
+                    }
+                    else if (Grid::IsNear(this->m_Positions[j], PathEnd))
+                    {
+                        this->m_Heights[j] -= ++SliderStack;
+                        EndTime = this->m_Times[j];
+                    }
+                }
+            }
+        }
+
+        std::vector<std::int32_t> m_Heights;
+        std::vector<Vector2> m_Positions; // unstacked
+        std::vector<Vector2> m_EndPositions; // unstacked
+        std::vector<double> m_Times;
+        std::vector<double> m_EndTimes;
+        std::vector<Kind> m_Kinds;
+        double m_Threshold = 0; // ms within which objects stack
+        double m_StackOffset = 0; // per level
+    };
+}
@@ -0,0 +1,791 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "osu!parser/Parser/Beatmap.hpp"
+#include "osu!parser/Parser/ThreadPool.hpp"
+#include "osu!parser/Parser/Structures/Replay/Mods.hpp"
+#include "SliderEvents.hpp"
+#include "SliderPath.hpp"
+#include "Stacking.hpp"
+
+namespace OsuParser::Analysis::StarRating
+{
+    using SliderPath::Vector2;
+
+    static constexpr double OBJECT_RADIUS = 64; // at scale 1
+    static constexpr double NORMALISED_RADIUS = 50; // distances are scaled as if every map had circles this size
+    static constexpr double MIN_DELTA_TIME = 25;
+    static constexpr double MAXIMUM_SLIDER_RADIUS = NORMALISED_RADIUS * 2.4;
+    static constexpr double ASSUMED_SLIDER_RADIUS = NORMALISED_RADIUS * 1.8;
+    static constexpr double SECTION_LENGTH = 400; // ms of strain that make one peak
+    static constexpr double DECAY_WEIGHT = 0.9;
+    static constexpr double DIFFICULTY_MULTIPLIER = 0.0675;
+    static constexpr double PERFORMANCE_BASE_MULTIPLIER = 1.14;
+
+    struct DifficultyAttributes
+    {
+        std::uint32_t Mods = 0;
+        double StarRating = 0;
+        double AimDifficulty = 0;
+        double SpeedDifficulty = 0;
+        double SpeedNoteCount = 0; // how many objects are about as hard to tap as the hardest one
+        double SliderFactor = 1; // aim without slider travel over aim with it
+        double ApproachRate = 0; // with mods, and as it plays under their clock rate
+        double OverallDifficulty = 0; // same
+        double DrainRate = 0;
+        std::uint32_t MaxCombo = 0;
+        std::uint32_t HitCircleCount = 0;
+        std::uint32_t SliderCount = 0;
+        std::uint32_t SpinnerCount = 0;
+        std::string Error; // set when a batch could not rate the map, e.g. out of memory; the rest is then 0
+    };
+
+    enum class ObjectKind : std::uint8_t
+    {
+        Circle,
+        Slider,
+        Spinner
+    };
+
+    /**
+     *  The difficulty objects of a map under one set of mods, one array per property: entry i describes object
+     *  i + 1 of the map and the movement to it from the objects before. Times are in the mods' clock, distances
+     *  scaled to NORMALISED_RADIUS. Angle is NaN where there is none.
+     */
+    struct DifficultyObjects
+    {
+        std::vector<ObjectKind> Kind;
+        std::vector<double> StartTime;
+        std::vector<double> DeltaTime;
+        std::vector<double> StrainTime; // DeltaTime, at least MIN_DELTA_TIME
+        std::vector<double> LazyJumpDistance;
+        std::vector<double> MinimumJumpDistance;
+        std::vector<double> MinimumJumpTime;
+        std::vector<double> TravelDistance; // along the slider, 0 for anything else
+        std::vector<double> TravelTime;
+        std::vector<double> Angle;
+        double HitWindowGreat = 0; // the whole 300 window, for circles and sliders
+
+        [[nodiscard]] std::size_t size() const { return this->StartTime.size(); }
+
+        void resize(const std::size_t Count)
+        {
+            this->Kind.resize(Count);
+            for (std::vector<double>* Values : {&this->StartTime, &this->DeltaTime, &this->StrainTime,
+                                                &this->LazyJumpDistance, &this->MinimumJumpDistance,
+                                                &this->MinimumJumpTime, &this->TravelDistance, &this->TravelTime})
+                Values->assign(Count, 0);
+            this->Angle.assign(Count, std::numeric_limits<double>::quiet_NaN());
+        }
+
+        [[nodiscard]] double GetHitWindowGreat(const std::size_t Index) const
+        {
+            return this->Kind[Index] == ObjectKind::Spinner ? 0 : this->HitWindowGreat;
+        }
+    };
+
+    namespace Evaluators
+    {
+        static constexpr double WIDE_ANGLE_MULTIPLIER = 1.5;
+        static constexpr double ACUTE_ANGLE_MULTIPLIER = 1.95;
+        static constexpr double SLIDER_MULTIPLIER = 1.35;
+        static constexpr double VELOCITY_CHANGE_MULTIPLIER = 0.75;
+        static constexpr double SINGLE_SPACING_THRESHOLD = 125;
+        static constexpr double MIN_SPEED_BONUS = 75; // about 200 BPM 1/4
+        static constexpr double SPEED_BALANCING_FACTOR = 40;
+        static constexpr double HISTORY_TIME_MAX = 5000;
+        static constexpr double RHYTHM_MULTIPLIER = 0.75;
+
+        inline double GetWideAngleBonus(const double Angle)
+        {
+            constexpr double Pi = std::numbers::pi;
+            return std::pow(std::sin(3.0 / 4 * (std::min(5.0 / 6 * Pi, std::max(Pi / 6, Angle)) - Pi / 6)), 2);
+        }
+
+        inline double GetAcuteAngleBonus(const double Angle)
+        {
+            return 1 - GetWideAngleBonus(Angle);
+        }
+
+        /**
+         *  Aim strain of object Index: its velocity, with bonuses for wide and acute angles repeated less than
+         *  they change, for changes in velocity, and for slider travel when WithSliders.
+         */
+        inline double EvaluateAim(const DifficultyObjects& Objects, const std::size_t Index, const bool WithSliders)
+        {
+            if (Index <= 1 || Objects.Kind[Index] == ObjectKind::Spinner
+                || Objects.Kind[Index - 1] == ObjectKind::Spinner)
+                return 0;
+            const std::size_t Last = Index - 1;
+            const std::size_t LastLast = Index - 2;
+            const bool LastIsSlider = Objects.Kind[Last] == ObjectKind::Slider;
+            const bool LastLastIsSlider = Objects.Kind[LastLast] == ObjectKind::Slider;
+
+            // the jump from the last object, or through the last slider and from its end, whichever is faster
+            double CurrentVelocity = Objects.LazyJumpDistance[Index] / Objects.StrainTime[Index];
+            if (LastIsSlider && WithSliders)
+            {
+                const double TravelVelocity = Objects.TravelDistance[Last] / Objects.TravelTime[Last];
+                const double MovementVelocity = Objects.MinimumJumpDistance[Index] / Objects.MinimumJumpTime[Index];
+                CurrentVelocity = std::max(CurrentVelocity, MovementVelocity + TravelVelocity);
+            }
+            double PreviousVelocity = Objects.LazyJumpDistance[Last] / Objects.StrainTime[Last];
+            if (LastLastIsSlider && WithSliders)
+            {
+                const double TravelVelocity = Objects.TravelDistance[LastLast] / Objects.TravelTime[LastLast];
+                const double MovementVelocity = Objects.MinimumJumpDistance[Last] / Objects.MinimumJumpTime[Last];
+                PreviousVelocity = std::max(PreviousVelocity, MovementVelocity + TravelVelocity);
+            }
+
+            double WideAngleBonus = 0;
+            double AcuteAngleBonus = 0;
+            double VelocityChangeBonus = 0;
+            double Strain = CurrentVelocity;
+
+            const double StrainTime = Objects.StrainTime[Index];
+            const double LastStrainTime = Objects.StrainTime[Last];
+            const bool SameRhythm = std::max(StrainTime, LastStrainTime) < 1.25 * std::min(StrainTime, LastStrainTime);
+            if (SameRhythm && !std::isnan(Objects.Angle[Index]) && !std::isnan(Objects.Angle[Last])
+                && !std::isnan(Objects.Angle[LastLast]))
+            {
+                const double Angle = Objects.Angle[Index];
+                const double LastAngle = Objects.Angle[Last];
+                const double LastLastAngle = Objects.Angle[LastLast];
+                const double AngleBonus = std::min(CurrentVelocity, PreviousVelocity);
+
+                WideAngleBonus = GetWideAngleBonus(Angle);
+                AcuteAngleBonus = GetAcuteAngleBonus(Angle);
+                // acute angles only count past 300 BPM 1/2, as a wiggle, over at least a radius of distance
+                if (StrainTime > 100) AcuteAngleBonus = 0;
+                else
+                {
+                    const double Distance = std::clamp(Objects.LazyJumpDistance[Index], 50.0, 100.0);
+                    AcuteAngleBonus *= GetAcuteAngleBonus(LastAngle) * std::min(AngleBonus, 125 / StrainTime)
+                        * std::pow(std::sin(std::numbers::pi / 2 * std::min(1.0, (100 - StrainTime) / 25)), 2)
+                        * std::pow(std::sin(std::numbers::pi / 2 * (Distance - 50) / 50), 2);
+                }
+
+                // repeated angles are easier
+                WideAngleBonus *= AngleBonus
+                    * (1 - std::min(WideAngleBonus, std::pow(GetWideAngleBonus(LastAngle), 3)));
+                AcuteAngleBonus *= 0.5 + 0.5 * (1 - std::min(AcuteAngleBonus,
+                                                             std::pow(GetAcuteAngleBonus(LastLastAngle), 3)));
+            }
+
+            if (std::max(PreviousVelocity, CurrentVelocity) != 0)
+            {
+                // over the whole object this time, slider and jump together
+                PreviousVelocity = (Objects.LazyJumpDistance[Last] + Objects.TravelDistance[LastLast]) / LastStrainTime;
+                CurrentVelocity = (Objects.LazyJumpDistance[Index] + Objects.TravelDistance[Last]) / StrainTime;
+
+                // both can be 0 now, when only the slider ends were apart
+                const double Change = std::abs(PreviousVelocity - CurrentVelocity);
+                const double MaxVelocity = std::max(PreviousVelocity, CurrentVelocity);
+                const double DistanceRatio = MaxVelocity > 0
+                    ? std::pow(std::sin(std::numbers::pi / 2 * Change / MaxVelocity), 2) : 0;
+                const double OverlapVelocityBuff = std::min(125 / std::min(StrainTime, LastStrainTime), Change);
+                VelocityChangeBonus = OverlapVelocityBuff * DistanceRatio
+                    * std::pow(std::min(StrainTime, LastStrainTime) / std::max(StrainTime, LastStrainTime), 2);
+            }
+
+            Strain += std::max(AcuteAngleBonus * ACUTE_ANGLE_MULTIPLIER,
+                               WideAngleBonus * WIDE_ANGLE_MULTIPLIER
+                               + VelocityChangeBonus * VELOCITY_CHANGE_MULTIPLIER);
+            if (LastIsSlider && WithSliders)
+                Strain += Objects.TravelDistance[Last] / Objects.TravelTime[Last] * SLIDER_MULTIPLIER;
+            return Strain;
+        }
+
+        /**
+         *  Speed strain of object Index: faster than 200 BPM 1/4 is worth more, capped at the 300 window, with
+         *  spacing up to SINGLE_SPACING_THRESHOLD adding to it and doubles that can be double-tapped nerfed.
+         */
+        inline double EvaluateSpeed(const DifficultyObjects& Objects, const std::size_t Index)
+        {
+            if (Objects.Kind[Index] == ObjectKind::Spinner) return 0;
+
+            const double HitWindowGreat = Objects.GetHitWindowGreat(Index);
+            double StrainTime = Objects.StrainTime[Index];
+            double Doubletapness = 1;
+            if (Index + 1 < Objects.size())
+            {
+                const double DeltaTime = std::max(1.0, Objects.DeltaTime[Index]);
+                const double NextDeltaTime = std::max(1.0, Objects.DeltaTime[Index + 1]);
+                const double SpeedRatio = DeltaTime / std::max(DeltaTime, std::abs(NextDeltaTime - DeltaTime));
+                const double WindowRatio = std::pow(std::min(1.0, DeltaTime / HitWindowGreat), 2);
+                Doubletapness = std::pow(SpeedRatio, 1 - WindowRatio);
+            }
+
+            // 0.93 keeps 260 BPM OD8 streams from being nerfed harshly, 0.92 limits the cap
+            StrainTime /= std::clamp(StrainTime / HitWindowGreat / 0.93, 0.92, 1.0);
+
+            double SpeedBonus = 1;
+            if (StrainTime < MIN_SPEED_BONUS)
+                SpeedBonus = 1 + 0.75 * std::pow((MIN_SPEED_BONUS - StrainTime) / SPEED_BALANCING_FACTOR, 2);
+
+            const double TravelDistance = Index ? Objects.TravelDistance[Index - 1] : 0;
+            const double Distance = std::min(SINGLE_SPACING_THRESHOLD,
+                                             TravelDistance + Objects.MinimumJumpDistance[Index]);
+            return (SpeedBonus + SpeedBonus * std::pow(Distance / SINGLE_SPACING_THRESHOLD, 3.5)) * Doubletapness
+                / StrainTime;
+        }
+
+        /**
+         *  Rhythm complexity before object Index, as a multiplier from 1 up: changes between runs ("islands") of
+         *  evenly spaced objects within the last 5 seconds or 32 objects, less when the runs repeat.
+         */
+        inline double EvaluateRhythm(const DifficultyObjects& Objects, const std::size_t Index)
+        {
+            if (Objects.Kind[Index] == ObjectKind::Spinner) return 0;
+
+            std::int32_t PreviousIslandSize = 0;
+            std::int32_t IslandSize = 1;
+            double RhythmComplexitySum = 0;
+            double StartRatio = 0; // of the start of the current island, to buff tighter rhythms
+            bool FirstDeltaSwitch = false;
+
+            const auto HistoricalNoteCount = static_cast<std::int32_t>(std::min<std::size_t>(Index, 32));
+            const double StartTime = Objects.StartTime[Index];
+            std::int32_t RhythmStart = 0;
+            while (RhythmStart < HistoricalNoteCount - 2
+                   && StartTime - Objects.StartTime[Index - RhythmStart - 1] < HISTORY_TIME_MAX)
+                RhythmStart++;
+
+            for (std::int32_t i = RhythmStart; i > 0; i--)
+            {
+                const std::size_t Current = Index - i;
+                const std::size_t Previous = Current - 1;
+                const std::size_t Last = Current - 2;
+
+                // from the oldest note in the history to now, limited by time or by count
+                const double HistoricalDecay = std::min(static_cast<double>(HistoricalNoteCount - i)
+                    / HistoricalNoteCount, (HISTORY_TIME_MAX - (StartTime - Objects.StartTime[Current]))
+                    / HISTORY_TIME_MAX);
+
+                const double CurrentDelta = Objects.StrainTime[Current];
+                const double PreviousDelta = Objects.StrainTime[Previous];
+                const double LastDelta = Objects.StrainTime[Last];
+                const double CurrentRatio = 1.0 + 6.0 * std::min(0.5, std::pow(std::sin(std::numbers::pi
+                    / (std::min(PreviousDelta, CurrentDelta) / std::max(PreviousDelta, CurrentDelta))), 2));
+
+                const double Window = Objects.GetHitWindowGreat(Current) * 0.3;
+                const double WindowPenalty = std::min(1.0, std::max(0.0, std::abs(PreviousDelta - CurrentDelta)
+                    - Window) / Window);
+                double EffectiveRatio = WindowPenalty * CurrentRatio;
+
+                if (FirstDeltaSwitch)
+                {
+                    if (!(PreviousDelta > 1.25 * CurrentDelta || PreviousDelta * 1.25 < CurrentDelta))
+                    {
+                        if (IslandSize < 7) IslandSize++;
+                        continue;
+                    }
+
+                    // into or out of a slider is easy to hit; repeated island sizes and parities are easier too
+                    if (Objects.Kind[Current] == ObjectKind::Slider) EffectiveRatio *= 0.125;
+                    if (Objects.Kind[Previous] == ObjectKind::Slider) EffectiveRatio *= 0.25;
+                    if (PreviousIslandSize == IslandSize) EffectiveRatio *= 0.25;
+                    if (PreviousIslandSize % 2 == IslandSize % 2) EffectiveRatio *= 0.50;
+                    // 1/1 -> 1/2 -> 1/4 speeding up note by note
+                    if (LastDelta > PreviousDelta + 10 && PreviousDelta > CurrentDelta + 10) EffectiveRatio *= 0.125;
+
+                    RhythmComplexitySum += std::sqrt(EffectiveRatio * StartRatio) * HistoricalDecay
+                        * std::sqrt(4 + IslandSize) / 2 * std::sqrt(4 + PreviousIslandSize) / 2;
+                    StartRatio = EffectiveRatio;
+                    PreviousIslandSize = IslandSize;
+                    // slowing down ends the count, speeding up keeps counting islands
+                    if (PreviousDelta * 1.25 < CurrentDelta) FirstDeltaSwitch = false;
+                    IslandSize = 1;
+                }
+                else if (PreviousDelta > 1.25 * CurrentDelta)
+                {
+                    FirstDeltaSwitch = true;
+                    StartRatio = EffectiveRatio;
+                    IslandSize = 1;
+                }
+            }
+            return std::sqrt(4 + RhythmComplexitySum * RHYTHM_MULTIPLIER) / 2;
+        }
+    }
+
+    /**
+     *  Splits a strain into SECTION_LENGTH sections and returns the peak of each. StrainAt(Index) advances the
+     *  strain to object Index; InitialStrain(Time, Index) is the strain left at Time, the start of a section,
+     *  decayed from the object before Index.
+     */
+    template <typename Strain, typename Initial>
+    std::vector<double> GetStrainPeaks(const DifficultyObjects& Objects, Strain&& StrainAt, Initial&& InitialStrain)
+    {
+        std::vector<double> Peaks;
+        if (!Objects.size()) return Peaks;
+        Peaks.reserve(static_cast<std::size_t>((Objects.StartTime.back() - Objects.StartTime.front())
+            / SECTION_LENGTH) + 2);
+
+        // the first object has no strain of its own, so its section ends after it
+        double SectionEnd = std::ceil(Objects.StartTime.front() / SECTION_LENGTH) * SECTION_LENGTH;
+        double SectionPeak = 0;
+        for (std::size_t i = 0; i < Objects.size(); i++)
+        {
+            while (Objects.StartTime[i] > SectionEnd)
+            {
+                Peaks.push_back(SectionPeak);
+                SectionPeak = InitialStrain(SectionEnd, i);
+                SectionEnd += SECTION_LENGTH;
+            }
+            SectionPeak = std::max(StrainAt(i), SectionPeak);
+        }
+        Peaks.push_back(SectionPeak);
+        return Peaks;
+    }
+
+    /**
+     *  A weighted sum of the section peaks, highest first at weights decaying by DECAY_WEIGHT, after scaling the
+     *  ReducedSectionCount highest down towards 0.75 so a single spike counts less.
+     */
+    inline double GetDifficultyValue(std::vector<double> Peaks, const std::size_t ReducedSectionCount,
+                                     const double Multiplier)
+    {
+        // sections without strain can not count, and leaving them out keeps the sorts short
+        std::erase_if(Peaks, [](const double Peak) { return !(Peak > 0); });
+        std::ranges::sort(Peaks, std::greater());
+        for (std::size_t i = 0; i < std::min(Peaks.size(), ReducedSectionCount); i++)
+        {
+            const double Scale = std::log10(1 + 9 * std::clamp(static_cast<double>(i) / ReducedSectionCount, 0.0,
+                                                               1.0));
+            Peaks[i] *= 0.75 + 0.25 * Scale;
+        }
+        std::ranges::sort(Peaks, std::greater());
+
+        double Difficulty = 0;
+        double Weight = 1;
+        for (const double Peak : Peaks)
+        {
+            Difficulty += Peak * Weight;
+            Weight *= DECAY_WEIGHT;
+        }
+        return Difficulty * Multiplier;
+    }
+
+    /**
+     *  osu!standard star rating of one map, under any mods.
+     *
+     *  The map is flattened on construction: slider paths, nested ticks and repeats, and stacking for each
+     *  approach rate the mods can give are computed once, so rating it under another set of mods only rebuilds
+     *  the difficulty objects and walks the strains. Hard Rock, Easy, Double Time/Nightcore, Half Time, Touch
+     *  Device and Relax change the rating; Flashlight has none of its own here. Maps of other modes rate as 0.
+     *
+     *  Follows osu!'s calculator: per object aim (jumps, angles, velocity changes, slider travel) and speed
+     *  (tapping speed times rhythm complexity) strains decay over time, their peaks per 400 ms section are summed
+     *  highest first with decaying weights, and the two combine into the star rating.
+     */
+    class DifficultyCalculator
+    {
+    public:
+        explicit DifficultyCalculator(const Beatmap::Beatmap& Beatmap)
+            : m_Standard(Beatmap.General.Mode == OsuParser::Beatmap::Sections::General::ModeType::OSU_STANDARD),
+              m_CircleSize(Beatmap.Difficulty.CircleSize),
+              // maps before v8 have no ApproachRate; osu! uses OverallDifficulty for it there
+              m_ApproachRate(Beatmap.Version < 8 ? Beatmap.Difficulty.OverallDifficulty
+                                                 : Beatmap.Difficulty.ApproachRate),
+              m_OverallDifficulty(Beatmap.Difficulty.OverallDifficulty),
+              m_DrainRate(Beatmap.Difficulty.HPDrainRate)
+        {
+            if (!this->m_Standard) return;
+            const auto& Objects = Beatmap.HitObjects.data;
+            SliderPath::SliderPaths Paths(Beatmap.HitObjects);
+            Paths.BuildAll();
+
+            using SliderEvents::SliderEventType;
+            const SliderEvents::SliderEventList Events = SliderEvents::Generate(Beatmap);
+            this->m_MaxCombo = Events.MaxCombo;
+            this->m_CircleCount = Events.Circles;
+            this->m_SliderCount = Events.Sliders;
+            this->m_SpinnerCount = Events.Spinners;
+
+            // the nested objects of each slider after its head, in time order as the events are
+            std::vector<std::uint32_t> NestedStart(Objects.size() + 1, 0);
+            std::vector<double> TailTime(Objects.size(), 0);
+            for (const SliderEvents::SliderEvent& Event : Events.Events)
+            {
+                if (Event.Type == SliderEventType::Tail) TailTime[Event.Object] = Event.Time;
+                else if (Event.Type != SliderEventType::Head) NestedStart[Event.Object + 1]++;
+            }
+            for (std::size_t i = 0; i < Objects.size(); i++) NestedStart[i + 1] += NestedStart[i];
+            std::vector<const SliderEvents::SliderEvent*> NestedEvents(NestedStart.back());
+            std::vector<std::uint32_t> Next(NestedStart.begin(), NestedStart.end() - 1);
+            for (const SliderEvents::SliderEvent& Event : Events.Events)
+            {
+                if (Event.Type == SliderEventType::Head || Event.Type == SliderEventType::Tail)
+                    continue;
+                NestedEvents[Next[Event.Object]++] = &Event;
+            }
+
+            this->m_Objects.resize(Objects.size());
+            this->m_Nested.reserve(NestedEvents.size());
+            for (std::size_t i = 0; i < Objects.size(); i++)
+            {
+                const auto& Object = Objects[i];
+                Flat& Target = this->m_Objects[i];
+                Target.Position = Paths.GetStart(i);
+                Target.EndPosition = Target.Position;
+                Target.Time = Object.Time;
+                Target.Kind = Object.type.Spinner ? ObjectKind::Spinner
+                    : Object.SliderParameters ? ObjectKind::Slider : ObjectKind::Circle;
+                if (Target.Kind != ObjectKind::Slider) continue;
+
+                const SliderPath::Path& Path = *Paths.Get(i);
+                const std::int32_t Spans = std::max(Paths.GetSlides(i), 1);
+                Target.EndPosition = Path.BallPositionAt(1, Spans);
+                Target.RepeatCount = Spans - 1;
+                Target.FirstNested = static_cast<std::uint32_t>(this->m_Nested.size());
+                Target.NestedCount = NestedStart[i + 1] - NestedStart[i];
+                for (std::uint32_t Event = NestedStart[i]; Event < NestedStart[i + 1]; Event++)
+                {
+                    // osu! puts the tail, judged at the legacy last tick, at the end of the slider
+                    const SliderEvents::SliderEvent& Tick = *NestedEvents[Event];
+                    const Vector2 Position = Tick.Type == SliderEventType::LegacyLastTick ? Target.EndPosition
+                        : Path.PositionAt(Tick.PathProgress);
+                    this->m_Nested.push_back({Position - Target.Position, Tick.Type == SliderEventType::Repeat});
+                }
+
+                // where the cursor may lazily end up: on the path where the legacy last tick is
+                Target.TravelTime = Target.NestedCount ? NestedEvents[NestedStart[i + 1] - 1]->Time - Target.Time : 0;
+                const double SpanDuration = (TailTime[i] - Target.Time) / Spans;
+                double Progress = SpanDuration > 0 ? Target.TravelTime / SpanDuration : 0;
+                Progress = std::fmod(Progress, 2) >= 1 ? 1 - std::fmod(Progress, 1) : std::fmod(Progress, 1);
+                Target.LazyEnd = Path.PositionAt(Progress) - Target.Position;
+            }
+
+            // stacking only changes with approach rate, which Hard Rock and Easy scale
+            for (const Mod Variant : {Mod::None, Mod::HardRock, Mod::Easy})
+            {
+                const Stacking::Stacks Stacks(Beatmap.HitObjects, Paths, Beatmap.General.StackLeniency,
+                                              ApplyDifficultyMods(this->m_ApproachRate,
+                                                                  static_cast<std::uint32_t>(Variant)),
+                                              this->m_CircleSize, Beatmap.Version);
+                this->m_StackHeights[GetStackVariant(static_cast<std::uint32_t>(Variant))].assign(
+                    Stacks.GetHeights().begin(), Stacks.GetHeights().end());
+            }
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Objects.size(); }
+
+        // The difficulty objects under Mods, for evaluating strains or anything else over them
+        [[nodiscard]] DifficultyObjects GetObjects(const std::uint32_t Mods) const
+        {
+            DifficultyObjects Result;
+            if (this->m_Objects.size() < 2) return Result;
+
+            const double ClockRate = GetClockRate(Mods);
+            const double Scale = Stacking::Stacks::GetScale(ApplyDifficultyMods(this->m_CircleSize, Mods, 1.3));
+            const double Radius = OBJECT_RADIUS * Scale;
+            const double StackOffset = Scale * Stacking::STACK_OFFSET;
+            const std::vector<std::int32_t>& Heights = this->m_StackHeights[GetStackVariant(Mods)];
+            Result.HitWindowGreat = 2 * (80 - 6 * ApplyDifficultyMods(this->m_OverallDifficulty, Mods)) / ClockRate;
+
+            // stacked head positions, and where a lazy cursor leaves each object
+            const std::size_t Count = this->m_Objects.size();
+            std::vector<Vector2> Positions(Count);
+            std::vector<Vector2> CursorEnds(Count);
+            std::vector<double> LazyTravelDistance(Count, 0);
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                const Flat& Object = this->m_Objects[i];
+                Positions[i] = Object.Position + Vector2{1, 1} * (Heights[i] * StackOffset);
+                CursorEnds[i] = Positions[i];
+                if (Object.Kind == ObjectKind::Slider)
+                    CursorEnds[i] = Positions[i] + this->GetLazyEnd(Object, NORMALISED_RADIUS / Radius,
+                                                                     LazyTravelDistance[i]);
+            }
+
+            // distances as if circles had NORMALISED_RADIUS, and a little more for very small ones
+            double ScalingFactor = NORMALISED_RADIUS / Radius;
+            if (Radius < 30) ScalingFactor *= 1 + std::min(30 - Radius, 5.0) / 50;
+
+            Result.resize(Count - 1);
+            for (std::size_t i = 1; i < Count; i++)
+            {
+                const std::size_t Index = i - 1;
+                const Flat& Object = this->m_Objects[i];
+                const Flat& LastObject = this->m_Objects[i - 1];
+                Result.Kind[Index] = Object.Kind;
+                Result.StartTime[Index] = Object.Time / ClockRate;
+                Result.DeltaTime[Index] = (Object.Time - LastObject.Time) / ClockRate;
+                Result.StrainTime[Index] = std::max(Result.DeltaTime[Index], MIN_DELTA_TIME);
+
+                if (Object.Kind == ObjectKind::Slider)
+                {
+                    // repeats are worth a bit more until nested objects have strains of their own
+                    Result.TravelDistance[Index] = LazyTravelDistance[i]
+                        * std::pow(1 + Object.RepeatCount / 2.5, 1.0 / 2.5);
+                    Result.TravelTime[Index] = std::max(Object.TravelTime / ClockRate, MIN_DELTA_TIME);
+                }
+                if (Object.Kind == ObjectKind::Spinner || LastObject.Kind == ObjectKind::Spinner) continue;
+
+                const double JumpDistance = ((Positions[i] - CursorEnds[i - 1]) * ScalingFactor).Length();
+                Result.LazyJumpDistance[Index] = JumpDistance;
+                Result.MinimumJumpDistance[Index] = JumpDistance;
+                Result.MinimumJumpTime[Index] = Result.StrainTime[Index];
+                if (LastObject.Kind == ObjectKind::Slider)
+                {
+                    // the jump can start anywhere inside the follow circle around the end of the last slider
+                    const double LastTravelTime = std::max(LastObject.TravelTime / ClockRate, MIN_DELTA_TIME);
+                    Result.MinimumJumpTime[Index] = std::max(Result.StrainTime[Index] - LastTravelTime,
+                                                             MIN_DELTA_TIME);
+                    const Vector2 LastTail = LastObject.EndPosition + Vector2{1, 1} * (Heights[i - 1] * StackOffset);
+                    const double TailJumpDistance = (LastTail - Positions[i]).Length() * ScalingFactor;
+                    Result.MinimumJumpDistance[Index] = std::max(0.0, std::min(
+                        JumpDistance - (MAXIMUM_SLIDER_RADIUS - ASSUMED_SLIDER_RADIUS),
+                        TailJumpDistance - MAXIMUM_SLIDER_RADIUS));
+                }
+
+                if (i >= 2 && this->m_Objects[i - 2].Kind != ObjectKind::Spinner)
+                {
+                    const Vector2 First = CursorEnds[i - 2] - Positions[i - 1];
+                    const Vector2 Second = Positions[i] - CursorEnds[i - 1];
+                    const double Dot = First.Dot(Second);
+                    const double Determinant = First.X * Second.Y - First.Y * Second.X;
+                    Result.Angle[Index] = std::abs(std::atan2(Determinant, Dot));
+                }
+            }
+            return Result;
+        }
+
+        [[nodiscard]] DifficultyAttributes Calculate(const std::uint32_t Mods = 0) const
+        {
+            DifficultyAttributes Attributes;
+            Attributes.Mods = Mods;
+            if (!this->m_Standard || this->m_Objects.empty()) return Attributes;
+
+            const DifficultyObjects Objects = this->GetObjects(Mods);
+            double AimRating = std::sqrt(GetAimDifficulty(Objects, true)) * DIFFICULTY_MULTIPLIER;
+            const double AimRatingNoSliders = std::sqrt(GetAimDifficulty(Objects, false)) * DIFFICULTY_MULTIPLIER;
+            double SpeedNoteCount = 0;
+            double SpeedRating = std::sqrt(GetSpeedDifficulty(Objects, SpeedNoteCount)) * DIFFICULTY_MULTIPLIER;
+
+            Attributes.SliderFactor = AimRating > 0 ? AimRatingNoSliders / AimRating : 1;
+            if (HasMod(Mods, Mod::TouchDevice)) AimRating = std::pow(AimRating, 0.8);
+            if (HasMod(Mods, Mod::Relax))
+            {
+                AimRating *= 0.9;
+                SpeedRating = 0;
+            }
+
+            const double AimPerformance = GetBasePerformance(AimRating);
+            const double SpeedPerformance = GetBasePerformance(SpeedRating);
+            const double Performance = std::pow(std::pow(AimPerformance, 1.1) + std::pow(SpeedPerformance, 1.1),
+                                                1 / 1.1);
+            Attributes.StarRating = Performance > 0.00001
+                ? std::cbrt(PERFORMANCE_BASE_MULTIPLIER) * 0.027
+                    * (std::cbrt(100000 / std::pow(2, 1 / 1.1) * Performance) + 4)
+                : 0;
+            Attributes.AimDifficulty = AimRating;
+            Attributes.SpeedDifficulty = SpeedRating;
+            Attributes.SpeedNoteCount = SpeedNoteCount;
+
+            const double ClockRate = GetClockRate(Mods);
+            const double Preempt = Stacking::Stacks::GetPreempt(ApplyDifficultyMods(this->m_ApproachRate, Mods))
+                / ClockRate;
+            Attributes.ApproachRate = Preempt > 1200 ? (1800 - Preempt) / 120 : (1200 - Preempt) / 150 + 5;
+            const double HitWindowGreat = (80 - 6 * ApplyDifficultyMods(this->m_OverallDifficulty, Mods)) / ClockRate;
+            Attributes.OverallDifficulty = (80 - HitWindowGreat) / 6;
+            Attributes.DrainRate = ApplyDifficultyMods(this->m_DrainRate, Mods);
+            Attributes.MaxCombo = this->m_MaxCombo;
+            Attributes.HitCircleCount = this->m_CircleCount;
+            Attributes.SliderCount = this->m_SliderCount;
+            Attributes.SpinnerCount = this->m_SpinnerCount;
+            return Attributes;
+        }
+
+        // One map under many mod combinations, on Threads threads (0 = hardware concurrency)
+        [[nodiscard]] std::vector<DifficultyAttributes> Calculate(const std::span<const std::uint32_t> Mods,
+                                                                  const std::uint32_t Threads = 0) const
+        {
+            WorkStealingPool Pool(Threads);
+            return this->Calculate(Mods, Pool);
+        }
+
+        // Same, on a pool the caller keeps around
+        [[nodiscard]] std::vector<DifficultyAttributes> Calculate(const std::span<const std::uint32_t> Mods,
+                                                                  WorkStealingPool& Pool) const
+        {
+            std::vector<DifficultyAttributes> Result(Mods.size());
+            Pool.Run(Mods.size(), [&](const std::size_t Index, std::uint32_t)
+            {
+                try
+                {
+                    Result[Index] = this->Calculate(Mods[Index]);
+                }
+                catch (const std::exception& Exception)
+                {
+                    Result[Index] = {};
+                    Result[Index].Mods = Mods[Index];
+                    Result[Index].Error = Exception.what();
+                }
+            });
+            return Result;
+        }
+
+        [[nodiscard]] static double GetAimDifficulty(const DifficultyObjects& Objects, const bool WithSliders)
+        {
+            constexpr double SKILL_MULTIPLIER = 23.55;
+            constexpr double STRAIN_DECAY_BASE = 0.15;
+            double Strain = 0;
+            return GetDifficultyValue(GetStrainPeaks(Objects, [&](const std::size_t Index)
+            {
+                Strain *= std::pow(STRAIN_DECAY_BASE, Objects.DeltaTime[Index] / 1000);
+                Strain += Evaluators::EvaluateAim(Objects, Index, WithSliders) * SKILL_MULTIPLIER;
+                return Strain;
+            }, [&](const double Time, const std::size_t Index)
+            {
+                return Strain * std::pow(STRAIN_DECAY_BASE, (Time - Objects.StartTime[Index - 1]) / 1000);
+            }), 10, 1.06);
+        }
+
+        // Also counts the objects that are about as hard to tap as the hardest one into NoteCount
+        [[nodiscard]] static double GetSpeedDifficulty(const DifficultyObjects& Objects, double& NoteCount)
+        {
+            constexpr double SKILL_MULTIPLIER = 1375;
+            constexpr double STRAIN_DECAY_BASE = 0.3;
+            double Strain = 0;
+            double Rhythm = 0;
+            std::vector<double> ObjectStrains;
+            ObjectStrains.reserve(Objects.size());
+            const double Difficulty = GetDifficultyValue(GetStrainPeaks(Objects, [&](const std::size_t Index)
+            {
+                Strain *= std::pow(STRAIN_DECAY_BASE, Objects.StrainTime[Index] / 1000);
+                Strain += Evaluators::EvaluateSpeed(Objects, Index) * SKILL_MULTIPLIER;
+                Rhythm = Evaluators::EvaluateRhythm(Objects, Index);
+                ObjectStrains.push_back(Strain * Rhythm);
+                return ObjectStrains.back();
+            }, [&](const double Time, const std::size_t Index)
+            {
+                return Strain * Rhythm * std::pow(STRAIN_DECAY_BASE, (Time - Objects.StartTime[Index - 1]) / 1000);
+            }), 5, 1.04);
+
+            NoteCount = 0;
+            const double MaxStrain = ObjectStrains.empty() ? 0 : std::ranges::max(ObjectStrains);
+            if (MaxStrain > 0)
+                for (const double ObjectStrain : ObjectStrains)
+                    NoteCount += 1.0 / (1.0 + std::exp(-(ObjectStrain / MaxStrain * 12.0 - 6.0)));
+            return Difficulty;
+        }
+
+    private:
+        struct Flat
+        {
+            Vector2 Position; // unstacked
+            Vector2 EndPosition; // of the ball after the last slide, unstacked
+            Vector2 LazyEnd; // from Position, where the cursor is assumed to end up before following the ticks
+            double Time = 0;
+            double TravelTime = 0; // from the head to the legacy last tick
+            std::uint32_t FirstNested = 0; // into m_Nested
+            std::uint32_t NestedCount = 0;
+            std::int32_t RepeatCount = 0;
+            ObjectKind Kind = ObjectKind::Circle;
+        };
+
+        struct Nested
+        {
+            Vector2 Offset; // from the slider head
+            bool IsRepeat = false;
+        };
+
+        static std::size_t GetStackVariant(const std::uint32_t Mods)
+        {
+            return HasMod(Mods, Mod::HardRock) ? 1 : HasMod(Mods, Mod::Easy) ? 2 : 0;
+        }
+
+        static double GetBasePerformance(const double Rating)
+        {
+            return std::pow(5 * std::max(1.0, Rating / 0.0675) - 4, 3) / 100000;
+        }
+
+        /**
+         *  Where a lazy cursor leaves a slider, from its head: it follows the nested objects only once they are
+         *  further than a follow circle from it (a radius for repeats), and takes the shorter way to the end.
+         *  TravelDistance is how far it moved, in normalised distance.
+         */
+        [[nodiscard]] Vector2 GetLazyEnd(const Flat& Slider, const double ScalingFactor, double& TravelDistance) const
+        {
+            Vector2 Cursor;
+            for (std::uint32_t i = 0; i < Slider.NestedCount; i++)
+            {
+                const Nested& Object = this->m_Nested[Slider.FirstNested + i];
+                Vector2 Movement = Object.Offset - Cursor;
+                double Required = ASSUMED_SLIDER_RADIUS;
+                if (i + 1 == Slider.NestedCount)
+                {
+                    // the end only needs to be near; take the lazy end when it is the shorter way
+                    if (const Vector2 Lazy = Slider.LazyEnd - Cursor; Lazy.Length() < Movement.Length())
+                        Movement = Lazy;
+                }
+                else if (Object.IsRepeat) Required = NORMALISED_RADIUS;
+
+                const double Length = ScalingFactor * Movement.Length();
+                if (Length > Required)
+                {
+                    Cursor = Cursor + Movement * ((Length - Required) / Length);
+                    TravelDistance += Length - Required;
+                }
+            }
+            return Slider.NestedCount ? Cursor : Slider.LazyEnd;
+        }
+
+        bool m_Standard = true;
+        double m_CircleSize = 0;
+        double m_ApproachRate = 0;
+        double m_OverallDifficulty = 0;
+        double m_DrainRate = 0;
+        std::uint32_t m_MaxCombo = 0;
+        std::uint32_t m_CircleCount = 0;
+        std::uint32_t m_SliderCount = 0;
+        std::uint32_t m_SpinnerCount = 0;
+        std::vector<Flat> m_Objects;
+        std::vector<Nested> m_Nested;
+        std::array<std::vector<std::int32_t>, 3> m_StackHeights; // without Hard Rock or Easy, with either
+    };
+
+    /**
+     *  Rates many maps under the same mods straight from the parsed beatmaps, one map per task on a
+     *  WorkStealingPool, so a marathon next to short maps does not leave threads idle. A map that fails (out of
+     *  memory) gets its Error set instead of failing the batch.
+     */
+    inline std::vector<DifficultyAttributes> CalculateBatch(const std::vector<const Beatmap::Beatmap*>& Beatmaps,
+                                                            WorkStealingPool& Pool, const std::uint32_t Mods = 0)
+    {
+        std::vector<DifficultyAttributes> Result(Beatmaps.size());
+        Pool.Run(Beatmaps.size(), [&](const std::size_t Index, std::uint32_t)
+        {
+            try
+            {
+                Result[Index] = DifficultyCalculator(*Beatmaps[Index]).Calculate(Mods);
+            }
+            catch (const std::exception& Exception)
+            {
+                Result[Index] = {};
+                Result[Index].Mods = Mods;
+                Result[Index].Error = Exception.what();
+            }
+        });
+        return Result;
+    }
+
+    // Same, on Threads threads (0 = hardware concurrency)
+    inline std::vector<DifficultyAttributes> CalculateBatch(const std::vector<const Beatmap::Beatmap*>& Beatmaps,
+                                                            const std::uint32_t Mods = 0,
+                                                            const std::uint32_t Threads = 0)
+    {
+        WorkStealingPool Pool(Threads);
+        return CalculateBatch(Beatmaps, Pool, Mods);
+    }
+}
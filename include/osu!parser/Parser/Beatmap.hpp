@@ -1,9 +1,22 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
 #include <fstream>
-#include <unordered_map>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "Instrumentation.hpp"
+#include "ParseError.hpp"
+#include "Reader/Md5.hpp"
+#include "Reader/Tokenizer.hpp"
+#include "Writer/TextWriter.hpp"
 #include "Structures/Beatmap/Sections/DifficultySection.hpp"
 #include "Structures/Beatmap/Sections/EditorSection.hpp"
 #include "Structures/Beatmap/Sections/GeneralSection.hpp"
@@ -11,88 +24,544 @@
 #include "Structures/Beatmap/Sections/ColourSection.hpp"
 #include "Structures/Beatmap/Sections/VariableSection.hpp"
 #include "Structures/Beatmap/Objects/HitObject.hpp"
+#include "Structures/Beatmap/Objects/PackedHitObject.hpp"
 #include "Structures/Beatmap/Objects/TimingPoint.hpp"
 #include "Structures/Beatmap/Objects/Event.hpp"
 
 namespace OsuParser::Beatmap
 {
-    static constexpr int MINIMUM_LINE_CHARACTERS = 3;
+    static constexpr int MINIMUM_LINE_CHARACTERS = static_cast<int>(Tokenizer::MINIMUM_LINE_CHARACTERS);
+
+    enum class Section : std::uint32_t
+    {
+        None = 0,
+        General = 1 << 0,
+        Metadata = 1 << 1,
+        Editor = 1 << 2,
+        Difficulty = 1 << 3,
+        Colours = 1 << 4,
+        Variables = 1 << 5,
+        TimingPoints = 1 << 6,
+        HitObjects = 1 << 7,
+        Events = 1 << 8,
+        All = (1 << 9) - 1,
+        // Not a section of the file: the constructors also hash the whole file as they read it, see GetHash()
+        Hash = 1 << 9
+    };
+
+    static constexpr std::size_t SECTION_COUNT = 9;
+
+    constexpr Section operator|(const Section Left, const Section Right)
+    {
+        return static_cast<Section>(static_cast<std::uint32_t>(Left) | static_cast<std::uint32_t>(Right));
+    }
+
+    constexpr Section operator&(const Section Left, const Section Right)
+    {
+        return static_cast<Section>(static_cast<std::uint32_t>(Left) & static_cast<std::uint32_t>(Right));
+    }
+
+    // Name of the .osu section header, for a single Section
+    constexpr std::string_view GetSectionName(const Section Section)
+    {
+        switch (Section)
+        {
+        case Section::General: return "General";
+        case Section::Metadata: return "Metadata";
+        case Section::Editor: return "Editor";
+        case Section::Difficulty: return "Difficulty";
+        case Section::Colours: return "Colours";
+        case Section::Variables: return "Variables";
+        case Section::TimingPoints: return "TimingPoints";
+        case Section::HitObjects: return "HitObjects";
+        case Section::Events: return "Events";
+        default: return {};
+        }
+    }
+
+    // Instrumentation phase of the parse of a single Section
+    constexpr Instrumentation::Phase GetSectionPhase(const Section Section)
+    {
+        return static_cast<Instrumentation::Phase>(static_cast<int>(Instrumentation::Phase::General)
+                                                   + std::countr_zero(static_cast<std::uint32_t>(Section)));
+    }
+
+    enum class LoadMode : std::uint8_t
+    {
+        Eager, // every section is parsed by the constructor
+        Lazy // the constructor only locates sections, each one is parsed on first access through its getter
+    };
 
     class Beatmap
     {
     public:
-        explicit Beatmap(const std::string& BeatmapPath, const bool OnlyEvents = false) : m_CurrentStream(BeatmapPath)
+        /**
+         *  Parses only the sections in Sections (plus the ones they depend on), the others stay empty.
+         *  Unrequested sections are never tokenized, and the file is only read up to the header that follows the
+         *  last requested section: {Metadata, Difficulty} stops long before [HitObjects].
+         *
+         *  Nothing is thrown for malformed content. In Lenient mode a line with a bad field is skipped, in Strict
+         *  mode a section stops at its first one; either way GetErrors() tells where they were.
+         */
+        explicit Beatmap(const std::string& BeatmapPath, const Section Sections = Section::All,
+                         const ParseMode Parsing = ParseMode::Lenient)
         {
-            this->Reset();
-            if (!m_CurrentStream.good()) return;
+            this->m_Lazy.Mode = Parsing;
+            this->Open(BeatmapPath, WithDependencies(Sections));
+            this->Close(WithDependencies(Sections));
+        }
 
-            std::string CurrentLine;
-            std::string CurrentSection = {};
-            while (std::getline(m_CurrentStream, CurrentLine))
+        // Parses a .osu held in memory, in place; Buffer only has to outlive the constructor
+        explicit Beatmap(const std::span<const std::byte> Buffer, const Section Sections = Section::All,
+                         const ParseMode Parsing = ParseMode::Lenient)
+        {
+            this->m_Lazy.Mode = Parsing;
+            this->Open(Buffer);
+            this->Close(WithDependencies(Sections));
+        }
+
+        // Reads a .osu from the current position of Stream, stopping early like the path constructor
+        explicit Beatmap(std::istream& Stream, const Section Sections = Section::All,
+                         const ParseMode Parsing = ParseMode::Lenient)
+        {
+            this->m_Lazy.Mode = Parsing;
+            this->Open(Stream, WithDependencies(Sections));
+            this->Close(WithDependencies(Sections));
+        }
+
+        [[deprecated("use Beatmap(BeatmapPath, Section::Variables | Section::Events)")]]
+        Beatmap(const std::string& BeatmapPath, const bool OnlyEvents)
+            : Beatmap(BeatmapPath, OnlyEvents ? Section::Variables | Section::Events : Section::All)
+        {
+        }
+
+        /**
+         *  In Lazy mode the file is kept in memory and only the section headers are located. The getters below
+         *  parse their section the first time they are called, at most once even when called from several threads;
+         *  the public members stay empty until then. Sections needed by another one are parsed along with it
+         *  (Difficulty and TimingPoints for HitObjects, Variables for Events).
+         */
+        Beatmap(const std::string& BeatmapPath, const LoadMode Mode, const ParseMode Parsing = ParseMode::Lenient)
+        {
+            this->m_Lazy.Mode = Parsing;
+            this->Open(BeatmapPath);
+            if (Mode == LoadMode::Eager) this->Close(Section::All);
+        }
+
+        // In Lazy mode Buffer is not copied, it has to outlive every getter call
+        Beatmap(const std::span<const std::byte> Buffer, const LoadMode Mode,
+                const ParseMode Parsing = ParseMode::Lenient)
+        {
+            this->m_Lazy.Mode = Parsing;
+            this->Open(Buffer);
+            if (Mode == LoadMode::Eager) this->Close(Section::All);
+        }
+
+        Beatmap(std::istream& Stream, const LoadMode Mode, const ParseMode Parsing = ParseMode::Lenient)
+        {
+            this->m_Lazy.Mode = Parsing;
+            this->Open(Stream);
+            if (Mode == LoadMode::Eager) this->Close(Section::All);
+        }
+
+        // Parses every section in Sections that was not parsed yet
+        void Load(const Section Sections)
+        {
+            for (auto Bits = static_cast<std::uint32_t>(Sections & Section::All); Bits; Bits &= Bits - 1)
+                this->EnsureParsed(static_cast<Section>(Bits & (~Bits + 1)));
+        }
+
+        [[nodiscard]] bool IsLoaded(const Section Sections) const
+        {
+            const auto Bits = static_cast<std::uint32_t>(Sections);
+            return (this->m_Lazy.Parsed.load(std::memory_order_acquire) & Bits) == Bits;
+        }
+
+        // Bad lines met by the sections parsed so far, in the order they were parsed
+        [[nodiscard]] std::vector<ParseError> GetErrors() const
+        {
+            std::lock_guard Lock(this->m_Lazy.ErrorLock);
+            return this->m_Lazy.Errors;
+        }
+
+        [[nodiscard]] bool HasErrors() const
+        {
+            std::lock_guard Lock(this->m_Lazy.ErrorLock);
+            return !this->m_Lazy.Errors.empty();
+        }
+
+        Sections::General::GeneralSection& GetGeneral()
+        {
+            this->EnsureParsed(Section::General);
+            return this->General;
+        }
+
+        Sections::Metadata::MetadataSection& GetMetadata()
+        {
+            this->EnsureParsed(Section::Metadata);
+            return this->Metadata;
+        }
+
+        Sections::Editor::EditorSection& GetEditor()
+        {
+            this->EnsureParsed(Section::Editor);
+            return this->Editor;
+        }
+
+        Sections::Difficulty::DifficultySection& GetDifficulty()
+        {
+            this->EnsureParsed(Section::Difficulty);
+            return this->Difficulty;
+        }
+
+        Sections::Colour::ColourSection& GetColours()
+        {
+            this->EnsureParsed(Section::Colours);
+            return this->Colours;
+        }
+
+        Sections::Variable::VariableSection& GetVariables()
+        {
+            this->EnsureParsed(Section::Variables);
+            return this->Variables;
+        }
+
+        Objects::TimingPoint::TimingPoints& GetTimingPoints()
+        {
+            this->EnsureParsed(Section::TimingPoints);
+            return this->TimingPoints;
+        }
+
+        Objects::HitObject::HitObjects& GetHitObjects()
+        {
+            this->EnsureParsed(Section::HitObjects);
+            return this->HitObjects;
+        }
+
+        Objects::Event::Events& GetEvents()
+        {
+            this->EnsureParsed(Section::Events);
+            return this->Events;
+        }
+
+        /**
+         *  MD5 of the file as read, in lowercase hex like osu!.db and replays store it; empty when it is not known.
+         *  The constructors that take a Section compute it when Sections includes Section::Hash (reading the whole
+         *  file even if fewer sections were asked for). A lazy beatmap computes it on the first call.
+         */
+        std::string GetHash()
+        {
+            std::lock_guard Lock(this->m_Lazy.HashLock);
+            if (this->m_Lazy.Hash.empty() && this->m_Lazy.Source && !this->m_Lazy.Source->Partial)
+                this->m_Lazy.Hash = Md5::ToHex(Md5::Hash(this->m_Lazy.Source->Buffer));
+            return this->m_Lazy.Hash;
+        }
+
+        /**
+         *  Writes the beatmap as a .osu, with the sections in the order osu! writes them and LineEnding after every
+         *  line. A map saved by osu! comes back byte for byte; see Section::Write for how keys are kept.
+         *  A lazy beatmap parses the sections it has not parsed yet first. An eager one loaded with a section mask
+         *  writes the sections it did not load with their defaults.
+         */
+        void Write(TextWriter& Writer)
+        {
+            this->Load(Section::All);
+            Writer.SetLineEnding(this->LineEnding);
+            Writer << "osu file format v" << this->Version;
+            Writer.NewLine();
+            Writer.NewLine();
+
+            const auto Header = [&Writer](const std::string_view Name)
             {
-                if (CurrentSection == "Events")
-                {
-                    CurrentLine = Utilities::Trim(CurrentLine, true);
-                    const auto CurrentLineIfAllTrimmed = Utilities::Trim(CurrentLine);
+                Writer << '[' << Name << ']';
+                Writer.NewLine();
+            };
+            const auto WriteSection = [&](const std::string_view Name, const Sections::Section& Keys)
+            {
+                Header(Name);
+                Keys.Write(Writer);
+                Writer.NewLine();
+            };
+            WriteSection("General", this->General);
+            WriteSection("Editor", this->Editor);
+            WriteSection("Metadata", this->Metadata);
+            WriteSection("Difficulty", this->Difficulty);
+            if (!this->Variables.Variables.empty()) WriteSection("Variables", this->Variables);
+            Header("Events");
+            this->Events.write(Writer);
+            Writer.NewLine();
+            Header("TimingPoints");
+            this->TimingPoints.Write(Writer);
+            Writer.NewLine();
+            Writer.NewLine(); // osu! leaves two empty lines after the timing points
+            if (this->Colours.HasColours()) WriteSection("Colours", this->Colours);
+            Header("HitObjects");
+            this->HitObjects.Write(Writer);
+        }
+
+        [[nodiscard]] std::string ToString()
+        {
+            TextWriter Writer;
+            this->Write(Writer);
+            return Writer.Take();
+        }
+
+        // Writes the .osu to BeatmapPath, through a buffer of a fixed size; false if it could not be written
+        bool Save(const std::string& BeatmapPath)
+        {
+            std::ofstream Stream(BeatmapPath, std::ios::binary | std::ios::trunc);
+            if (!Stream.good()) return false;
+            {
+                TextWriter Writer(Stream);
+                this->Write(Writer);
+            }
+            return Stream.good();
+        }
+
+    private:
+        // The file and where its sections are; shared by copies, never modified after Open
+        struct SourceFile
+        {
+            std::string Owned; // empty when reading a caller's buffer
+            std::string_view Buffer;
+            Tokenizer::SectionRanges Ranges;
+            bool Partial = false; // read stopped after the wanted sections
+            std::string Hash; // when it was hashed while being read
+        };
+
+        // Copies take over the parsed state along with the members it describes, but get their own locks
+        struct LazyState
+        {
+            std::shared_ptr<const SourceFile> Source;
+            std::atomic<std::uint32_t> Parsed = 0;
+            std::array<std::mutex, SECTION_COUNT> Locks;
+            ParseMode Mode = ParseMode::Lenient;
+            std::vector<ParseError> Errors;
+            mutable std::mutex ErrorLock;
+            std::string Hash;
+            mutable std::mutex HashLock;
 
-                    // minimum chars
-                    if (CurrentLineIfAllTrimmed.size() < MINIMUM_LINE_CHARACTERS)
-                        continue;
+            LazyState() = default;
+            LazyState(const LazyState& Other)
+                : Source(Other.Source), Parsed(Other.Parsed.load()), Mode(Other.Mode), Errors(Other.GetErrors()),
+                  Hash(Other.GetHash())
+            {
+            }
 
-                    // is comment
-                    if (CurrentLineIfAllTrimmed[0] == '/' && CurrentLineIfAllTrimmed[1] == '/')
-                        continue;
+            LazyState& operator=(const LazyState& Other)
+            {
+                if (this == &Other) return *this;
+                this->Source = Other.Source;
+                this->Parsed.store(Other.Parsed.load());
+                this->Mode = Other.Mode;
+                auto Copied = Other.GetErrors();
+                auto CopiedHash = Other.GetHash();
+                {
+                    std::lock_guard Lock(this->ErrorLock);
+                    this->Errors = std::move(Copied);
                 }
-                else
+                std::lock_guard Lock(this->HashLock);
+                this->Hash = std::move(CopiedHash);
+                return *this;
+            }
+
+            [[nodiscard]] std::vector<ParseError> GetErrors() const
+            {
+                std::lock_guard Lock(this->ErrorLock);
+                return this->Errors;
+            }
+
+            [[nodiscard]] std::string GetHash() const
+            {
+                std::lock_guard Lock(this->HashLock);
+                return this->Hash;
+            }
+        };
+
+        static Section WithDependencies(Section Sections)
+        {
+            if ((Sections & Section::HitObjects) != Section::None)
+                Sections = Sections | Section::Difficulty | Section::TimingPoints;
+            if ((Sections & Section::Events) != Section::None) Sections = Sections | Section::Variables;
+            return Sections & (Section::All | Section::Hash);
+        }
+
+        static std::vector<std::string_view> GetSectionNames(const Section Sections)
+        {
+            std::vector<std::string_view> Names;
+            for (auto Bits = static_cast<std::uint32_t>(Sections); Bits; Bits &= Bits - 1)
+                Names.push_back(GetSectionName(static_cast<Section>(Bits & (~Bits + 1))));
+            return Names;
+        }
+
+        void Open(const std::string& BeatmapPath, const Section Wanted = Section::All)
+        {
+            auto Opened = std::make_shared<SourceFile>();
+            Opened->Partial = (Wanted & Section::All) != Section::All && (Wanted & Section::Hash) == Section::None;
+            {
+                // only the read (and hash), the parse below has phases of its own
+                OSU_PARSER_PHASE(Instrumentation::Phase::FileRead);
+                if ((Wanted & Section::Hash) != Section::None)
                 {
-                    CurrentLine = Utilities::Trim(CurrentLine);
-                    if (CurrentLine.size() < MINIMUM_LINE_CHARACTERS)
-                        continue;
-                    if (CurrentLine.size() >= 2 && CurrentLine[0] == '/' && CurrentLine[1] == '/') // is comment
-                        continue;
+                    Md5 Hash;
+                    Opened->Owned = Tokenizer::ReadFile(BeatmapPath, Hash);
+                    Opened->Hash = Md5::ToHex(Hash.Finish());
                 }
+                else
+                    Opened->Owned = Opened->Partial ? Tokenizer::ReadFile(BeatmapPath, GetSectionNames(Wanted))
+                                                    : Tokenizer::ReadFile(BeatmapPath);
+            }
+            Opened->Buffer = Opened->Owned;
+            this->Open(std::move(Opened));
+        }
 
-                // is section
-                if (!CurrentLine.empty() && CurrentLine.front() == '[' && CurrentLine.back() == ']')
+        void Open(std::istream& Stream, const Section Wanted = Section::All)
+        {
+            auto Opened = std::make_shared<SourceFile>();
+            Opened->Partial = (Wanted & Section::All) != Section::All && (Wanted & Section::Hash) == Section::None;
+            {
+                // only the read (and hash), the parse below has phases of its own
+                OSU_PARSER_PHASE(Instrumentation::Phase::FileRead);
+                if ((Wanted & Section::Hash) != Section::None)
                 {
-                    CurrentSection = Utilities::Split(Utilities::Split(CurrentLine, '[')[1], ']')[0];
-                    continue;
+                    Md5 Hash;
+                    Opened->Owned = Tokenizer::ReadStream(Stream, Hash);
+                    Opened->Hash = Md5::ToHex(Hash.Finish());
                 }
+                else
+                    Opened->Owned = Opened->Partial ? Tokenizer::ReadStream(Stream, GetSectionNames(Wanted))
+                                                    : Tokenizer::ReadStream(Stream);
+            }
+            Opened->Buffer = Opened->Owned;
+            this->Open(std::move(Opened));
+        }
+
+        void Open(const std::span<const std::byte> Buffer)
+        {
+            auto Opened = std::make_shared<SourceFile>();
+            Opened->Buffer = std::string_view(reinterpret_cast<const char*>(Buffer.data()), Buffer.size());
+            this->Open(std::move(Opened));
+        }
+
+        void Open(std::shared_ptr<SourceFile> Opened)
+        {
+            this->Reset();
+            this->m_Lazy.Hash = Opened->Hash;
+            this->ReadHeader(Opened->Buffer);
+            OSU_PARSER_PHASE(Instrumentation::Phase::Tokenize);
+            Opened->Ranges = Tokenizer::FindSections(Opened->Buffer);
+            this->m_Lazy.Source = std::move(Opened);
+        }
+
+        // "osu file format v14" on the first line, which also tells the line ending the file uses
+        void ReadHeader(std::string_view Buffer)
+        {
+            if (Buffer.starts_with("\xEF\xBB\xBF")) Buffer.remove_prefix(3);
+            const std::size_t End = std::min(Buffer.find('\n'), Buffer.size());
+            std::string_view Line = Buffer.substr(0, End);
+            if (!Line.empty() && Line.back() == '\r') Line.remove_suffix(1);
+            this->LineEnding = End < Buffer.size() && Line.size() == End ? "\n" : "\r\n";
+
+            constexpr std::string_view FORMAT = "osu file format v";
+            if (const auto Position = Line.find(FORMAT); Position != std::string_view::npos)
+                if (const auto Number = Utilities::ParseNumber<std::int32_t>(Line.substr(Position + FORMAT.size())))
+                    this->Version = *Number;
+        }
+
+        // Parses Sections and lets go of the source, for the eager constructors
+        void Close(const Section Sections)
+        {
+            if ((Sections & Section::Hash) != Section::None) static_cast<void>(this->GetHash());
+            this->Load(Sections);
+            this->m_Lazy.Source.reset();
+        }
 
+        void EnsureParsed(const Section Section)
+        {
+            const auto Bit = static_cast<std::uint32_t>(Section);
+            if (this->m_Lazy.Parsed.load(std::memory_order_acquire) & Bit) return;
+            if (!this->m_Lazy.Source) return; // eager beatmap, sections that were not requested stay empty
 
-                this->m_Sections[CurrentSection].push_back(CurrentLine);
+            // dependencies take their own locks first, so the lock order always follows this graph
+            if (Section == Section::HitObjects)
+            {
+                this->EnsureParsed(Section::Difficulty);
+                this->EnsureParsed(Section::TimingPoints);
             }
+            else if (Section == Section::Events) this->EnsureParsed(Section::Variables);
+
+            std::lock_guard Lock(this->m_Lazy.Locks[std::countr_zero(Bit)]);
+            if (this->m_Lazy.Parsed.load(std::memory_order_relaxed) & Bit) return;
+            this->Parse(Section);
+            this->m_Lazy.Parsed.fetch_or(Bit, std::memory_order_release);
+        }
 
-            if (!OnlyEvents)
+        [[nodiscard]] const std::vector<std::string_view>& GetRanges(const Section Section) const
+        {
+            static const std::vector<std::string_view> Empty = {};
+            const auto Iterator = this->m_Lazy.Source->Ranges.find(GetSectionName(Section));
+            return Iterator != this->m_Lazy.Source->Ranges.end() ? Iterator->second : Empty;
+        }
+
+        void Parse(const Section Section)
+        {
+            OSU_PARSER_PHASE(GetSectionPhase(Section));
+            Lines Lines;
             {
-                // Sections
-                this->General.Parse(this->m_Sections["General"]);
-                this->Metadata.Parse(this->m_Sections["Metadata"]);
-                this->Editor.Parse(this->m_Sections["Editor"]);
-                this->Difficulty.Parse(this->m_Sections["Difficulty"]);
-                this->Colours.Parse(this->m_Sections["Colours"]);
-
-                // Objects
-                this->TimingPoints.Parse(this->m_Sections["TimingPoints"], !this->m_Sections["HitObjects"].empty());
+                OSU_PARSER_PHASE(Instrumentation::Phase::Tokenize);
+                Lines = Tokenizer::TokenizeSection(this->GetRanges(Section), Section == Section::Events);
+            }
+            Lines.SetFile(this->m_Lazy.Source->Buffer);
+            ParseLog Log(this->m_Lazy.Mode);
+            switch (Section)
+            {
+            // Sections
+            case Section::General: this->General.Parse(Lines, &Log);
+                break;
+            case Section::Metadata: this->Metadata.Parse(Lines, &Log);
+                break;
+            case Section::Editor: this->Editor.Parse(Lines, &Log);
+                break;
+            case Section::Difficulty: this->Difficulty.Parse(Lines, &Log);
+                break;
+            case Section::Colours: this->Colours.Parse(Lines, &Log);
+                break;
+            case Section::Variables: this->Variables.Parse(Lines, &Log);
+                break;
+            // Objects
+            case Section::TimingPoints:
+                // [HitObjects] may not have been read, sort unless it is known to be empty
+                this->TimingPoints.Parse(Lines, this->m_Lazy.Source->Partial
+                                         || Tokenizer::HasLines(this->GetRanges(Section::HitObjects)), &Log);
+                break;
+            case Section::HitObjects:
                 if (!TimingPoints.data.empty())
-                    this->HitObjects.Parse(this->m_Sections["HitObjects"],
-                                           this->Difficulty.SliderMultiplier, this->TimingPoints);
-                else this->HitObjects.Parse(this->m_Sections["HitObjects"]);
+                    this->HitObjects.Parse(Lines, this->Difficulty.SliderMultiplier, this->TimingPoints, &Log);
+                else this->HitObjects.Parse(Lines, true, &Log);
+                break;
+            case Section::Events: this->Events.Parse(Lines, this->Variables, &Log);
+                break;
+            default: break;
             }
-            this->Variables.Parse(this->m_Sections["Variables"]);
-            this->Events.Parse(this->m_Sections["Events"], this->Variables);
+
+            if (Log.Errors.empty()) return;
+            std::lock_guard Lock(this->m_Lazy.ErrorLock);
+            this->m_Lazy.Errors.insert(this->m_Lazy.Errors.end(), std::make_move_iterator(Log.Errors.begin()),
+                                       std::make_move_iterator(Log.Errors.end()));
         }
 
-    private:
         void Reset()
         {
             TimingPoints.data.clear();
             HitObjects.data.clear();
             Events.objects.clear();
+            std::lock_guard Lock(this->m_Lazy.ErrorLock);
+            this->m_Lazy.Errors.clear();
         }
 
     public:
-        std::int32_t Version = 14;
+        std::int32_t Version = 14; // of the file format, from the first line
+        std::string_view LineEnding = "\r\n"; // the one the file uses; only ever "\r\n" or "\n"
         // Sections
         Sections::General::GeneralSection General;
         Sections::Metadata::MetadataSection Metadata;
@@ -106,9 +575,6 @@ namespace OsuParser::Beatmap
         Objects::Event::Events Events;
 
     private:
-        using Sections = std::unordered_map<std::string, std::vector<std::string>>;
-
-        std::ifstream m_CurrentStream;
-        Sections m_Sections = {};
+        LazyState m_Lazy;
     };
 }
@@ -1,8 +1,12 @@
 #pragma once
 #define LEGACY 20140609
+#include <cstddef>
+#include <istream>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "Instrumentation.hpp"
 #include "Reader/Reader.hpp"
 #include "Structures/Database/BeatmapEntry.hpp"
 #include "Structures/Database/Enums.hpp"
@@ -19,6 +23,37 @@ namespace OsuParser
             {
                 return;
             }
+            this->Parse();
+        }
+
+        // Parses an osu!.db held in memory, in place; Buffer only has to outlive the constructor
+        explicit Database(const std::span<const std::byte> Buffer)
+        {
+            this->Reset();
+            this->m_Reader.SetBuffer(Buffer);
+            this->Parse();
+        }
+
+        // Reads an osu!.db from the current position of Stream
+        explicit Database(std::istream& Stream)
+        {
+            this->Reset();
+            if (!m_Reader.SetStream(Stream))
+            {
+                return;
+            }
+            this->Parse();
+        }
+
+        ~Database()
+        {
+            this->Reset();
+        }
+
+    private:
+        void Parse()
+        {
+            OSU_PARSER_PHASE(Instrumentation::Phase::DatabaseEntries);
             this->OsuVersion = this->m_Reader.ReadType<std::int32_t>();
             this->FolderCount = this->m_Reader.ReadType<std::int32_t>();
             this->AccountUnlocked = this->m_Reader.ReadType<bool>();
@@ -69,7 +104,7 @@ namespace OsuParser
                         std::int32_t Count = this->m_Reader.ReadType<std::int32_t>();
                         for (std::int32_t k = 0; k < Count; k++)
                         {
-                            this->m_Reader.Seek(this->OsuVersion > 2025107 ? 10 : 14);
+                            this->m_Reader.Seek(this->OsuVersion >= 20250107 ? 10 : 14); // int-float pairs since then
                         }
                     }
                 }
@@ -122,12 +157,7 @@ namespace OsuParser
             }
             this->Permissions = static_cast<Permission>(this->m_Reader.ReadType<std::int32_t>());
         }
-        ~Database()
-        {
-            this->Reset();
-        }
 
-    private:
         void Reset()
         {
             this->OsuVersion = 0;
@@ -0,0 +1,356 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Writer/TextWriter.hpp"
+
+/**
+ *  Load-phase instrumentation, compiled in only when OSU_PARSER_INSTRUMENTATION is defined before the first
+ *  include. Without it OSU_PARSER_PHASE expands to nothing and loading does exactly what it did before.
+ *
+ *  Allocation counts need operator new to be replaced, which can only happen once per program: define
+ *  OSU_PARSER_INSTRUMENTATION_ALLOCATIONS as well in exactly one translation unit (the way POCKETLZMA_LZMA_C_DEFINE
+ *  works). Without it phases report 0 allocations.
+ */
+#ifdef OSU_PARSER_INSTRUMENTATION
+#define OSU_PARSER_PHASE_CONCAT_(Left, Right) Left##Right
+#define OSU_PARSER_PHASE_CONCAT(Left, Right) OSU_PARSER_PHASE_CONCAT_(Left, Right)
+// Times the rest of the enclosing block as Which, an Instrumentation::Phase
+#define OSU_PARSER_PHASE(Which) \
+    const ::OsuParser::Instrumentation::Scope OSU_PARSER_PHASE_CONCAT(PhaseScope, __LINE__)(Which)
+// Same, but only adds to the summary: for phases entered once per line, which would flood a trace
+#define OSU_PARSER_PHASE_TOTAL(Which) \
+    const ::OsuParser::Instrumentation::Scope OSU_PARSER_PHASE_CONCAT(PhaseScope, __LINE__)(Which, false)
+#else
+#define OSU_PARSER_PHASE(Which) static_cast<void>(0)
+#define OSU_PARSER_PHASE_TOTAL(Which) static_cast<void>(0)
+#endif
+
+namespace OsuParser::Instrumentation
+{
+    enum class Phase : std::uint8_t
+    {
+        FileRead,
+        Tokenize,
+        // one per Beatmap section, in the order of Beatmap::Section
+        General,
+        Metadata,
+        Editor,
+        Difficulty,
+        Colours,
+        Variables,
+        TimingPoints,
+        HitObjects,
+        Events,
+        // nested in the ones above
+        SliderEndTimes, // inside HitObjects
+        VariableSubstitution, // inside Events, summary only
+        DatabaseEntries, // osu!.db entries, read from the file as they are parsed
+        LzmaDecode,
+        FrameParse,
+        Count
+    };
+
+    static constexpr std::size_t PHASE_COUNT = static_cast<std::size_t>(Phase::Count);
+
+    constexpr std::string_view GetPhaseName(const Phase Which)
+    {
+        constexpr std::array<std::string_view, PHASE_COUNT> NAMES = {
+            "FileRead", "Tokenize", "General", "Metadata", "Editor", "Difficulty", "Colours", "Variables",
+            "TimingPoints", "HitObjects", "Events", "SliderEndTimes", "VariableSubstitution", "DatabaseEntries",
+            "LzmaDecode", "FrameParse"};
+        return Which < Phase::Count ? NAMES[static_cast<std::size_t>(Which)] : std::string_view{};
+    }
+
+    constexpr bool ENABLED =
+#ifdef OSU_PARSER_INSTRUMENTATION
+        true;
+#else
+        false;
+#endif
+
+    // Everything recorded for a phase; nested phases are included in the ones around them
+    struct PhaseTotals
+    {
+        std::uint64_t Calls = 0;
+        std::uint64_t Nanoseconds = 0;
+        std::uint64_t Allocations = 0;
+        std::uint64_t AllocatedBytes = 0;
+    };
+
+    struct Summary
+    {
+        std::array<PhaseTotals, PHASE_COUNT> Phases = {};
+
+        [[nodiscard]] const PhaseTotals& operator[](const Phase Which) const
+        {
+            return this->Phases[static_cast<std::size_t>(Which)];
+        }
+
+        // One line per phase that ran: calls, milliseconds, allocations and allocated bytes
+        [[nodiscard]] std::string ToString() const
+        {
+            TextWriter Writer;
+            Writer.SetLineEnding("\n");
+            for (std::size_t Index = 0; Index < PHASE_COUNT; Index++)
+            {
+                const PhaseTotals& Totals = this->Phases[Index];
+                if (!Totals.Calls) continue;
+                const std::string_view Name = GetPhaseName(static_cast<Phase>(Index));
+                Writer << Name << std::string(22 - Name.size(), ' ') << Totals.Calls << " calls, "
+                    << static_cast<double>(Totals.Nanoseconds) / 1e6 << " ms, " << Totals.Allocations
+                    << " allocations, " << Totals.AllocatedBytes << " bytes";
+                Writer.NewLine();
+            }
+            return Writer.Take();
+        }
+    };
+
+    // Allocations made by the calling thread, counted by the operator new replacement when it is compiled in
+    struct AllocationCount
+    {
+        std::uint64_t Allocations = 0;
+        std::uint64_t Bytes = 0;
+    };
+
+    inline AllocationCount& GetThreadAllocations()
+    {
+        thread_local AllocationCount Count;
+        return Count;
+    }
+
+    /**
+     *  Collects the phases of every thread. Each thread appends to a buffer of its own, so recording only takes
+     *  an uncontended lock; GetSummary() and the trace export read all of them.
+     */
+    class Recorder
+    {
+    public:
+        struct Event
+        {
+            Phase Which = Phase::Count;
+            std::uint32_t Thread = 0;
+            std::uint64_t Start = 0; // nanoseconds since the recorder was created
+            std::uint64_t Duration = 0;
+            std::uint64_t Allocations = 0;
+            std::uint64_t AllocatedBytes = 0;
+        };
+
+        static Recorder& Get()
+        {
+            static Recorder Instance;
+            return Instance;
+        }
+
+        [[nodiscard]] std::uint64_t Now() const
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - this->m_Epoch).count());
+        }
+
+        // Adds Recorded to the summary, and to the trace when Traced
+        void Record(const Event& Recorded, const bool Traced)
+        {
+            ThreadBuffer& Buffer = this->GetBuffer();
+            std::lock_guard Lock(Buffer.Lock);
+            PhaseTotals& Totals = Buffer.Totals[static_cast<std::size_t>(Recorded.Which)];
+            ++Totals.Calls;
+            Totals.Nanoseconds += Recorded.Duration;
+            Totals.Allocations += Recorded.Allocations;
+            Totals.AllocatedBytes += Recorded.AllocatedBytes;
+            if (Traced)
+            {
+                Buffer.Events.push_back(Recorded);
+                Buffer.Events.back().Thread = Buffer.Id;
+            }
+        }
+
+        [[nodiscard]] Summary GetSummary() const
+        {
+            Summary Result;
+            std::lock_guard Lock(this->m_Lock);
+            for (const auto& Buffer : this->m_Buffers)
+            {
+                std::lock_guard BufferLock(Buffer->Lock);
+                for (std::size_t Index = 0; Index < PHASE_COUNT; Index++)
+                {
+                    const PhaseTotals& From = Buffer->Totals[Index];
+                    PhaseTotals& To = Result.Phases[Index];
+                    To.Calls += From.Calls;
+                    To.Nanoseconds += From.Nanoseconds;
+                    To.Allocations += From.Allocations;
+                    To.AllocatedBytes += From.AllocatedBytes;
+                }
+            }
+            return Result;
+        }
+
+        /**
+         *  Writes every traced phase as Chrome trace event JSON ("X" events, one track per thread, allocations in
+         *  args); open it in chrome://tracing or https://ui.perfetto.dev.
+         */
+        void WriteChromeTrace(std::ostream& Stream) const
+        {
+            TextWriter Writer(Stream);
+            Writer.SetLineEnding("\n");
+            Writer << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            bool First = true;
+            std::lock_guard Lock(this->m_Lock);
+            for (const auto& Buffer : this->m_Buffers)
+            {
+                std::lock_guard BufferLock(Buffer->Lock);
+                for (const Event& Recorded : Buffer->Events)
+                {
+                    if (!First) Writer << ',';
+                    First = false;
+                    Writer.NewLine();
+                    Writer << "{\"name\":\"" << GetPhaseName(Recorded.Which) << "\",\"cat\":\"osu!parser\",\"ph\":\"X\""
+                        << ",\"pid\":1,\"tid\":" << Recorded.Thread
+                        << ",\"ts\":" << static_cast<double>(Recorded.Start) / 1e3
+                        << ",\"dur\":" << static_cast<double>(Recorded.Duration) / 1e3
+                        << ",\"args\":{\"allocations\":" << Recorded.Allocations
+                        << ",\"bytes\":" << Recorded.AllocatedBytes << "}}";
+                }
+            }
+            Writer.NewLine();
+            Writer << "]}";
+            Writer.NewLine();
+        }
+
+        [[nodiscard]] std::string ToChromeTrace() const
+        {
+            std::ostringstream Stream;
+            this->WriteChromeTrace(Stream);
+            return Stream.str();
+        }
+
+        // Forgets everything recorded so far, of every thread
+        void Reset()
+        {
+            std::lock_guard Lock(this->m_Lock);
+            for (const auto& Buffer : this->m_Buffers)
+            {
+                std::lock_guard BufferLock(Buffer->Lock);
+                Buffer->Events.clear();
+                Buffer->Totals = {};
+            }
+        }
+
+    private:
+        struct ThreadBuffer
+        {
+            std::uint32_t Id = 0;
+            std::mutex Lock;
+            std::vector<Event> Events;
+            std::array<PhaseTotals, PHASE_COUNT> Totals = {};
+        };
+
+        Recorder() = default;
+
+        // Buffers outlive their threads, so nothing recorded is lost when a pool shuts down
+        ThreadBuffer& GetBuffer()
+        {
+            thread_local ThreadBuffer* Buffer = nullptr;
+            if (Buffer) return *Buffer;
+            std::lock_guard Lock(this->m_Lock);
+            auto& Added = this->m_Buffers.emplace_back(std::make_unique<ThreadBuffer>());
+            Added->Id = static_cast<std::uint32_t>(this->m_Buffers.size());
+            Buffer = Added.get();
+            return *Buffer;
+        }
+
+        std::chrono::steady_clock::time_point m_Epoch = std::chrono::steady_clock::now();
+        mutable std::mutex m_Lock;
+        std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+    };
+
+    // Records the time and allocations between its construction and destruction as one phase
+    class Scope
+    {
+    public:
+        explicit Scope(const Phase Which, const bool Traced = true)
+            : m_Which(Which), m_Traced(Traced), m_Allocations(GetThreadAllocations()),
+              m_Start(Recorder::Get().Now())
+        {
+        }
+
+        ~Scope()
+        {
+            Recorder& Target = Recorder::Get();
+            const AllocationCount& Allocations = GetThreadAllocations();
+            Recorder::Event Recorded;
+            Recorded.Which = this->m_Which;
+            Recorded.Start = this->m_Start;
+            Recorded.Duration = Target.Now() - this->m_Start;
+            Recorded.Allocations = Allocations.Allocations - this->m_Allocations.Allocations;
+            Recorded.AllocatedBytes = Allocations.Bytes - this->m_Allocations.Bytes;
+            Target.Record(Recorded, this->m_Traced);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Phase m_Which;
+        bool m_Traced;
+        AllocationCount m_Allocations;
+        std::uint64_t m_Start;
+    };
+
+    // Shorthands for Recorder::Get()
+    inline Summary GetSummary()
+    {
+        return Recorder::Get().GetSummary();
+    }
+
+    inline void WriteChromeTrace(std::ostream& Stream)
+    {
+        Recorder::Get().WriteChromeTrace(Stream);
+    }
+
+    inline void Reset()
+    {
+        Recorder::Get().Reset();
+    }
+}
+
+#if defined(OSU_PARSER_INSTRUMENTATION) && defined(OSU_PARSER_INSTRUMENTATION_ALLOCATIONS)
+#include <cstdlib>
+#include <new>
+
+// The array and nothrow forms forward to these; aligned allocations are not counted
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // malloc/free seen through the replacement
+#endif
+void* operator new(const std::size_t Size)
+{
+    OsuParser::Instrumentation::AllocationCount& Count = OsuParser::Instrumentation::GetThreadAllocations();
+    ++Count.Allocations;
+    Count.Bytes += Size;
+    if (void* Memory = std::malloc(Size ? Size : 1)) return Memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* Memory) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept
+{
+    std::free(Memory);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
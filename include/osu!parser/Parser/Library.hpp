@@ -0,0 +1,283 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Beatmap.hpp"
+#include "Database.hpp"
+#include "ThreadPool.hpp"
+#include "Reader/Md5.hpp"
+
+namespace OsuParser
+{
+    struct LibraryOptions
+    {
+        std::uint32_t Threads = 0; // 0 = hardware concurrency
+        Beatmap::Section Sections = Beatmap::Section::All;
+        ParseMode Parsing = ParseMode::Lenient; // in Strict mode a file with any bad line fails its entry
+        // Called after every file with (finished, total), one call at a time, from the worker that finished it
+        std::function<void(std::size_t, std::size_t)> OnProgress;
+        std::stop_token StopToken; // files not started when a stop is requested are reported as cancelled
+    };
+
+    struct LibraryEntry
+    {
+        std::filesystem::path Path;
+        std::optional<Beatmap::Beatmap> Beatmap; // empty when the file failed or was cancelled
+        std::string Error;
+        std::vector<ParseError> ParseErrors; // bad lines, skipped in Lenient mode
+        bool Cancelled = false;
+        double Milliseconds = 0; // read and parse time of this file
+    };
+
+    // An osu!.db entry or a replay whose .osu is not the one it was recorded against
+    struct HashMismatch
+    {
+        std::size_t Index = 0; // into Database::Beatmaps, or into the replays that were checked
+        std::filesystem::path Path; // empty for a replay of a beatmap osu!.db does not know
+        std::string Expected;
+        std::string Actual; // empty when the file is missing
+    };
+
+    struct VerifyReport
+    {
+        std::size_t Matched = 0;
+        std::vector<HashMismatch> Mismatched; // the file was changed since it was recorded
+        std::vector<HashMismatch> Missing; // no readable file at Path, or no Path at all
+        std::size_t Cancelled = 0; // not checked because a stop was requested
+    };
+
+    /**
+     *  Loads whole Songs folders. Files are parsed on a WorkStealingPool straight into a result vector sized up
+     *  front, in the order of the input list; a file that fails only fails its own entry.
+     */
+    class Library
+    {
+    public:
+        // Every .osu below SongsPath, sorted; unreadable directories are skipped
+        static std::vector<std::filesystem::path> FindBeatmaps(const std::filesystem::path& SongsPath)
+        {
+            std::vector<std::filesystem::path> Files;
+            std::error_code Error;
+            std::filesystem::recursive_directory_iterator Iterator(
+                SongsPath, std::filesystem::directory_options::skip_permission_denied, Error);
+            for (const std::filesystem::recursive_directory_iterator End; !Error && Iterator != End;
+                 Iterator.increment(Error))
+            {
+                if (Iterator->is_regular_file(Error) && IsBeatmap(Iterator->path())) Files.push_back(Iterator->path());
+            }
+            std::ranges::sort(Files);
+            return Files;
+        }
+
+        // Whether Path names a .osu, in any case
+        static bool IsBeatmap(const std::filesystem::path& Path)
+        {
+            std::string Extension = Path.extension().string();
+            std::ranges::transform(Extension, Extension.begin(),
+                                   [](const unsigned char Character) { return std::tolower(Character); });
+            return Extension == ".osu";
+        }
+
+        static std::vector<LibraryEntry> Load(const std::filesystem::path& SongsPath,
+                                              const LibraryOptions& Options = {})
+        {
+            return Load(FindBeatmaps(SongsPath), Options);
+        }
+
+        static std::vector<LibraryEntry> Load(const std::vector<std::filesystem::path>& Files,
+                                              const LibraryOptions& Options = {})
+        {
+            WorkStealingPool Pool(Options.Threads);
+            return Load(Files, Pool, Options);
+        }
+
+        // Same, on a pool the caller keeps around between loads
+        static std::vector<LibraryEntry> Load(const std::vector<std::filesystem::path>& Files, WorkStealingPool& Pool,
+                                              const LibraryOptions& Options = {})
+        {
+            std::vector<LibraryEntry> Entries(Files.size());
+            std::mutex ProgressLock;
+            std::size_t Finished = 0;
+
+            Pool.Run(Files.size(), [&](const std::size_t Index, std::uint32_t)
+            {
+                LibraryEntry& Entry = Entries[Index];
+                Entry.Path = Files[Index];
+                if (Options.StopToken.stop_requested()) Entry.Cancelled = true;
+                else LoadFile(Entry, Options);
+
+                if (!Options.OnProgress) return;
+                std::lock_guard Lock(ProgressLock);
+                Options.OnProgress(++Finished, Files.size());
+            });
+            return Entries;
+        }
+
+        /**
+         *  Checks every .osu osu!.db lists (SongsPath / FolderName / BeatmapPath) against its BeatmapHash. Files
+         *  are read once each and hashed in batches, several files side by side per SIMD lane (Md5::HashMany);
+         *  Options.Sections and Options.Parsing are not used.
+         */
+        static VerifyReport Verify(const Database& Database, const std::filesystem::path& SongsPath,
+                                   const LibraryOptions& Options = {})
+        {
+            std::vector<std::filesystem::path> Files;
+            Files.reserve(Database.Beatmaps.size());
+            for (const BeatmapEntry& Entry : Database.Beatmaps) Files.push_back(GetPath(Entry, SongsPath));
+            const std::vector<FileHash> Hashes = HashFiles(Files, Options);
+
+            VerifyReport Report;
+            for (std::size_t Index = 0; Index < Files.size(); Index++)
+                Compare(Report, {Index, Files[Index], Database.Beatmaps[Index].BeatmapHash, {}}, Hashes[Index]);
+            return Report;
+        }
+
+        /**
+         *  Checks the .osu files replays were played on, given their Replay::BeatmapHash: each hash has to name an
+         *  osu!.db entry (Missing with an empty Path otherwise) whose file still has that hash. Every file is
+         *  hashed once, however many of the replays use it.
+         */
+        static VerifyReport Verify(const std::span<const std::string> BeatmapHashes, const Database& Database,
+                                   const std::filesystem::path& SongsPath, const LibraryOptions& Options = {})
+        {
+            std::unordered_map<std::string_view, std::size_t> Entries; // hash -> index into Database::Beatmaps
+            Entries.reserve(Database.Beatmaps.size());
+            for (std::size_t Index = 0; Index < Database.Beatmaps.size(); Index++)
+                Entries.emplace(Database.Beatmaps[Index].BeatmapHash, Index);
+
+            std::unordered_map<std::size_t, std::size_t> Checked; // entry -> index into Files
+            std::vector<std::filesystem::path> Files;
+            std::vector<std::size_t> FileOf(BeatmapHashes.size(), SIZE_MAX);
+            for (std::size_t Index = 0; Index < BeatmapHashes.size(); Index++)
+            {
+                const auto Entry = Entries.find(BeatmapHashes[Index]);
+                if (Entry == Entries.end()) continue;
+                const auto [File, Added] = Checked.emplace(Entry->second, Files.size());
+                if (Added) Files.push_back(GetPath(Database.Beatmaps[Entry->second], SongsPath));
+                FileOf[Index] = File->second;
+            }
+            const std::vector<FileHash> Hashes = HashFiles(Files, Options);
+
+            VerifyReport Report;
+            for (std::size_t Index = 0; Index < BeatmapHashes.size(); Index++)
+            {
+                HashMismatch Check{Index, {}, BeatmapHashes[Index], {}};
+                if (FileOf[Index] == SIZE_MAX) Report.Missing.push_back(std::move(Check));
+                else
+                {
+                    Check.Path = Files[FileOf[Index]];
+                    Compare(Report, std::move(Check), Hashes[FileOf[Index]]);
+                }
+            }
+            return Report;
+        }
+
+    private:
+        // What HashFiles found for one file; an empty Hash without Cancelled means it could not be read
+        struct FileHash
+        {
+            std::string Hash;
+            bool Cancelled = false;
+        };
+
+        // Files hashed per pool task, a few per lane so lanes are refilled from the same batch
+        static constexpr std::size_t HASH_BATCH = 32;
+
+        static std::filesystem::path GetPath(const BeatmapEntry& Entry, const std::filesystem::path& SongsPath)
+        {
+            // osu!.db strings are UTF-8
+            const auto Utf8 = [](const std::string& Name) { return std::u8string(Name.begin(), Name.end()); };
+            return SongsPath / Utf8(Entry.FolderName) / Utf8(Entry.BeatmapPath);
+        }
+
+        static std::vector<FileHash> HashFiles(const std::vector<std::filesystem::path>& Files,
+                                               const LibraryOptions& Options)
+        {
+            std::vector<FileHash> Hashes(Files.size());
+            std::mutex ProgressLock;
+            std::size_t Finished = 0;
+
+            WorkStealingPool Pool(Options.Threads);
+            Pool.Run((Files.size() + HASH_BATCH - 1) / HASH_BATCH, [&](const std::size_t Batch, std::uint32_t)
+            {
+                const std::size_t Begin = Batch * HASH_BATCH, End = std::min(Begin + HASH_BATCH, Files.size());
+                if (Options.StopToken.stop_requested())
+                    for (std::size_t Index = Begin; Index < End; Index++) Hashes[Index].Cancelled = true;
+                else
+                {
+                    std::vector<std::string> Buffers;
+                    std::vector<std::string_view> Views;
+                    std::vector<std::size_t> Indices;
+                    for (std::size_t Index = Begin; Index < End; Index++)
+                    {
+                        std::ifstream Stream(Files[Index], std::ios::binary);
+                        if (!Stream.good()) continue;
+                        Buffers.push_back(Tokenizer::ReadStream(Stream));
+                        Indices.push_back(Index);
+                    }
+                    Views.assign(Buffers.begin(), Buffers.end());
+                    const std::vector<Md5::Digest> Digests = Md5::HashMany(Views);
+                    for (std::size_t i = 0; i < Indices.size(); i++) Hashes[Indices[i]].Hash = Md5::ToHex(Digests[i]);
+                }
+
+                if (!Options.OnProgress) return;
+                std::lock_guard Lock(ProgressLock);
+                for (std::size_t Index = Begin; Index < End; Index++) Options.OnProgress(++Finished, Files.size());
+            });
+            return Hashes;
+        }
+
+        static void Compare(VerifyReport& Report, HashMismatch Check, const FileHash& Hash)
+        {
+            if (Hash.Cancelled) ++Report.Cancelled;
+            else if (Hash.Hash.empty()) Report.Missing.push_back(std::move(Check));
+            else if (Hash.Hash == Check.Expected) ++Report.Matched;
+            else
+            {
+                Check.Actual = Hash.Hash;
+                Report.Mismatched.push_back(std::move(Check));
+            }
+        }
+
+        static void LoadFile(LibraryEntry& Entry, const LibraryOptions& Options)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            try
+            {
+                std::ifstream Stream(Entry.Path, std::ios::binary);
+                if (!Stream.good()) Entry.Error = "cannot open file";
+                else
+                {
+                    Entry.Beatmap.emplace(Stream, Options.Sections, Options.Parsing);
+                    Entry.ParseErrors = Entry.Beatmap->GetErrors();
+                    if (Options.Parsing == ParseMode::Strict && !Entry.ParseErrors.empty())
+                    {
+                        Entry.Beatmap.reset();
+                        Entry.Error = Entry.ParseErrors.front().ToString();
+                    }
+                }
+            }
+            catch (const std::exception& Exception)
+            {
+                Entry.Beatmap.reset();
+                Entry.Error = Exception.what();
+            }
+            Entry.Milliseconds =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        }
+    };
+}
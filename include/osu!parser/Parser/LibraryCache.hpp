@@ -0,0 +1,463 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Library.hpp"
+
+namespace OsuParser
+{
+    enum class LibraryChangeKind : std::uint8_t
+    {
+        Added,
+        Modified,
+        Removed
+    };
+
+    struct LibraryChange
+    {
+        std::filesystem::path Path;
+        LibraryChangeKind Kind = LibraryChangeKind::Added;
+        std::uint64_t Generation = 0;
+    };
+
+    // One .osu of a LibraryCache, as of the last refresh that found it changed
+    struct CachedBeatmap
+    {
+        std::shared_ptr<const Beatmap::Beatmap> Beatmap; // null when the file failed
+        std::string Error;
+        std::vector<ParseError> ParseErrors; // bad lines, skipped in Lenient mode
+        std::string Hash; // MD5 of the content, lowercase hex
+        std::filesystem::file_time_type ModifiedTime;
+        std::uintmax_t Size = 0;
+        std::uint64_t Generation = 0; // the one in which it was last added or modified
+    };
+
+    /**
+     *  A parsed Songs folder that is kept up to date instead of being loaded again.
+     *
+     *  Refresh() collects the files that may have changed and parses only the ones whose content did. On Linux
+     *  inotify names the edited files, so a refresh costs as much as the edits made since the previous one.
+     *  Elsewhere, or when the kernel dropped events, every file is stat'ed and only the ones whose modification
+     *  time or size moved are read. A file that was touched but still has the same MD5 is not parsed again.
+     *
+     *  Every refresh that changes something starts a new generation, and GetChanges() lists what happened after
+     *  a given one. Readers may run alongside Refresh(), which parses on its own pool and only locks to publish.
+     */
+    class LibraryCache
+    {
+    public:
+        explicit LibraryCache(std::filesystem::path SongsPath, LibraryOptions Options = {})
+            : m_SongsPath(std::move(SongsPath)), m_Options(std::move(Options)), m_Pool(this->m_Options.Threads)
+        {
+#ifdef __linux__
+            this->m_Watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        }
+
+        ~LibraryCache()
+        {
+            this->StopWatching();
+        }
+
+        LibraryCache(const LibraryCache&) = delete;
+        LibraryCache& operator=(const LibraryCache&) = delete;
+
+        // Brings the cache up to date with the folder, the first call loads all of it; returns the generation
+        std::uint64_t Refresh()
+        {
+            std::lock_guard Lock(this->m_RefreshLock);
+            std::set<std::filesystem::path> Candidates = std::move(this->m_Retry);
+            this->m_Retry.clear();
+            if (!this->m_Scanned || !this->ReadEvents(Candidates)) this->Scan(Candidates);
+            return this->Update(Candidates);
+        }
+
+        // Compares every file with what is cached, for when changes may have been missed; returns the generation
+        std::uint64_t Rescan()
+        {
+            std::lock_guard Lock(this->m_RefreshLock);
+            std::set<std::filesystem::path> Candidates = std::move(this->m_Retry);
+            this->m_Retry.clear();
+            this->ReadEvents(Candidates);
+            this->Scan(Candidates);
+            return this->Update(Candidates);
+        }
+
+        [[nodiscard]] std::uint64_t GetGeneration() const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            return this->m_Generation;
+        }
+
+        // Whether changes come from inotify; false before the first Refresh() and off Linux
+        [[nodiscard]] bool IsWatching() const
+        {
+            return this->m_Watch >= 0 && this->m_Scanned;
+        }
+
+        [[nodiscard]] std::size_t GetCount() const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            return this->m_Entries.size();
+        }
+
+        // The parsed beatmap at Path, null when it is not cached or failed
+        [[nodiscard]] std::shared_ptr<const Beatmap::Beatmap> Find(const std::filesystem::path& Path) const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            const auto Iterator = this->m_Entries.find(Path);
+            return Iterator != this->m_Entries.end() ? Iterator->second.Beatmap : nullptr;
+        }
+
+        [[nodiscard]] std::optional<CachedBeatmap> GetEntry(const std::filesystem::path& Path) const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            const auto Iterator = this->m_Entries.find(Path);
+            if (Iterator == this->m_Entries.end()) return std::nullopt;
+            return Iterator->second;
+        }
+
+        // Calls Function for every cached file, sorted by path; the cache cannot be refreshed meanwhile
+        void ForEach(const std::function<void(const std::filesystem::path&, const CachedBeatmap&)>& Function) const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            for (const auto& [Path, Entry] : this->m_Entries) Function(Path, Entry);
+        }
+
+        /**
+         *  What changed after generation Since, one change per file: the last one, so a file added and removed
+         *  since then is only reported as removed. In the order the changes were made.
+         */
+        [[nodiscard]] std::vector<LibraryChange> GetChanges(const std::uint64_t Since) const
+        {
+            std::shared_lock Lock(this->m_Lock);
+            const auto First = std::ranges::upper_bound(this->m_Changes, Since, {}, &LibraryChange::Generation);
+            std::unordered_map<std::filesystem::path, std::size_t, PathHash> Latest;
+            for (auto Iterator = First; Iterator != this->m_Changes.end(); ++Iterator)
+                Latest[Iterator->Path] = static_cast<std::size_t>(Iterator - this->m_Changes.begin());
+
+            std::vector<LibraryChange> Changes;
+            Changes.reserve(Latest.size());
+            for (auto Iterator = First; Iterator != this->m_Changes.end(); ++Iterator)
+                if (Latest[Iterator->Path] == static_cast<std::size_t>(Iterator - this->m_Changes.begin()))
+                    Changes.push_back(*Iterator);
+            return Changes;
+        }
+
+        // Drops the change log up to generation UpTo, once every reader has seen it; GetChanges(UpTo) keeps working
+        void ForgetChanges(const std::uint64_t UpTo)
+        {
+            std::unique_lock Lock(this->m_Lock);
+            const auto Last = std::ranges::upper_bound(this->m_Changes, UpTo, {}, &LibraryChange::Generation);
+            this->m_Changes.erase(this->m_Changes.begin(), Last);
+        }
+
+    private:
+        struct PathHash
+        {
+            std::size_t operator()(const std::filesystem::path& Path) const
+            {
+                return std::filesystem::hash_value(Path);
+            }
+        };
+
+        // A file Update() reads again
+        struct Work
+        {
+            std::filesystem::path Path;
+            std::filesystem::file_time_type ModifiedTime{};
+            std::uintmax_t Size = 0;
+            std::string PreviousHash{}; // empty when it is new
+            CachedBeatmap Result{};
+            bool Unchanged = false; // same content, only the stat moved
+            bool Cancelled = false;
+        };
+
+#ifdef __linux__
+        static constexpr std::uint32_t WATCH_MASK =
+            IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+#endif
+
+        static bool IsInside(const std::filesystem::path& Path, const std::filesystem::path& Directory)
+        {
+            const auto [DirectoryEnd, PathEnd] = std::mismatch(Directory.begin(), Directory.end(), Path.begin(),
+                                                                Path.end());
+            return DirectoryEnd == Directory.end() && PathEnd != Path.end();
+        }
+
+        void StopWatching()
+        {
+#ifdef __linux__
+            if (this->m_Watch >= 0) close(this->m_Watch);
+#endif
+            this->m_Watch = -1;
+            this->m_Directories.clear();
+            this->m_Watched.clear();
+        }
+
+        // Watches Directory unless it already is; inotify running out of watches turns watching off
+        void Watch(const std::filesystem::path& Directory)
+        {
+#ifdef __linux__
+            if (this->m_Watch < 0 || this->m_Watched.contains(Directory)) return;
+            const int Descriptor = inotify_add_watch(this->m_Watch, Directory.c_str(), WATCH_MASK);
+            if (Descriptor < 0)
+            {
+                if (errno == ENOSPC || errno == ENOMEM) this->StopWatching();
+                return;
+            }
+            this->m_Directories[Descriptor] = Directory;
+            this->m_Watched[Directory] = Descriptor;
+#else
+            static_cast<void>(Directory);
+#endif
+        }
+
+        void Unwatch(const std::filesystem::path& Directory)
+        {
+#ifdef __linux__
+            for (auto Iterator = this->m_Watched.lower_bound(Directory); Iterator != this->m_Watched.end();)
+            {
+                if (Iterator->first != Directory && !IsInside(Iterator->first, Directory)) break;
+                inotify_rm_watch(this->m_Watch, Iterator->second);
+                this->m_Directories.erase(Iterator->second);
+                Iterator = this->m_Watched.erase(Iterator);
+            }
+#else
+            static_cast<void>(Directory);
+#endif
+        }
+
+        // Every .osu below Directory becomes a candidate, and every directory below it is watched
+        void ScanDirectory(const std::filesystem::path& Directory, std::set<std::filesystem::path>& Candidates)
+        {
+            this->Watch(Directory); // before listing it, so nothing created meanwhile is missed
+            std::error_code Error;
+            std::filesystem::recursive_directory_iterator Iterator(
+                Directory, std::filesystem::directory_options::skip_permission_denied, Error);
+            for (const std::filesystem::recursive_directory_iterator End; !Error && Iterator != End;
+                 Iterator.increment(Error))
+            {
+                if (Iterator->is_directory(Error)) this->Watch(Iterator->path());
+                else if (Iterator->is_regular_file(Error) && Library::IsBeatmap(Iterator->path()))
+                    Candidates.insert(Iterator->path());
+            }
+        }
+
+        // The whole folder, plus every cached file so the ones that are gone are noticed
+        void Scan(std::set<std::filesystem::path>& Candidates)
+        {
+            this->ScanDirectory(this->m_SongsPath, Candidates);
+            this->m_Scanned = true;
+            std::shared_lock Lock(this->m_Lock);
+            for (const auto& [Path, Entry] : this->m_Entries) Candidates.insert(Path);
+        }
+
+        /**
+         *  Turns the pending inotify events into candidates. False when the events cannot be trusted to be
+         *  complete (not watching, or the kernel queue overflowed) and the folder has to be scanned instead.
+         */
+        bool ReadEvents(std::set<std::filesystem::path>& Candidates)
+        {
+#ifdef __linux__
+            if (this->m_Watch < 0) return false;
+            bool Complete = true;
+            alignas(inotify_event) char Events[64 * 1024];
+            for (;;)
+            {
+                const ssize_t Length = read(this->m_Watch, Events, sizeof(Events));
+                if (Length <= 0) break;
+                for (const char* Position = Events; Position < Events + Length;)
+                {
+                    const auto* Event = reinterpret_cast<const inotify_event*>(Position);
+                    Position += sizeof(inotify_event) + Event->len;
+                    if (Event->mask & IN_Q_OVERFLOW) Complete = false;
+                    const auto Directory = this->m_Directories.find(Event->wd);
+                    if (Directory == this->m_Directories.end()) continue;
+                    if (Event->mask & (IN_IGNORED | IN_DELETE_SELF))
+                    {
+                        this->m_Watched.erase(Directory->second);
+                        this->m_Directories.erase(Directory);
+                        continue;
+                    }
+                    if (!Event->len) continue;
+
+                    const std::filesystem::path Path = Directory->second / Event->name;
+                    if (!(Event->mask & IN_ISDIR))
+                    {
+                        if (!(Event->mask & IN_CREATE) && Library::IsBeatmap(Path)) Candidates.insert(Path);
+                        continue;
+                    }
+                    if (Event->mask & (IN_CREATE | IN_MOVED_TO)) this->ScanDirectory(Path, Candidates);
+                    if (Event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    {
+                        this->Unwatch(Path);
+                        std::shared_lock Lock(this->m_Lock);
+                        for (auto Entry = this->m_Entries.upper_bound(Path);
+                             Entry != this->m_Entries.end() && IsInside(Entry->first, Path); ++Entry)
+                            Candidates.insert(Entry->first);
+                    }
+                }
+            }
+            if (!Complete)
+            {
+                // watches may be gone along with the events; start over with fresh ones
+                this->StopWatching();
+                this->m_Watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            }
+            return Complete;
+#else
+            static_cast<void>(Candidates);
+            return false;
+#endif
+        }
+
+        // Stats the candidates, reads and parses the ones that moved, and publishes the result
+        std::uint64_t Update(const std::set<std::filesystem::path>& Candidates)
+        {
+            std::vector<Work> Changed;
+            std::vector<std::filesystem::path> Removed;
+            {
+                std::shared_lock Lock(this->m_Lock);
+                for (const std::filesystem::path& Path : Candidates)
+                {
+                    const auto Cached = this->m_Entries.find(Path);
+                    Work Item{Path};
+                    std::error_code Error;
+                    const bool Exists = std::filesystem::is_regular_file(Path, Error);
+                    if (Exists) Item.ModifiedTime = std::filesystem::last_write_time(Path, Error);
+                    if (Exists && !Error) Item.Size = std::filesystem::file_size(Path, Error);
+                    if (!Exists || Error)
+                    {
+                        if (Cached != this->m_Entries.end()) Removed.push_back(Path);
+                        continue;
+                    }
+                    if (Cached != this->m_Entries.end())
+                    {
+                        if (Cached->second.ModifiedTime == Item.ModifiedTime && Cached->second.Size == Item.Size)
+                            continue;
+                        Item.PreviousHash = Cached->second.Hash;
+                    }
+                    Changed.push_back(std::move(Item));
+                }
+            }
+
+            std::mutex ProgressLock;
+            std::size_t Finished = 0;
+            this->m_Pool.Run(Changed.size(), [&](const std::size_t Index, std::uint32_t)
+            {
+                Work& Item = Changed[Index];
+                if (this->m_Options.StopToken.stop_requested()) Item.Cancelled = true;
+                else this->Load(Item);
+
+                if (!this->m_Options.OnProgress) return;
+                std::lock_guard Lock(ProgressLock);
+                this->m_Options.OnProgress(++Finished, Changed.size());
+            });
+
+            std::unique_lock Lock(this->m_Lock);
+            const std::uint64_t Generation = this->m_Generation + 1;
+            bool Any = false;
+            for (const std::filesystem::path& Path : Removed)
+            {
+                this->m_Entries.erase(Path);
+                this->m_Changes.push_back({Path, LibraryChangeKind::Removed, Generation});
+                Any = true;
+            }
+            for (Work& Item : Changed)
+            {
+                if (Item.Cancelled)
+                {
+                    this->m_Retry.insert(std::move(Item.Path));
+                    continue;
+                }
+                auto [Entry, Added] = this->m_Entries.try_emplace(Item.Path);
+                if (Item.Unchanged)
+                {
+                    Entry->second.ModifiedTime = Item.ModifiedTime;
+                    Entry->second.Size = Item.Size;
+                    continue;
+                }
+                Item.Result.Generation = Generation;
+                Entry->second = std::move(Item.Result);
+                this->m_Changes.push_back({std::move(Item.Path),
+                                           Added ? LibraryChangeKind::Added : LibraryChangeKind::Modified, Generation});
+                Any = true;
+            }
+            if (Any) this->m_Generation = Generation;
+            return this->m_Generation;
+        }
+
+        // Reads Item once, hashing it on the way, and parses it unless the hash is the one already cached
+        void Load(Work& Item) const
+        {
+            Md5 Hash;
+            std::ifstream Stream(Item.Path, std::ios::binary);
+            const std::string Buffer = Tokenizer::ReadStream(Stream, Hash);
+            CachedBeatmap& Result = Item.Result;
+            Result.Hash = Md5::ToHex(Hash.Finish());
+            Result.ModifiedTime = Item.ModifiedTime;
+            Result.Size = Item.Size;
+            if (Result.Hash == Item.PreviousHash)
+            {
+                Item.Unchanged = true;
+                return;
+            }
+
+            try
+            {
+                auto Parsed = std::make_shared<Beatmap::Beatmap>(
+                    std::span(reinterpret_cast<const std::byte*>(Buffer.data()), Buffer.size()),
+                    this->m_Options.Sections, this->m_Options.Parsing);
+                Result.ParseErrors = Parsed->GetErrors();
+                if (this->m_Options.Parsing == ParseMode::Strict && !Result.ParseErrors.empty())
+                    Result.Error = Result.ParseErrors.front().ToString();
+                else Result.Beatmap = std::move(Parsed);
+            }
+            catch (const std::exception& Exception)
+            {
+                Result.Error = Exception.what();
+            }
+        }
+
+        std::filesystem::path m_SongsPath;
+        LibraryOptions m_Options;
+        WorkStealingPool m_Pool;
+
+        // Guards what readers see: the entries, the generation and the change log
+        mutable std::shared_mutex m_Lock;
+        std::map<std::filesystem::path, CachedBeatmap> m_Entries;
+        std::vector<LibraryChange> m_Changes; // in generation order
+        std::uint64_t m_Generation = 0;
+
+        // Only touched by the refreshing thread; m_Scanned and m_Watch are also read by IsWatching()
+        std::mutex m_RefreshLock;
+        std::atomic<bool> m_Scanned = false;
+        std::set<std::filesystem::path> m_Retry; // cancelled by the stop token last time
+        std::atomic<int> m_Watch = -1; // inotify descriptor
+        std::unordered_map<int, std::filesystem::path> m_Directories; // watch descriptor -> directory
+        std::map<std::filesystem::path, int> m_Watched;
+    };
+}
@@ -0,0 +1,294 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Beatmap.hpp"
+#include "Reader/Inflate.hpp"
+
+namespace OsuParser
+{
+    struct ArchiveEntry
+    {
+        std::string Name;
+        std::uint16_t Method = 0; // 0 = stored, 8 = deflate
+        std::uint32_t Crc32 = 0;
+        std::uint64_t CompressedSize = 0;
+        std::uint64_t Size = 0;
+        std::uint64_t LocalHeaderOffset = 0;
+
+        [[nodiscard]] bool HasExtension(const std::string_view Extension) const
+        {
+            if (this->Name.size() < Extension.size()) return false;
+            return std::equal(Extension.begin(), Extension.end(), this->Name.end() - Extension.size(),
+                              [](const char Left, const char Right)
+                              {
+                                  return std::tolower(static_cast<unsigned char>(Left))
+                                      == std::tolower(static_cast<unsigned char>(Right));
+                              });
+        }
+    };
+
+    /**
+     *  Reads an .osz (a zip archive) without extracting it.
+     *
+     *  Only the central directory is read up front. Entry data is read on request: stored entries of an in-memory
+     *  archive are returned in place, deflated ones are inflated into a caller-provided string. When opened from a
+     *  path, only the end of the file and the requested entries are read, so audio and background bytes are never
+     *  touched. Zip64 sizes and offsets are understood, archives split over several disks are not.
+     */
+    class Osz
+    {
+    public:
+        static constexpr std::uint64_t MAX_ENTRY_SIZE = 256ull * 1024 * 1024; // inflate limit, against zip bombs
+
+        explicit Osz(const std::string& OszPath)
+        {
+            this->m_File = std::ifstream(OszPath, std::ios::binary | std::ios::ate);
+            if (!this->m_File.good()) return;
+            this->m_Size = static_cast<std::uint64_t>(this->m_File.tellg());
+            this->ReadDirectory();
+        }
+
+        // Reads an archive held in memory, in place; Buffer has to outlive the Osz
+        explicit Osz(const std::span<const std::byte> Buffer) : m_Buffer(Buffer), m_Size(Buffer.size())
+        {
+            this->ReadDirectory();
+        }
+
+        [[nodiscard]] bool IsValid() const
+        {
+            return this->m_Valid;
+        }
+
+        [[nodiscard]] const ArchiveEntry* Find(const std::string_view Name) const
+        {
+            const auto Iterator = std::ranges::find(this->Entries, Name, &ArchiveEntry::Name);
+            return Iterator != this->Entries.end() ? &*Iterator : nullptr;
+        }
+
+        // Every .osu entry, in directory order
+        [[nodiscard]] std::vector<const ArchiveEntry*> GetDifficulties() const
+        {
+            std::vector<const ArchiveEntry*> Difficulties;
+            for (const ArchiveEntry& Entry : this->Entries)
+                if (Entry.HasExtension(".osu")) Difficulties.push_back(&Entry);
+            return Difficulties;
+        }
+
+        [[nodiscard]] const ArchiveEntry* GetStoryboard() const
+        {
+            for (const ArchiveEntry& Entry : this->Entries)
+                if (Entry.HasExtension(".osb")) return &Entry;
+            return nullptr;
+        }
+
+        /**
+         *  The uncompressed bytes of Entry. Stored entries of an in-memory archive point into it, everything else
+         *  is read or inflated into Scratch. Empty if the entry is corrupt, uses another method or fails its CRC.
+         */
+        std::optional<std::string_view> Read(const ArchiveEntry& Entry, std::string& Scratch)
+        {
+            if (Entry.Method != 0 && Entry.Method != 8) return std::nullopt;
+            if (Entry.Size > MAX_ENTRY_SIZE) return std::nullopt;
+
+            std::string Raw;
+            const std::optional<std::string_view> Data = this->ReadData(Entry, Raw);
+            if (!Data) return std::nullopt;
+
+            std::string_view Output;
+            if (Entry.Method == 0)
+            {
+                if (Data->size() != Entry.Size) return std::nullopt;
+                if (Raw.empty()) Output = *Data;
+                else
+                {
+                    Scratch = std::move(Raw);
+                    Output = Scratch;
+                }
+            }
+            else
+            {
+                Scratch.clear();
+                if (!Inflate::Decompress(reinterpret_cast<const std::uint8_t*>(Data->data()), Data->size(), Scratch,
+                                         static_cast<std::size_t>(Entry.Size))
+                    || Scratch.size() != Entry.Size)
+                    return std::nullopt;
+                Output = Scratch;
+            }
+
+            if (Inflate::Crc32(reinterpret_cast<const std::uint8_t*>(Output.data()), Output.size()) != Entry.Crc32)
+                return std::nullopt;
+            return Output;
+        }
+
+        // Parses every difficulty of the set; entries that cannot be read are skipped
+        std::vector<Beatmap::Beatmap> LoadBeatmaps(const Beatmap::Section Sections = Beatmap::Section::All)
+        {
+            std::vector<Beatmap::Beatmap> Beatmaps;
+            std::string Scratch;
+            for (const ArchiveEntry* Entry : this->GetDifficulties())
+                if (const auto Data = this->Read(*Entry, Scratch))
+                    Beatmaps.emplace_back(Utilities::AsBytes(*Data), Sections);
+            return Beatmaps;
+        }
+
+        // The set's .osb, parsed for its [Variables] and [Events]
+        std::optional<Beatmap::Beatmap> LoadStoryboard()
+        {
+            const ArchiveEntry* Entry = this->GetStoryboard();
+            std::string Scratch;
+            if (!Entry) return std::nullopt;
+            const auto Data = this->Read(*Entry, Scratch);
+            if (!Data) return std::nullopt;
+            return Beatmap::Beatmap(Utilities::AsBytes(*Data), Beatmap::Section::Variables | Beatmap::Section::Events);
+        }
+
+    private:
+        static constexpr std::uint32_t END_OF_DIRECTORY = 0x06054B50;
+        static constexpr std::uint32_t DIRECTORY_ENTRY = 0x02014B50;
+        static constexpr std::uint32_t LOCAL_HEADER = 0x04034B50;
+        static constexpr std::uint32_t ZIP64_END_OF_DIRECTORY = 0x06064B50;
+        static constexpr std::uint32_t ZIP64_LOCATOR = 0x07064B50;
+        static constexpr std::uint64_t ZIP64_MARKER = 0xFFFFFFFF;
+
+        template <typename T>
+        static T ReadLE(const char* Data)
+        {
+            // zip is little-endian, like every platform osu! runs on
+            T Value;
+            std::memcpy(&Value, Data, sizeof(T));
+            return Value;
+        }
+
+        // Size bytes at Offset: in place for in-memory archives, otherwise read into Scratch
+        std::optional<std::string_view> ReadRange(const std::uint64_t Offset, const std::uint64_t Size,
+                                                  std::string& Scratch)
+        {
+            if (Offset > this->m_Size || Size > this->m_Size - Offset) return std::nullopt;
+            if (!this->m_Buffer.empty())
+                return std::string_view(reinterpret_cast<const char*>(this->m_Buffer.data()) + Offset, Size);
+
+            Scratch.resize(static_cast<std::size_t>(Size));
+            this->m_File.clear();
+            this->m_File.seekg(static_cast<std::streamoff>(Offset));
+            this->m_File.read(Scratch.data(), static_cast<std::streamsize>(Size));
+            if (!this->m_File) return std::nullopt;
+            return std::string_view(Scratch);
+        }
+
+        std::optional<std::string_view> ReadData(const ArchiveEntry& Entry, std::string& Scratch)
+        {
+            // the local header repeats name and extra field, with lengths of its own
+            const auto Header = this->ReadRange(Entry.LocalHeaderOffset, 30, Scratch);
+            if (!Header || ReadLE<std::uint32_t>(Header->data()) != LOCAL_HEADER) return std::nullopt;
+            const std::uint64_t DataOffset = Entry.LocalHeaderOffset + 30
+                + ReadLE<std::uint16_t>(Header->data() + 26) + ReadLE<std::uint16_t>(Header->data() + 28);
+            return this->ReadRange(DataOffset, Entry.CompressedSize, Scratch);
+        }
+
+        void ReadDirectory()
+        {
+            // the end of central directory record is in the last 22 + 65535 (comment) bytes
+            std::string Tail;
+            const std::uint64_t TailSize = std::min<std::uint64_t>(this->m_Size, 22 + 0xFFFF);
+            const auto End = this->ReadRange(this->m_Size - TailSize, TailSize, Tail);
+            if (!End || End->size() < 22) return;
+
+            std::size_t Record = End->size() - 22;
+            while (ReadLE<std::uint32_t>(End->data() + Record) != END_OF_DIRECTORY)
+                if (!Record--) return;
+
+            const char* Eocd = End->data() + Record;
+            std::uint64_t Count = ReadLE<std::uint16_t>(Eocd + 10);
+            std::uint64_t DirectorySize = ReadLE<std::uint32_t>(Eocd + 12);
+            std::uint64_t DirectoryOffset = ReadLE<std::uint32_t>(Eocd + 16);
+
+            // saturated fields: the real ones are in the zip64 record, found through the locator just before
+            if (Count == 0xFFFF || DirectorySize == ZIP64_MARKER || DirectoryOffset == ZIP64_MARKER)
+            {
+                const std::uint64_t EocdOffset = this->m_Size - TailSize + Record;
+                std::string Scratch;
+                const auto Locator = EocdOffset >= 20 ? this->ReadRange(EocdOffset - 20, 20, Scratch) : std::nullopt;
+                if (!Locator || ReadLE<std::uint32_t>(Locator->data()) != ZIP64_LOCATOR) return;
+                const std::uint64_t RecordOffset = ReadLE<std::uint64_t>(Locator->data() + 8);
+                const auto Zip64 = this->ReadRange(RecordOffset, 56, Scratch);
+                if (!Zip64 || ReadLE<std::uint32_t>(Zip64->data()) != ZIP64_END_OF_DIRECTORY) return;
+                Count = ReadLE<std::uint64_t>(Zip64->data() + 32);
+                DirectorySize = ReadLE<std::uint64_t>(Zip64->data() + 40);
+                DirectoryOffset = ReadLE<std::uint64_t>(Zip64->data() + 48);
+            }
+
+            std::string DirectoryScratch;
+            const auto Directory = this->ReadRange(DirectoryOffset, DirectorySize, DirectoryScratch);
+            if (!Directory) return;
+
+            // each entry takes at least 46 bytes, whatever Count claims
+            this->Entries.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(Count, Directory->size() / 46)));
+            std::size_t Position = 0;
+            while (Position + 46 <= Directory->size()
+                && ReadLE<std::uint32_t>(Directory->data() + Position) == DIRECTORY_ENTRY)
+            {
+                const char* Header = Directory->data() + Position;
+                const std::uint16_t NameLength = ReadLE<std::uint16_t>(Header + 28);
+                const std::uint16_t ExtraLength = ReadLE<std::uint16_t>(Header + 30);
+                const std::uint16_t CommentLength = ReadLE<std::uint16_t>(Header + 32);
+                if (Position + 46 + NameLength + ExtraLength + CommentLength > Directory->size()) return;
+
+                ArchiveEntry Entry;
+                Entry.Method = ReadLE<std::uint16_t>(Header + 10);
+                Entry.Crc32 = ReadLE<std::uint32_t>(Header + 16);
+                Entry.CompressedSize = ReadLE<std::uint32_t>(Header + 20);
+                Entry.Size = ReadLE<std::uint32_t>(Header + 24);
+                Entry.LocalHeaderOffset = ReadLE<std::uint32_t>(Header + 42);
+                Entry.Name.assign(Header + 46, NameLength);
+                ReadZip64(std::string_view(Header + 46 + NameLength, ExtraLength), Entry);
+
+                if (!Entry.Name.empty() && Entry.Name.back() != '/') this->Entries.push_back(std::move(Entry));
+                Position += 46 + NameLength + ExtraLength + CommentLength;
+            }
+            this->m_Valid = true;
+        }
+
+        // Replaces the 32-bit fields saturated to 0xFFFFFFFF with their zip64 extra field values
+        static void ReadZip64(std::string_view Extra, ArchiveEntry& Entry)
+        {
+            while (Extra.size() >= 4)
+            {
+                const std::uint16_t Id = ReadLE<std::uint16_t>(Extra.data());
+                const std::uint16_t Size = ReadLE<std::uint16_t>(Extra.data() + 2);
+                if (Size > Extra.size() - 4) return;
+                if (Id == 0x0001)
+                {
+                    std::string_view Field = Extra.substr(4, Size);
+                    for (std::uint64_t* Value : {&Entry.Size, &Entry.CompressedSize, &Entry.LocalHeaderOffset})
+                    {
+                        if (*Value != ZIP64_MARKER) continue;
+                        if (Field.size() < 8) return;
+                        *Value = ReadLE<std::uint64_t>(Field.data());
+                        Field.remove_prefix(8);
+                    }
+                    return;
+                }
+                Extra.remove_prefix(4 + Size);
+            }
+        }
+
+    public:
+        std::vector<ArchiveEntry> Entries;
+
+    private:
+        std::ifstream m_File;
+        std::span<const std::byte> m_Buffer;
+        std::uint64_t m_Size = 0;
+        bool m_Valid = false;
+    };
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace OsuParser
+{
+    enum class ParseMode : std::uint8_t
+    {
+        Lenient, // a line with a bad field is skipped and reported, parsing goes on
+        Strict // parsing of the section stops at the first bad field
+    };
+
+    enum class ParseErrorCode : std::uint8_t
+    {
+        InvalidNumber,
+        OutOfRange,
+        MissingField,
+        InvalidValue // a name the format does not know, e.g. an event type or origin
+    };
+
+    constexpr std::string_view GetErrorName(const ParseErrorCode Code)
+    {
+        switch (Code)
+        {
+        case ParseErrorCode::InvalidNumber: return "invalid number";
+        case ParseErrorCode::OutOfRange: return "number out of range";
+        case ParseErrorCode::MissingField: return "missing field";
+        case ParseErrorCode::InvalidValue: return "invalid value";
+        }
+        return {};
+    }
+
+    struct ParseError
+    {
+        std::string Section;
+        std::size_t Line = 0; // 1-based, in the file (in the section when the parser was not given the file)
+        std::size_t Column = 0; // 1-based byte column where the field starts
+        std::size_t Field = 0; // 0-based index of the field in the line; 1 for the value of a "Key: Value" line
+        ParseErrorCode Code = ParseErrorCode::InvalidNumber;
+        std::string Text; // the offending field, empty when it is missing
+
+        // "[HitObjects] line 812, column 9, field 2: invalid number 'abc'"
+        [[nodiscard]] std::string ToString() const
+        {
+            std::string Message = "[" + this->Section + "] line " + std::to_string(this->Line) + ", column "
+                + std::to_string(this->Column) + ", field " + std::to_string(this->Field) + ": ";
+            Message.append(GetErrorName(this->Code));
+            if (!this->Text.empty()) Message.append(" '").append(this->Text).append("'");
+            return Message;
+        }
+    };
+
+    template <typename E>
+    struct Unexpected
+    {
+        E Error;
+    };
+
+    template <typename E>
+    Unexpected(E) -> Unexpected<E>;
+
+    /**
+     *  A value or the reason there is none, in the spirit of C++23 std::expected (which this library cannot rely on
+     *  yet). Build a failure from Unexpected{Error}.
+     */
+    template <typename T, typename E = ParseError>
+    class Expected
+    {
+    public:
+        Expected(T Value) : m_Storage(std::in_place_index<0>, std::move(Value))
+        {
+        }
+
+        template <typename G>
+        Expected(Unexpected<G> Failure) : m_Storage(std::in_place_index<1>, E(std::move(Failure.Error)))
+        {
+        }
+
+        [[nodiscard]] bool has_value() const { return this->m_Storage.index() == 0; }
+        explicit operator bool() const { return this->has_value(); }
+
+        // Only valid when has_value()
+        [[nodiscard]] T& value() { return *std::get_if<0>(&this->m_Storage); }
+        [[nodiscard]] const T& value() const { return *std::get_if<0>(&this->m_Storage); }
+        T& operator*() { return this->value(); }
+        const T& operator*() const { return this->value(); }
+        T* operator->() { return &this->value(); }
+        const T* operator->() const { return &this->value(); }
+
+        // Only valid when !has_value()
+        [[nodiscard]] const E& error() const { return *std::get_if<1>(&this->m_Storage); }
+
+        [[nodiscard]] T value_or(T Fallback) const
+        {
+            return this->has_value() ? this->value() : std::move(Fallback);
+        }
+
+    private:
+        std::variant<T, E> m_Storage;
+    };
+
+    /**
+     *  Passed to the section and object parsers to choose how bad lines are handled and to collect them.
+     *  Parsers given no log behave as Lenient and drop the errors.
+     */
+    struct ParseLog
+    {
+        ParseMode Mode = ParseMode::Lenient;
+        std::vector<ParseError> Errors;
+
+        ParseLog() = default;
+        explicit ParseLog(const ParseMode Mode) : Mode(Mode)
+        {
+        }
+
+        // Records Error; whether the parser may skip the line and go on
+        static bool Skip(ParseLog* Log, ParseError Error)
+        {
+            if (!Log) return true;
+            Log->Errors.push_back(std::move(Error));
+            return Log->Mode == ParseMode::Lenient;
+        }
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "osu!parser/Parser/ParseError.hpp"
+#include "osu!parser/Parser/Utilities.hpp"
+#include "osu!parser/Parser/Reader/Tokenizer.hpp"
+
+namespace OsuParser
+{
+    /**
+     *  Typed access to the fields of one line at a time, for the object parsers.
+     *
+     *  The first field that fails to parse is kept as a ParseError with its position; every read after that
+     *  returns a zero value, so a parser reads the whole line and checks Failed() once at the end.
+     *  Indexing past the last field gives an empty view, like an empty field.
+     */
+    class FieldReader
+    {
+    public:
+        FieldReader(const Lines& Lines, const std::string_view Section) : m_Lines(Lines), m_Section(Section)
+        {
+        }
+
+        /**
+         *  Splits Line on Delimiter and clears the previous error. Origin is the line as it is in the file, when
+         *  Line is a rewritten copy of it (storyboard variables): errors then point at the start of Origin.
+         */
+        void Read(const std::string_view Line, const char Delimiter = ',', const std::string_view Origin = {})
+        {
+            this->m_Line = Line;
+            this->m_Origin = Origin.empty() ? Line : Origin;
+            this->m_Error.reset();
+            this->m_Lines.Split(Line, Delimiter, this->m_Fields);
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Fields.size(); }
+        [[nodiscard]] bool empty() const { return this->m_Fields.empty(); }
+
+        [[nodiscard]] std::string_view operator[](const std::size_t Index) const
+        {
+            return Index < this->m_Fields.size() ? this->m_Fields[Index] : std::string_view{};
+        }
+
+        // Field Index, which has to be there
+        template <typename T>
+        T Get(const std::size_t Index)
+        {
+            if (Index >= this->m_Fields.size())
+            {
+                this->Fail(Index, {}, ParseErrorCode::MissingField);
+                return T{};
+            }
+            return this->Parse<T>(this->m_Fields[Index], Index);
+        }
+
+        // Field Index, or Fallback when it is missing or empty
+        template <typename T>
+        T Get(const std::size_t Index, const T Fallback)
+        {
+            if (Index >= this->m_Fields.size() || this->m_Fields[Index].empty()) return Fallback;
+            return this->Parse<T>(this->m_Fields[Index], Index);
+        }
+
+        // Text, a part of field Index (e.g. one "x:y" of a slider curve)
+        template <typename T>
+        T Parse(const std::string_view Text, const std::size_t Index)
+        {
+            if (this->m_Error) return T{};
+            const auto Value = Utilities::ParseNumber<T>(Text);
+            if (Value) return *Value;
+            this->Fail(Index, Text, Value.error());
+            return T{};
+        }
+
+        // Records an error for Text in field Index, unless the line already has one
+        void Fail(const std::size_t Index, const std::string_view Text, const ParseErrorCode Code)
+        {
+            if (this->m_Error) return;
+            // a missing field is reported at the end of the line
+            const char* Position = Text.data() ? Text.data() : this->m_Line.data() + this->m_Line.size();
+            const bool InLine = Position >= this->m_Line.data() && Position <= this->m_Line.data() + this->m_Line.size();
+            if (!InLine) Position = this->m_Line.data();
+
+            ParseError& Error = this->m_Error.emplace();
+            Error.Section = this->m_Section;
+            Error.Field = Index;
+            Error.Code = Code;
+            Error.Text = Text;
+            if (this->m_Origin.data() == this->m_Line.data())
+            {
+                const Lines::Location Location = this->m_Lines.Locate(Position);
+                Error.Line = Location.Line;
+                Error.Column = Location.Column;
+            }
+            else
+            {
+                const Lines::Location Location = this->m_Lines.Locate(this->m_Origin.data());
+                Error.Line = Location.Line;
+                Error.Column = Location.Column + static_cast<std::size_t>(Position - this->m_Line.data());
+            }
+        }
+
+        [[nodiscard]] bool Failed() const
+        {
+            return this->m_Error.has_value();
+        }
+
+        // Only valid when Failed()
+        [[nodiscard]] const ParseError& GetError() const
+        {
+            return *this->m_Error;
+        }
+
+    private:
+        const Lines& m_Lines;
+        std::string_view m_Section;
+        std::string_view m_Line;
+        std::string_view m_Origin;
+        std::vector<std::string_view> m_Fields;
+        std::optional<ParseError> m_Error;
+    };
+}
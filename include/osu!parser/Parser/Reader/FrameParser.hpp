@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "osu!parser/Parser/Structures/Replay/ReplayAction.hpp"
+
+namespace OsuParser
+{
+    /**
+     *  Push parser for uncompressed replay frame text ("w|x|y|z,w|x|y|z,...").
+     *
+     *  Chunks may be cut anywhere, a frame split across chunks is carried over in a fixed buffer. Offsets are
+     *  accumulated into song time and the same frames as in Replay are skipped (the -12345 seed frame, negative
+     *  offsets and zero frames before the first real one). Frames are appended to Actions, nothing else allocates.
+     */
+    class FrameParser
+    {
+    public:
+        static constexpr std::size_t MAX_FRAME_LENGTH = 128;
+
+        FrameParser() = default;
+        explicit FrameParser(const std::size_t ExpectedFrames)
+        {
+            this->Actions.reserve(ExpectedFrames);
+        }
+
+        // Returns the number of frames appended to Actions
+        std::size_t Push(const std::string_view Chunk)
+        {
+            const std::size_t Before = this->Actions.size();
+            const char* Current = Chunk.data();
+            const char* End = Chunk.data() + Chunk.size();
+
+            while (Current != End)
+            {
+                const auto* Comma = static_cast<const char*>(std::memchr(Current, ',', End - Current));
+                if (!Comma)
+                {
+                    this->Carry(Current, End);
+                    break;
+                }
+
+                if (this->m_PendingSize)
+                {
+                    this->Carry(Current, Comma);
+                    this->ParseFrame(this->m_Pending.data(), this->m_Pending.data() + this->m_PendingSize);
+                    this->m_PendingSize = 0;
+                    this->m_Overflowed = false;
+                }
+                else if (!this->m_Overflowed) this->ParseFrame(Current, Comma);
+                else this->m_Overflowed = false;
+
+                Current = Comma + 1;
+            }
+            return this->Actions.size() - Before;
+        }
+
+        std::size_t Push(const char* Data, const std::size_t Size)
+        {
+            return this->Push(std::string_view(Data, Size));
+        }
+
+        // Parses a trailing frame that was not followed by a comma (the end of the stream)
+        std::size_t Finish()
+        {
+            const std::size_t Before = this->Actions.size();
+            if (this->m_PendingSize && !this->m_Overflowed)
+                this->ParseFrame(this->m_Pending.data(), this->m_Pending.data() + this->m_PendingSize);
+            this->m_PendingSize = 0;
+            this->m_Overflowed = false;
+            return this->Actions.size() - Before;
+        }
+
+        void Reset()
+        {
+            this->Actions.clear();
+            this->m_TotalSongTime = 0;
+            this->m_PendingSize = 0;
+            this->m_Overflowed = false;
+        }
+
+        [[nodiscard]] std::int64_t GetSongTime() const
+        {
+            return this->m_TotalSongTime;
+        }
+
+    private:
+        void Carry(const char* Begin, const char* End)
+        {
+            const auto Size = static_cast<std::size_t>(End - Begin);
+            if (this->m_Overflowed || this->m_PendingSize + Size > MAX_FRAME_LENGTH)
+            {
+                // not a frame, drop it up to the next comma
+                this->m_Overflowed = true;
+                this->m_PendingSize = 0;
+                return;
+            }
+            std::memcpy(this->m_Pending.data() + this->m_PendingSize, Begin, Size);
+            this->m_PendingSize += Size;
+        }
+
+        template <typename T>
+        static const char* ParseField(const char* Begin, const char* End, T& Value, const char Delimiter)
+        {
+            while (Begin != End && *Begin == ' ') ++Begin;
+            const auto [Pointer, Error] = std::from_chars(Begin, End, Value);
+            if (Error != std::errc()) return nullptr;
+            if (Delimiter && (Pointer == End || *Pointer != Delimiter)) return nullptr;
+            return Delimiter ? Pointer + 1 : Pointer;
+        }
+
+        void ParseFrame(const char* Begin, const char* End)
+        {
+            ReplayAction Action{};
+            if (!(Begin = ParseField(Begin, End, Action.Offset, '|'))) return;
+            if (!(Begin = ParseField(Begin, End, Action.X, '|'))) return;
+            if (!(Begin = ParseField(Begin, End, Action.Y, '|'))) return;
+            if (!ParseField(Begin, End, Action.Keys, '\0')) return;
+
+            if (Action.Offset == -12345 || Action.Offset < 0 || (!Action.Offset && !this->m_TotalSongTime))
+                return;
+            this->m_TotalSongTime += Action.Offset;
+            Action.Offset = this->m_TotalSongTime;
+            this->Actions.push_back(Action);
+        }
+
+    public:
+        std::vector<ReplayAction> Actions;
+
+    private:
+        std::array<char, MAX_FRAME_LENGTH> m_Pending{};
+        std::size_t m_PendingSize = 0;
+        bool m_Overflowed = false;
+        std::int64_t m_TotalSongTime = 0;
+    };
+}
@@ -0,0 +1,360 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace OsuParser::Inflate
+{
+    /**
+     *  Canonical Huffman decoder for one DEFLATE alphabet. Codes up to FAST_BITS long are resolved with a single
+     *  table lookup; longer ones (rare in practice) walk the canonical code counts one bit at a time.
+     */
+    struct Huffman
+    {
+        static constexpr int FAST_BITS = 10;
+        static constexpr int MAX_BITS = 15;
+
+        std::array<std::uint16_t, 1 << FAST_BITS> Fast{}; // (Symbol << 4) | Length, 0 = take the slow path
+        std::array<std::uint16_t, MAX_BITS + 1> Count{};
+        std::array<std::uint16_t, 288> Symbol{};
+
+        bool Build(const std::uint8_t* Lengths, const int Symbols)
+        {
+            this->Fast.fill(0);
+            this->Count.fill(0);
+            for (int i = 0; i < Symbols; i++) this->Count[Lengths[i]]++;
+            this->Count[0] = 0;
+
+            // over-subscribed codes are invalid, incomplete ones are allowed (a single distance code)
+            int Left = 1;
+            for (int Length = 1; Length <= MAX_BITS; Length++)
+            {
+                Left = (Left << 1) - this->Count[Length];
+                if (Left < 0) return false;
+            }
+
+            std::array<std::uint16_t, MAX_BITS + 2> Offsets{};
+            std::array<std::uint32_t, MAX_BITS + 1> NextCode{};
+            std::uint32_t Code = 0;
+            for (int Length = 1; Length <= MAX_BITS; Length++)
+            {
+                Offsets[Length + 1] = static_cast<std::uint16_t>(Offsets[Length] + this->Count[Length]);
+                Code = (Code + this->Count[Length - 1]) << 1;
+                NextCode[Length] = Code;
+            }
+
+            for (int i = 0; i < Symbols; i++)
+            {
+                const int Length = Lengths[i];
+                if (!Length) continue;
+                this->Symbol[Offsets[Length]++] = static_cast<std::uint16_t>(i);
+                if (Length > FAST_BITS)
+                {
+                    NextCode[Length]++;
+                    continue;
+                }
+
+                // codes are stored most significant bit first, the stream is read least significant bit first
+                std::uint32_t Reversed = 0;
+                for (std::uint32_t Bits = NextCode[Length]++, j = 0; j < static_cast<std::uint32_t>(Length); j++)
+                    Reversed |= ((Bits >> j) & 1) << (Length - 1 - j);
+                for (std::uint32_t Index = Reversed; Index < (1u << FAST_BITS); Index += 1u << Length)
+                    this->Fast[Index] = static_cast<std::uint16_t>(i << 4 | Length);
+            }
+            return true;
+        }
+    };
+
+    class Decoder
+    {
+    public:
+        Decoder(const std::uint8_t* Data, const std::size_t Size) : m_Position(Data), m_End(Data + Size)
+        {
+        }
+
+        /**
+         *  Decodes a raw DEFLATE stream (RFC 1951, no zlib/gzip wrapper) and appends it to Output.
+         *  Fails on malformed input and when the output would grow past Limit bytes.
+         */
+        bool Decode(std::string& Output, const std::size_t Limit)
+        {
+            this->m_Output = &Output;
+            this->m_Written = Output.size();
+            this->m_Start = Output.size();
+            this->m_Limit = Output.size() + Limit;
+
+            bool Last = false;
+            while (!Last)
+            {
+                Last = this->Bits(1);
+                const std::uint32_t Type = this->Bits(2);
+                bool Good = false;
+                switch (Type)
+                {
+                case 0: Good = this->Stored();
+                    break;
+                case 1: Good = this->Codes(GetFixed().first, GetFixed().second);
+                    break;
+                case 2: Good = this->Dynamic();
+                    break;
+                default: break;
+                }
+                if (!Good || this->m_Overrun) return false;
+            }
+            Output.resize(this->m_Written);
+            return true;
+        }
+
+    private:
+        void Refill()
+        {
+            while (this->m_BitCount <= 56)
+            {
+                if (this->m_Position == this->m_End)
+                {
+                    // zero padding, only an error if it actually gets consumed
+                    this->m_Padding++;
+                    this->m_BitCount += 8;
+                    continue;
+                }
+                this->m_BitBuffer |= static_cast<std::uint64_t>(*this->m_Position++) << this->m_BitCount;
+                this->m_BitCount += 8;
+            }
+        }
+
+        std::uint32_t Peek(const int Count)
+        {
+            if (this->m_BitCount < Count) this->Refill();
+            return static_cast<std::uint32_t>(this->m_BitBuffer & ((std::uint64_t{1} << Count) - 1));
+        }
+
+        void Consume(const int Count)
+        {
+            this->m_BitBuffer >>= Count;
+            this->m_BitCount -= Count;
+            if (this->m_Padding && this->m_BitCount < this->m_Padding * 8) this->m_Overrun = true;
+        }
+
+        std::uint32_t Bits(const int Count)
+        {
+            if (!Count) return 0;
+            const std::uint32_t Value = this->Peek(Count);
+            this->Consume(Count);
+            return Value;
+        }
+
+        int DecodeSymbol(const Huffman& Table)
+        {
+            const std::uint32_t Window = this->Peek(Huffman::MAX_BITS);
+            if (const std::uint16_t Entry = Table.Fast[Window & ((1u << Huffman::FAST_BITS) - 1)])
+            {
+                this->Consume(Entry & 0xF);
+                return Entry >> 4;
+            }
+
+            int Code = 0, First = 0, Index = 0;
+            for (int Length = 1; Length <= Huffman::MAX_BITS; Length++)
+            {
+                Code |= static_cast<int>((Window >> (Length - 1)) & 1);
+                const int Count = Table.Count[Length];
+                if (Code - Count < First)
+                {
+                    this->Consume(Length);
+                    return Table.Symbol[Index + (Code - First)];
+                }
+                Index += Count;
+                First = (First + Count) << 1;
+                Code <<= 1;
+            }
+            return -1;
+        }
+
+        bool Reserve(const std::size_t Count)
+        {
+            if (this->m_Written + Count > this->m_Limit) return false;
+            if (this->m_Written + Count > this->m_Output->size())
+                this->m_Output->resize(std::min(this->m_Limit, std::max<std::size_t>(
+                    this->m_Output->size() * 2, this->m_Written + Count + 4096)));
+            return true;
+        }
+
+        bool Stored()
+        {
+            // hand the whole bytes still buffered back to the input
+            this->Consume(this->m_BitCount % 8);
+            const int Buffered = this->m_BitCount / 8 - this->m_Padding;
+            if (Buffered < 0) return false;
+            this->m_Position -= Buffered;
+            this->m_BitBuffer = 0;
+            this->m_BitCount = 0;
+            this->m_Padding = 0;
+
+            if (this->m_End - this->m_Position < 4) return false;
+            const std::uint32_t Length = this->m_Position[0] | this->m_Position[1] << 8;
+            const std::uint32_t Complement = this->m_Position[2] | this->m_Position[3] << 8;
+            this->m_Position += 4;
+            if (Length != (~Complement & 0xFFFF) || static_cast<std::size_t>(this->m_End - this->m_Position) < Length)
+                return false;
+            if (!this->Reserve(Length)) return false;
+
+            std::memcpy(this->m_Output->data() + this->m_Written, this->m_Position, Length);
+            this->m_Written += Length;
+            this->m_Position += Length;
+            return true;
+        }
+
+        bool Codes(const Huffman& Literals, const Huffman& Distances)
+        {
+            static constexpr std::uint16_t LENGTH_BASE[29] = {
+                3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195,
+                227, 258
+            };
+            static constexpr std::uint8_t LENGTH_EXTRA[29] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+            };
+            static constexpr std::uint16_t DISTANCE_BASE[30] = {
+                1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+                4097, 6145, 8193, 12289, 16385, 24577
+            };
+            static constexpr std::uint8_t DISTANCE_EXTRA[30] = {
+                0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+            };
+
+            while (true)
+            {
+                const int Symbol = this->DecodeSymbol(Literals);
+                if (Symbol < 0 || this->m_Overrun) return false;
+                if (Symbol < 256)
+                {
+                    if (!this->Reserve(1)) return false;
+                    (*this->m_Output)[this->m_Written++] = static_cast<char>(Symbol);
+                    continue;
+                }
+                if (Symbol == 256) return true;
+
+                const int LengthCode = Symbol - 257;
+                if (LengthCode >= 29) return false;
+                const std::size_t Length = LENGTH_BASE[LengthCode] + this->Bits(LENGTH_EXTRA[LengthCode]);
+
+                const int DistanceCode = this->DecodeSymbol(Distances);
+                if (DistanceCode < 0 || DistanceCode >= 30) return false;
+                const std::size_t Distance = DISTANCE_BASE[DistanceCode] + this->Bits(DISTANCE_EXTRA[DistanceCode]);
+                if (Distance > this->m_Written - this->m_Start || !this->Reserve(Length)) return false;
+
+                // overlapping matches repeat the last Distance bytes, so they are copied byte by byte
+                char* Output = this->m_Output->data() + this->m_Written;
+                const char* Source = Output - Distance;
+                if (Distance >= Length) std::memcpy(Output, Source, Length);
+                else for (std::size_t i = 0; i < Length; i++) Output[i] = Source[i];
+                this->m_Written += Length;
+            }
+        }
+
+        bool Dynamic()
+        {
+            static constexpr std::uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+            const int LiteralCount = static_cast<int>(this->Bits(5)) + 257;
+            const int DistanceCount = static_cast<int>(this->Bits(5)) + 1;
+            const int CodeCount = static_cast<int>(this->Bits(4)) + 4;
+            if (LiteralCount > 286 || DistanceCount > 30) return false;
+
+            std::uint8_t Lengths[320] = {};
+            for (int i = 0; i < CodeCount; i++) Lengths[ORDER[i]] = static_cast<std::uint8_t>(this->Bits(3));
+            Huffman CodeLengths;
+            if (!CodeLengths.Build(Lengths, 19)) return false;
+
+            for (int Index = 0; Index < LiteralCount + DistanceCount;)
+            {
+                const int Symbol = this->DecodeSymbol(CodeLengths);
+                if (Symbol < 0 || this->m_Overrun) return false;
+                if (Symbol < 16)
+                {
+                    Lengths[Index++] = static_cast<std::uint8_t>(Symbol);
+                    continue;
+                }
+
+                std::uint8_t Length = 0;
+                int Repeat;
+                if (Symbol == 16)
+                {
+                    if (!Index) return false;
+                    Length = Lengths[Index - 1];
+                    Repeat = 3 + static_cast<int>(this->Bits(2));
+                }
+                else if (Symbol == 17) Repeat = 3 + static_cast<int>(this->Bits(3));
+                else Repeat = 11 + static_cast<int>(this->Bits(7));
+
+                if (Index + Repeat > LiteralCount + DistanceCount) return false;
+                while (Repeat--) Lengths[Index++] = Length;
+            }
+            if (!Lengths[256]) return false; // no end of block code
+
+            Huffman Literals, Distances;
+            if (!Literals.Build(Lengths, LiteralCount)) return false;
+            if (!Distances.Build(Lengths + LiteralCount, DistanceCount)) return false;
+            return this->Codes(Literals, Distances);
+        }
+
+        static const std::pair<Huffman, Huffman>& GetFixed()
+        {
+            static const std::pair<Huffman, Huffman> Fixed = []
+            {
+                std::pair<Huffman, Huffman> Tables;
+                std::uint8_t Lengths[288];
+                std::memset(Lengths, 8, 144);
+                std::memset(Lengths + 144, 9, 112);
+                std::memset(Lengths + 256, 7, 24);
+                std::memset(Lengths + 280, 8, 8);
+                Tables.first.Build(Lengths, 288);
+                std::memset(Lengths, 5, 30);
+                Tables.second.Build(Lengths, 30);
+                return Tables;
+            }();
+            return Fixed;
+        }
+
+        const std::uint8_t* m_Position;
+        const std::uint8_t* m_End;
+        std::uint64_t m_BitBuffer = 0;
+        int m_BitCount = 0;
+        int m_Padding = 0;
+        bool m_Overrun = false;
+
+        std::string* m_Output = nullptr;
+        std::size_t m_Written = 0;
+        std::size_t m_Start = 0; // matches cannot reach before what this stream wrote
+        std::size_t m_Limit = 0;
+    };
+
+    // Raw DEFLATE into Output (appended); ExpectedSize is both a size hint and the upper bound
+    inline bool Decompress(const std::uint8_t* Data, const std::size_t Size, std::string& Output,
+                           const std::size_t ExpectedSize)
+    {
+        Output.reserve(Output.size() + ExpectedSize);
+        return Decoder(Data, Size).Decode(Output, ExpectedSize);
+    }
+
+    // CRC-32 (IEEE 802.3, as used by zip)
+    inline std::uint32_t Crc32(const std::uint8_t* Data, const std::size_t Size, std::uint32_t Crc = 0)
+    {
+        static const std::array<std::uint32_t, 256> Table = []
+        {
+            std::array<std::uint32_t, 256> Values{};
+            for (std::uint32_t i = 0; i < 256; i++)
+            {
+                std::uint32_t Value = i;
+                for (int Bit = 0; Bit < 8; Bit++) Value = Value & 1 ? 0xEDB88320u ^ (Value >> 1) : Value >> 1;
+                Values[i] = Value;
+            }
+            return Values;
+        }();
+
+        Crc = ~Crc;
+        for (std::size_t i = 0; i < Size; i++) Crc = Table[(Crc ^ Data[i]) & 0xFF] ^ (Crc >> 8);
+        return ~Crc;
+    }
+}
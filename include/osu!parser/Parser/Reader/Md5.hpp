@@ -0,0 +1,367 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "osu!parser/Parser/Reader/StructuralIndex.hpp"
+
+namespace OsuParser
+{
+    /**
+     *  MD5, which is how osu! identifies a .osu: osu!.db entries and replays hold the lowercase hex digest of the
+     *  file's bytes.
+     *
+     *  Update() takes a file in pieces as it is read. HashMany() hashes a batch of buffers side by side, one per
+     *  SIMD lane (4 with SSE2, 8 with AVX2): every 64-byte block depends on the previous one, so a single buffer
+     *  cannot be spread over lanes, but different files can. A lane that reaches the end of its buffer picks up
+     *  the next one, so files of different sizes do not leave lanes idle for long.
+     */
+    class Md5
+    {
+    public:
+        using Digest = std::array<std::uint8_t, 16>;
+
+        void Update(std::string_view Data)
+        {
+            this->m_Length += Data.size();
+            if (this->m_PendingSize)
+            {
+                const std::size_t Taken = std::min(Data.size(), 64 - this->m_PendingSize);
+                std::memcpy(this->m_Pending + this->m_PendingSize, Data.data(), Taken);
+                this->m_PendingSize += Taken;
+                Data.remove_prefix(Taken);
+                if (this->m_PendingSize < 64) return;
+                Compress(this->m_State, this->m_Pending);
+                this->m_PendingSize = 0;
+            }
+            for (; Data.size() >= 64; Data.remove_prefix(64))
+                Compress(this->m_State, reinterpret_cast<const unsigned char*>(Data.data()));
+            std::memcpy(this->m_Pending, Data.data(), Data.size());
+            this->m_PendingSize = Data.size();
+        }
+
+        // Digest of everything passed to Update(); starts over afterwards
+        Digest Finish()
+        {
+            unsigned char Tail[128];
+            const std::string_view Rest(reinterpret_cast<const char*>(this->m_Pending), this->m_PendingSize);
+            const std::size_t TailSize = Pad(Tail, Rest, this->m_Length);
+            for (std::size_t Offset = 0; Offset < TailSize; Offset += 64) Compress(this->m_State, Tail + Offset);
+            const Digest Result = ToDigest(this->m_State);
+            *this = Md5();
+            return Result;
+        }
+
+        static Digest Hash(const std::string_view Data)
+        {
+            Md5 Hasher;
+            Hasher.Update(Data);
+            return Hasher.Finish();
+        }
+
+        // Lowercase hex, the form osu!.db and replays store
+        static std::string ToHex(const Digest& Value)
+        {
+            constexpr char DIGITS[] = "0123456789abcdef";
+            std::string Hex(32, '\0');
+            for (std::size_t i = 0; i < Value.size(); i++)
+            {
+                Hex[i * 2] = DIGITS[Value[i] >> 4];
+                Hex[i * 2 + 1] = DIGITS[Value[i] & 15];
+            }
+            return Hex;
+        }
+
+        // Digests of Buffers, in their order; the Scalar backend hashes them one after another
+        static std::vector<Digest> HashMany(const std::span<const std::string_view> Buffers,
+                                            const ScanBackend Backend = StructuralIndex::GetBestBackend())
+        {
+            std::vector<Digest> Digests(Buffers.size());
+            switch (Backend)
+            {
+#ifdef OSU_PARSER_X86
+            case ScanBackend::AVX2: HashLanes<8>(Buffers, Digests, CompressAVX2);
+                break;
+            case ScanBackend::SSE2: HashLanes<4>(Buffers, Digests, CompressSSE2);
+                break;
+#endif
+            default:
+                for (std::size_t i = 0; i < Buffers.size(); i++) Digests[i] = Hash(Buffers[i]);
+                break;
+            }
+            return Digests;
+        }
+
+    private:
+        using State = std::array<std::uint32_t, 4>;
+
+        static constexpr State INITIAL_STATE = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+        // floor(abs(sin(i + 1)) * 2^32)
+        static constexpr std::uint32_t CONSTANTS[64] = {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+            0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+            0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+            0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+            0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+            0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+            0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+        static constexpr std::uint8_t SHIFTS[64] = {
+            7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+            5, 9, 14, 20, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 6, 10, 15, 21, 6, 10, 15, 21,
+            6, 10, 15, 21, 6, 10, 15, 21};
+
+        // Which word of the block step i mixes in
+        static constexpr std::uint8_t WORDS[64] = {
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2,
+            7, 12, 5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2, 0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13,
+            4, 11, 2, 9};
+
+        static std::uint32_t LoadWord(const unsigned char* Data)
+        {
+            return static_cast<std::uint32_t>(Data[0]) | static_cast<std::uint32_t>(Data[1]) << 8
+                | static_cast<std::uint32_t>(Data[2]) << 16 | static_cast<std::uint32_t>(Data[3]) << 24;
+        }
+
+        static void Compress(State& Hash, const unsigned char* Block)
+        {
+            std::uint32_t Words[16];
+            for (std::size_t i = 0; i < 16; i++) Words[i] = LoadWord(Block + i * 4);
+
+            std::uint32_t A = Hash[0], B = Hash[1], C = Hash[2], D = Hash[3];
+            for (std::size_t i = 0; i < 64; i++)
+            {
+                std::uint32_t F;
+                switch (i / 16)
+                {
+                case 0: F = (B & C) | (~B & D);
+                    break;
+                case 1: F = (D & B) | (~D & C);
+                    break;
+                case 2: F = B ^ C ^ D;
+                    break;
+                default: F = C ^ (B | ~D);
+                    break;
+                }
+                F += A + CONSTANTS[i] + Words[WORDS[i]];
+                A = D;
+                D = C;
+                C = B;
+                B += F << SHIFTS[i] | F >> (32 - SHIFTS[i]);
+            }
+            Hash[0] += A;
+            Hash[1] += B;
+            Hash[2] += C;
+            Hash[3] += D;
+        }
+
+        // Writes the last partial block of a message of Length bytes plus its padding; returns 64 or 128
+        static std::size_t Pad(unsigned char (&Tail)[128], const std::string_view Rest, const std::uint64_t Length)
+        {
+            const std::size_t TailSize = Rest.size() + 9 <= 64 ? 64 : 128;
+            std::memcpy(Tail, Rest.data(), Rest.size());
+            std::memset(Tail + Rest.size(), 0, TailSize - Rest.size());
+            Tail[Rest.size()] = 0x80;
+            for (std::size_t i = 0; i < 8; i++)
+                Tail[TailSize - 8 + i] = static_cast<unsigned char>(Length * 8 >> (i * 8)); // in bits
+            return TailSize;
+        }
+
+        static Digest ToDigest(const State& Hash)
+        {
+            Digest Result;
+            for (std::size_t i = 0; i < 16; i++) Result[i] = static_cast<std::uint8_t>(Hash[i / 4] >> (i % 4 * 8));
+            return Result;
+        }
+
+        // Hash[word][lane], the four state words of every lane
+        template <std::size_t LANES>
+        using LaneState = std::uint32_t[4][LANES];
+
+        template <std::size_t LANES>
+        using LaneCompress = void (*)(LaneState<LANES>& Hash, const unsigned char* const (&Blocks)[LANES]);
+
+        /**
+         *  Feeds every lane one block per step: the next full block of its buffer, then the padded tail. A lane
+         *  that finished writes its digest and takes the next buffer; once none are left it hashes a block of
+         *  zeros that is thrown away, until the last lane is done.
+         */
+        template <std::size_t LANES>
+        static void HashLanes(const std::span<const std::string_view> Buffers, std::vector<Digest>& Digests,
+                              const LaneCompress<LANES> Compress)
+        {
+            struct Lane
+            {
+                std::size_t Buffer = 0;
+                std::size_t Block = 0;
+                std::size_t FullBlocks = 0;
+                std::size_t Blocks = 0; // 0 = idle
+                unsigned char Tail[128];
+            };
+
+            static constexpr unsigned char IDLE_BLOCK[64] = {};
+            alignas(32) LaneState<LANES> Hash;
+            Lane Lanes[LANES];
+            std::size_t Next = 0, Active = 0;
+
+            const auto Start = [&](const std::size_t Index)
+            {
+                Lane& Current = Lanes[Index];
+                const std::string_view Data = Buffers[Next];
+                Current.Buffer = Next++;
+                Current.Block = 0;
+                Current.FullBlocks = Data.size() / 64;
+                Current.Blocks = Current.FullBlocks
+                    + Pad(Current.Tail, Data.substr(Current.FullBlocks * 64), Data.size()) / 64;
+                for (std::size_t Word = 0; Word < 4; Word++) Hash[Word][Index] = INITIAL_STATE[Word];
+                ++Active;
+            };
+            for (std::size_t Index = 0; Index < LANES && Next < Buffers.size(); Index++) Start(Index);
+
+            while (Active)
+            {
+                const unsigned char* Blocks[LANES];
+                for (std::size_t Index = 0; Index < LANES; Index++)
+                {
+                    const Lane& Current = Lanes[Index];
+                    if (!Current.Blocks) Blocks[Index] = IDLE_BLOCK;
+                    else if (Current.Block < Current.FullBlocks)
+                        Blocks[Index] = reinterpret_cast<const unsigned char*>(Buffers[Current.Buffer].data())
+                            + Current.Block * 64;
+                    else Blocks[Index] = Current.Tail + (Current.Block - Current.FullBlocks) * 64;
+                }
+                Compress(Hash, Blocks);
+
+                for (std::size_t Index = 0; Index < LANES; Index++)
+                {
+                    Lane& Current = Lanes[Index];
+                    if (!Current.Blocks || ++Current.Block < Current.Blocks) continue;
+                    Digests[Current.Buffer] =
+                        ToDigest({Hash[0][Index], Hash[1][Index], Hash[2][Index], Hash[3][Index]});
+                    Current.Blocks = 0;
+                    --Active;
+                    if (Next < Buffers.size()) Start(Index);
+                }
+            }
+        }
+
+#ifdef OSU_PARSER_X86
+        // Words 4 * Group to 4 * Group + 3 of four blocks, one vector per word with one lane per block
+        static void Transpose(const unsigned char* const* Blocks, const std::size_t Group, __m128i* Words)
+        {
+            const auto Load = [&](const std::size_t Lane)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Blocks[Lane] + Group * 16));
+            };
+            const __m128i Low01 = _mm_unpacklo_epi32(Load(0), Load(1)), Low23 = _mm_unpacklo_epi32(Load(2), Load(3));
+            const __m128i High01 = _mm_unpackhi_epi32(Load(0), Load(1)), High23 = _mm_unpackhi_epi32(Load(2), Load(3));
+            Words[0] = _mm_unpacklo_epi64(Low01, Low23);
+            Words[1] = _mm_unpackhi_epi64(Low01, Low23);
+            Words[2] = _mm_unpacklo_epi64(High01, High23);
+            Words[3] = _mm_unpackhi_epi64(High01, High23);
+        }
+
+        static void CompressSSE2(LaneState<4>& Hash, const unsigned char* const (&Blocks)[4])
+        {
+            __m128i Words[16];
+            for (std::size_t Group = 0; Group < 4; Group++)
+                Transpose(Blocks, Group, Words + Group * 4);
+
+            __m128i A = _mm_load_si128(reinterpret_cast<const __m128i*>(Hash[0]));
+            __m128i B = _mm_load_si128(reinterpret_cast<const __m128i*>(Hash[1]));
+            __m128i C = _mm_load_si128(reinterpret_cast<const __m128i*>(Hash[2]));
+            __m128i D = _mm_load_si128(reinterpret_cast<const __m128i*>(Hash[3]));
+            const __m128i Ones = _mm_set1_epi32(-1);
+            for (std::size_t i = 0; i < 64; i++)
+            {
+                __m128i F;
+                switch (i / 16)
+                {
+                case 0: F = _mm_or_si128(_mm_and_si128(B, C), _mm_andnot_si128(B, D));
+                    break;
+                case 1: F = _mm_or_si128(_mm_and_si128(D, B), _mm_andnot_si128(D, C));
+                    break;
+                case 2: F = _mm_xor_si128(_mm_xor_si128(B, C), D);
+                    break;
+                default: F = _mm_xor_si128(C, _mm_or_si128(B, _mm_xor_si128(D, Ones)));
+                    break;
+                }
+                F = _mm_add_epi32(_mm_add_epi32(F, A),
+                                  _mm_add_epi32(_mm_set1_epi32(static_cast<int>(CONSTANTS[i])), Words[WORDS[i]]));
+                A = D;
+                D = C;
+                C = B;
+                B = _mm_add_epi32(B, _mm_or_si128(_mm_sll_epi32(F, _mm_cvtsi32_si128(SHIFTS[i])),
+                                                  _mm_srl_epi32(F, _mm_cvtsi32_si128(32 - SHIFTS[i]))));
+            }
+
+            const __m128i Final[4] = {A, B, C, D};
+            for (std::size_t Word = 0; Word < 4; Word++)
+            {
+                auto* Target = reinterpret_cast<__m128i*>(Hash[Word]);
+                _mm_store_si128(Target, _mm_add_epi32(_mm_load_si128(Target), Final[Word]));
+            }
+        }
+
+        OSU_PARSER_TARGET_AVX2 static void CompressAVX2(LaneState<8>& Hash, const unsigned char* const (&Blocks)[8])
+        {
+            __m256i Words[16];
+            for (std::size_t Group = 0; Group < 4; Group++)
+            {
+                __m128i Low[4], High[4];
+                Transpose(Blocks, Group, Low);
+                Transpose(Blocks + 4, Group, High);
+                for (std::size_t Word = 0; Word < 4; Word++)
+                    Words[Group * 4 + Word] = _mm256_inserti128_si256(_mm256_castsi128_si256(Low[Word]), High[Word], 1);
+            }
+
+            __m256i A = _mm256_load_si256(reinterpret_cast<const __m256i*>(Hash[0]));
+            __m256i B = _mm256_load_si256(reinterpret_cast<const __m256i*>(Hash[1]));
+            __m256i C = _mm256_load_si256(reinterpret_cast<const __m256i*>(Hash[2]));
+            __m256i D = _mm256_load_si256(reinterpret_cast<const __m256i*>(Hash[3]));
+            const __m256i Ones = _mm256_set1_epi32(-1);
+            for (std::size_t i = 0; i < 64; i++)
+            {
+                __m256i F;
+                switch (i / 16)
+                {
+                case 0: F = _mm256_or_si256(_mm256_and_si256(B, C), _mm256_andnot_si256(B, D));
+                    break;
+                case 1: F = _mm256_or_si256(_mm256_and_si256(D, B), _mm256_andnot_si256(D, C));
+                    break;
+                case 2: F = _mm256_xor_si256(_mm256_xor_si256(B, C), D);
+                    break;
+                default: F = _mm256_xor_si256(C, _mm256_or_si256(B, _mm256_xor_si256(D, Ones)));
+                    break;
+                }
+                F = _mm256_add_epi32(_mm256_add_epi32(F, A), _mm256_add_epi32(
+                                         _mm256_set1_epi32(static_cast<int>(CONSTANTS[i])), Words[WORDS[i]]));
+                A = D;
+                D = C;
+                C = B;
+                B = _mm256_add_epi32(B, _mm256_or_si256(_mm256_sll_epi32(F, _mm_cvtsi32_si128(SHIFTS[i])),
+                                                        _mm256_srl_epi32(F, _mm_cvtsi32_si128(32 - SHIFTS[i]))));
+            }
+
+            const __m256i Final[4] = {A, B, C, D};
+            for (std::size_t Word = 0; Word < 4; Word++)
+            {
+                auto* Target = reinterpret_cast<__m256i*>(Hash[Word]);
+                _mm256_store_si256(Target, _mm256_add_epi32(_mm256_load_si256(Target), Final[Word]));
+            }
+        }
+#endif
+
+        State m_State = INITIAL_STATE;
+        unsigned char m_Pending[64];
+        std::size_t m_PendingSize = 0;
+        std::uint64_t m_Length = 0;
+    };
+}
@@ -1,21 +1,40 @@
 #pragma once
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <any>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <vector>
 
 namespace OsuParser
 {
+    /**
+     *  Little-endian binary reader over a file, a caller's std::istream or a caller's memory buffer.
+     *  Memory buffers are read in place: the caller keeps them alive while the Reader is in use.
+     */
     class Reader
     {
     public:
 
         Reader() {}
-        
+
         Reader(const std::string& StreamPath)
         {
             this->SetStream(StreamPath);
         }
 
+        explicit Reader(std::istream& Stream)
+        {
+            this->SetStream(Stream);
+        }
+
+        explicit Reader(const std::span<const std::byte> Buffer)
+        {
+            this->SetBuffer(Buffer);
+        }
+
         ~Reader()
         {
             if(this->m_CurrentStream.is_open())
@@ -31,20 +50,46 @@ namespace OsuParser
                 this->m_CurrentStream.close();
             }
             this->m_CurrentStream = std::ifstream(StreamPath, std::ios::binary);
+            this->m_Stream = &this->m_CurrentStream;
+            this->m_Buffer = {};
             return this->m_CurrentStream.good();
         }
 
+        bool SetStream(std::istream& Stream)
+        {
+            if(this->m_CurrentStream.is_open())
+            {
+                this->m_CurrentStream.close();
+            }
+            this->m_Stream = &Stream;
+            this->m_Buffer = {};
+            return Stream.good();
+        }
+
+        bool SetBuffer(const std::span<const std::byte> Buffer)
+        {
+            if(this->m_CurrentStream.is_open())
+            {
+                this->m_CurrentStream.close();
+            }
+            this->m_Stream = nullptr;
+            this->m_Buffer = Buffer;
+            this->m_Position = 0;
+            this->m_Failed = false;
+            return true;
+        }
+
         std::uint64_t ReadUleb128()
         {
             std::uint8_t Byte = 0x0;
             std::uint32_t Result = 0;
             std::int32_t ShiftAmount = 0;
-            do 
+            do
             {
                 Byte = this->ReadType<std::uint8_t>();
                 Result |= (Byte & 0x7F) << ShiftAmount;
                 ShiftAmount += 0x7;
-            } 
+            }
             while (Byte & 0x80);
             return Result;
         }
@@ -56,32 +101,71 @@ namespace OsuParser
                 return "N/A";
             const std::uint64_t Size = this->ReadUleb128();
             std::string Buffer(Size, ' ');
-            for (std::uint32_t i = 0; i < Size; i++) 
-            {
-                Buffer[i] = static_cast<char>(this->m_CurrentStream.get());
-            }
+            this->Read(Buffer.data(), Buffer.size());
             return Buffer;
         }
 
-        template<typename T> 
+        template<typename T>
         T ReadType()
         {
-            T Value;
-            this->m_CurrentStream.read(reinterpret_cast<char*>(&Value), sizeof(T));
+            T Value{};
+            this->Read(reinterpret_cast<char*>(&Value), sizeof(T));
             return Value;
         }
 
+        // Bytes past the end of a memory buffer read as zero
+        void Read(char* Output, const std::size_t Size)
+        {
+            if (this->m_Stream)
+            {
+                this->m_Stream->read(Output, static_cast<std::streamsize>(Size));
+                return;
+            }
+            const std::size_t Available = std::min(Size, this->m_Buffer.size() - this->m_Position);
+            std::memcpy(Output, this->m_Buffer.data() + this->m_Position, Available);
+            std::memset(Output + Available, 0, Size - Available);
+            this->m_Position += Available;
+            this->m_Failed |= Available < Size;
+        }
+
+        // The next Size bytes; points into the memory buffer when there is one, otherwise they are read into Scratch
+        std::span<const std::byte> ReadSpan(const std::size_t Size, std::vector<std::byte>& Scratch)
+        {
+            if (!this->m_Stream)
+            {
+                const std::size_t Available = std::min(Size, this->m_Buffer.size() - this->m_Position);
+                const auto Span = this->m_Buffer.subspan(this->m_Position, Available);
+                this->m_Position += Available;
+                this->m_Failed |= Available < Size;
+                return Span;
+            }
+            Scratch.resize(Size);
+            this->m_Stream->read(reinterpret_cast<char*>(Scratch.data()), static_cast<std::streamsize>(Size));
+            return {Scratch.data(), static_cast<std::size_t>(this->m_Stream->gcount())};
+        }
+
         void Seek(const std::int32_t& Amount)
         {
-            this->m_CurrentStream.seekg(Amount, std::ios::cur);
+            if (this->m_Stream)
+            {
+                this->m_Stream->seekg(Amount, std::ios::cur);
+                return;
+            }
+            const auto Target = static_cast<std::int64_t>(this->m_Position) + Amount;
+            this->m_Position = static_cast<std::size_t>(
+                std::clamp<std::int64_t>(Target, 0, static_cast<std::int64_t>(this->m_Buffer.size())));
         }
 
-        std::ifstream& GetStream()
+        [[nodiscard]] bool Good() const
         {
-            return this->m_CurrentStream;
+            return this->m_Stream ? this->m_Stream->good() : !this->m_Failed;
         }
 
     private:
         std::ifstream m_CurrentStream;
+        std::istream* m_Stream = nullptr; // m_CurrentStream or the caller's stream, null when reading m_Buffer
+        std::span<const std::byte> m_Buffer;
+        std::size_t m_Position = 0;
+        bool m_Failed = false;
     };
-}
\ No newline at end of file
+}
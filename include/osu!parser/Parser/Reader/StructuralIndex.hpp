@@ -0,0 +1,275 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "osu!parser/Parser/Utilities.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OSU_PARSER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define OSU_PARSER_TARGET_AVX2
+#else
+#define OSU_PARSER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace OsuParser
+{
+    enum class ScanBackend : std::uint8_t
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     *  Positions of every structural character of a .osu buffer, found in a single vectorized sweep
+     *  (64-byte blocks turned into one bitmask per character class, simdjson stage 1 style).
+     *
+     *  The Tokenizer builds one over the body of each section it tokenizes. Section headers are not indexed:
+     *  Tokenizer::ForEachHeader finds them, since whether a '[' opens a section depends on the section it is in.
+     *  Offsets fit in 32 bits; .osu files are far below 4 GB.
+     */
+    class StructuralIndex
+    {
+    public:
+        StructuralIndex() = default;
+        explicit StructuralIndex(const std::string_view Buffer, const ScanBackend Backend = GetBestBackend())
+        {
+            this->Build(Buffer, Backend);
+        }
+
+        void Build(const std::string_view Buffer, const ScanBackend Backend = GetBestBackend())
+        {
+            this->m_Base = Buffer.data();
+            this->m_Size = Buffer.size();
+            this->Newlines.clear();
+            this->Commas.clear();
+            this->Pipes.clear();
+            this->Colons.clear();
+
+            // rough upper bounds for storyboard-heavy maps, avoids most regrowth
+            this->Newlines.reserve(Buffer.size() / 24);
+            this->Commas.reserve(Buffer.size() / 6);
+
+            const std::size_t FullBlocks = Buffer.size() / 64;
+            for (std::size_t Block = 0; Block <= FullBlocks; Block++)
+            {
+                const std::size_t Offset = Block * 64;
+                const char* Data = Buffer.data() + Offset;
+                alignas(64) char Tail[64];
+                if (Block == FullBlocks)
+                {
+                    if (Offset == Buffer.size()) break;
+                    std::memset(Tail, 0, sizeof(Tail));
+                    std::memcpy(Tail, Data, Buffer.size() - Offset);
+                    Data = Tail;
+                }
+
+                BlockMasks Masks;
+                switch (Backend)
+                {
+#ifdef OSU_PARSER_X86
+                case ScanBackend::AVX2: Masks = ScanAVX2(Data);
+                    break;
+                case ScanBackend::SSE2: Masks = ScanSSE2(Data);
+                    break;
+#endif
+                default: Masks = ScanScalar(Data);
+                    break;
+                }
+
+                Flatten(this->Newlines, Masks.Newline, Offset);
+                Flatten(this->Commas, Masks.Comma, Offset);
+                Flatten(this->Pipes, Masks.Pipe, Offset);
+                Flatten(this->Colons, Masks.Colon, Offset);
+            }
+        }
+
+        // Offsets of Delimiter, or nullptr if that character is not indexed
+        [[nodiscard]] const std::vector<std::uint32_t>* GetOffsets(const char Delimiter) const
+        {
+            switch (Delimiter)
+            {
+            case '\n': return &this->Newlines;
+            case ',': return &this->Commas;
+            case '|': return &this->Pipes;
+            case ':': return &this->Colons;
+            default: return nullptr;
+            }
+        }
+
+        // Start of the indexed buffer; offsets are relative to it
+        [[nodiscard]] const char* GetBase() const
+        {
+            return this->m_Base;
+        }
+
+        [[nodiscard]] bool Contains(const std::string_view View) const
+        {
+            return this->m_Base && View.data() >= this->m_Base && View.data() + View.size() <= this->m_Base + this->m_Size;
+        }
+
+        /**
+         *  Same result as Utilities::Split(View, Delimiter), but the delimiters are taken from the index instead of
+         *  scanning View again. Falls back to Utilities::Split for views outside the indexed buffer.
+         */
+        void Split(const std::string_view View, const char Delimiter, std::vector<std::string_view>& Output) const
+        {
+            Output.clear();
+            const std::vector<std::uint32_t>* Offsets = this->GetOffsets(Delimiter);
+            if (!Offsets || !this->Contains(View))
+            {
+                Output = Utilities::Split(View, Delimiter);
+                return;
+            }
+
+            const auto Begin = static_cast<std::uint32_t>(View.data() - this->m_Base);
+            const auto End = static_cast<std::uint32_t>(Begin + View.size());
+            std::uint32_t FieldBegin = Begin;
+            for (auto Iterator = std::lower_bound(Offsets->begin(), Offsets->end(), Begin);
+                 Iterator != Offsets->end() && *Iterator < End; ++Iterator)
+            {
+                Output.emplace_back(this->m_Base + FieldBegin, *Iterator - FieldBegin);
+                FieldBegin = *Iterator + 1;
+            }
+            if (FieldBegin < End) Output.emplace_back(this->m_Base + FieldBegin, End - FieldBegin);
+        }
+
+        [[nodiscard]] std::vector<std::string_view> Split(const std::string_view View, const char Delimiter) const
+        {
+            std::vector<std::string_view> Output;
+            this->Split(View, Delimiter, Output);
+            return Output;
+        }
+
+        static ScanBackend GetBestBackend()
+        {
+#ifdef OSU_PARSER_X86
+            static const ScanBackend Backend = SupportsAVX2() ? ScanBackend::AVX2 : ScanBackend::SSE2;
+            return Backend;
+#else
+            return ScanBackend::Scalar;
+#endif
+        }
+
+    private:
+        struct BlockMasks
+        {
+            std::uint64_t Newline = 0;
+            std::uint64_t Comma = 0;
+            std::uint64_t Pipe = 0;
+            std::uint64_t Colon = 0;
+        };
+
+        static void Flatten(std::vector<std::uint32_t>& Output, std::uint64_t Mask, const std::size_t Offset)
+        {
+            while (Mask)
+            {
+                Output.push_back(static_cast<std::uint32_t>(Offset + std::countr_zero(Mask)));
+                Mask &= Mask - 1;
+            }
+        }
+
+        static BlockMasks ScanScalar(const char* Data)
+        {
+            BlockMasks Masks;
+            for (std::size_t i = 0; i < 64; i++)
+            {
+                const std::uint64_t Bit = std::uint64_t{1} << i;
+                switch (Data[i])
+                {
+                case '\n': Masks.Newline |= Bit;
+                    break;
+                case ',': Masks.Comma |= Bit;
+                    break;
+                case '|': Masks.Pipe |= Bit;
+                    break;
+                case ':': Masks.Colon |= Bit;
+                    break;
+                default: break;
+                }
+            }
+            return Masks;
+        }
+
+#ifdef OSU_PARSER_X86
+        static std::uint64_t MatchSSE2(const __m128i (&Bytes)[4], const char Character)
+        {
+            const __m128i Pattern = _mm_set1_epi8(Character);
+            std::uint64_t Mask = 0;
+            for (int Chunk = 0; Chunk < 4; Chunk++)
+            {
+                const auto Bits = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(Bytes[Chunk], Pattern)));
+                Mask |= static_cast<std::uint64_t>(Bits) << (Chunk * 16);
+            }
+            return Mask;
+        }
+
+        static BlockMasks ScanSSE2(const char* Data)
+        {
+            __m128i Bytes[4];
+            for (int Chunk = 0; Chunk < 4; Chunk++)
+                Bytes[Chunk] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Chunk * 16));
+
+            BlockMasks Masks;
+            Masks.Newline = MatchSSE2(Bytes, '\n');
+            Masks.Comma = MatchSSE2(Bytes, ',');
+            Masks.Pipe = MatchSSE2(Bytes, '|');
+            Masks.Colon = MatchSSE2(Bytes, ':');
+            return Masks;
+        }
+
+        OSU_PARSER_TARGET_AVX2 static std::uint64_t MatchAVX2(const __m256i Low, const __m256i High, const char Character)
+        {
+            const __m256i Pattern = _mm256_set1_epi8(Character);
+            const auto LowBits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Low, Pattern)));
+            const auto HighBits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(High, Pattern)));
+            return static_cast<std::uint64_t>(HighBits) << 32 | LowBits;
+        }
+
+        OSU_PARSER_TARGET_AVX2 static BlockMasks ScanAVX2(const char* Data)
+        {
+            const __m256i Low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data));
+            const __m256i High = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + 32));
+
+            BlockMasks Masks;
+            Masks.Newline = MatchAVX2(Low, High, '\n');
+            Masks.Comma = MatchAVX2(Low, High, ',');
+            Masks.Pipe = MatchAVX2(Low, High, '|');
+            Masks.Colon = MatchAVX2(Low, High, ':');
+            return Masks;
+        }
+
+        static bool SupportsAVX2()
+        {
+#ifdef _MSC_VER
+            int Info[4];
+            __cpuid(Info, 1);
+            const bool OSXSave = (Info[2] & (1 << 27)) != 0, AVX = (Info[2] & (1 << 28)) != 0;
+            if (!OSXSave || !AVX || (_xgetbv(0) & 0x6) != 0x6) return false;
+            __cpuidex(Info, 7, 0);
+            return (Info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+    public:
+        std::vector<std::uint32_t> Newlines;
+        std::vector<std::uint32_t> Commas;
+        std::vector<std::uint32_t> Pipes;
+        std::vector<std::uint32_t> Colons;
+
+    private:
+        const char* m_Base = nullptr;
+        std::size_t m_Size = 0;
+    };
+}
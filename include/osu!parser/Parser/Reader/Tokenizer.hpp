@@ -0,0 +1,373 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "osu!parser/Parser/Utilities.hpp"
+#include "osu!parser/Parser/Reader/Md5.hpp"
+#include "osu!parser/Parser/Reader/StructuralIndex.hpp"
+
+namespace OsuParser
+{
+    /**
+     *  Line views of one section, plus the structural index of the buffer they point into.
+     *  Parsers split fields through Split(), which walks the precomputed delimiter offsets.
+     */
+    class Lines
+    {
+    public:
+        using value_type = std::string_view;
+        using const_iterator = std::vector<std::string_view>::const_iterator;
+
+        Lines() = default;
+        explicit Lines(std::shared_ptr<const StructuralIndex> Index) : m_Index(std::move(Index))
+        {
+        }
+
+        [[nodiscard]] const_iterator begin() const { return this->m_Views.begin(); }
+        [[nodiscard]] const_iterator end() const { return this->m_Views.end(); }
+        [[nodiscard]] std::size_t size() const { return this->m_Views.size(); }
+        [[nodiscard]] bool empty() const { return this->m_Views.empty(); }
+        [[nodiscard]] std::string_view operator[](const std::size_t Index) const { return this->m_Views[Index]; }
+        void push_back(const std::string_view View) { this->m_Views.push_back(View); }
+
+        void Split(const std::string_view Line, const char Delimiter, std::vector<std::string_view>& Output) const
+        {
+            if (this->m_Index) this->m_Index->Split(Line, Delimiter, Output);
+            else Output = Utilities::Split(Line, Delimiter);
+        }
+
+        [[nodiscard]] std::vector<std::string_view> Split(const std::string_view Line, const char Delimiter) const
+        {
+            std::vector<std::string_view> Output;
+            this->Split(Line, Delimiter, Output);
+            return Output;
+        }
+
+        struct Location
+        {
+            std::size_t Line = 0;
+            std::size_t Column = 0;
+        };
+
+        // The whole file the lines point into, so Locate() can count lines from its start
+        void SetFile(const std::string_view File)
+        {
+            this->m_File = File;
+            this->m_LinesBefore = std::string_view::npos;
+        }
+
+        /**
+         *  1-based line and column of Position, which points into one of the lines. Lines are counted from the
+         *  start of the file given to SetFile, otherwise from the start of the section. Meant for error reports:
+         *  the first call counts the newlines in front of the section.
+         */
+        [[nodiscard]] Location Locate(const char* Position) const
+        {
+            if (!this->m_Index || !this->m_Index->Contains(std::string_view(Position, 0)))
+            {
+                for (std::size_t Index = 0; Index < this->m_Views.size(); Index++)
+                {
+                    const std::string_view View = this->m_Views[Index];
+                    if (Position >= View.data() && Position <= View.data() + View.size())
+                        return {Index + 1, static_cast<std::size_t>(Position - View.data()) + 1};
+                }
+                return {};
+            }
+
+            const char* Base = this->m_Index->GetBase();
+            const auto& Newlines = this->m_Index->Newlines;
+            const auto Offset = static_cast<std::uint32_t>(Position - Base);
+            const auto Before = static_cast<std::size_t>(
+                std::lower_bound(Newlines.begin(), Newlines.end(), Offset) - Newlines.begin());
+            const std::uint32_t LineBegin = Before ? Newlines[Before - 1] + 1 : 0;
+
+            if (this->m_LinesBefore == std::string_view::npos)
+            {
+                const bool InFile = !this->m_File.empty() && Base >= this->m_File.data()
+                    && Base <= this->m_File.data() + this->m_File.size();
+                this->m_LinesBefore = InFile ? static_cast<std::size_t>(std::count(this->m_File.data(), Base, '\n')) : 0;
+            }
+            return {this->m_LinesBefore + Before + 1, Offset - LineBegin + 1};
+        }
+
+    private:
+        std::vector<std::string_view> m_Views;
+        std::shared_ptr<const StructuralIndex> m_Index;
+        std::string_view m_File;
+        mutable std::size_t m_LinesBefore = std::string_view::npos; // newlines in m_File in front of the index
+    };
+
+    /**
+     *  Splits a whole .osu/.osb buffer into trimmed, non-comment line views grouped by section name.
+     *
+     *  Nothing is copied: every view points into the buffer, which must outlive the Tokenizer.
+     *  Lines of [Events] keep their leading spaces/underscores, since those encode command depth.
+     *
+     *  FindSections and TokenizeSection expose the two halves separately, so a caller can locate every section
+     *  first and only tokenize the ones it needs.
+     */
+    class Tokenizer
+    {
+    public:
+        static constexpr std::size_t MINIMUM_LINE_CHARACTERS = 3;
+        static constexpr std::size_t CHUNK_SIZE = 64 * 1024; // read size of the streaming readers
+
+        // Section name -> body ranges (a section may appear more than once), in file order
+        using SectionRanges = std::unordered_map<std::string_view, std::vector<std::string_view>>;
+
+        Tokenizer() = default;
+        explicit Tokenizer(const std::string_view Buffer)
+        {
+            this->Tokenize(Buffer);
+        }
+
+        void Tokenize(const std::string_view Buffer)
+        {
+            for (const auto& [Section, Ranges] : FindSections(Buffer))
+                this->Sections.insert_or_assign(Section, TokenizeSection(Ranges, Section == "Events"));
+        }
+
+        /**
+         *  Locates the section headers of Buffer without looking at the lines in between: only lines holding a '['
+         *  are inspected, so a large [Events] block costs a memchr pass. Lines before the first header are
+         *  recorded under the empty name.
+         */
+        static SectionRanges FindSections(const std::string_view Buffer)
+        {
+            SectionRanges Ranges;
+            std::string_view CurrentSection = {};
+            std::size_t BodyBegin = 0;
+            ForEachHeader(Buffer, 0, {}, [&](const std::string_view Section, const std::size_t LineBegin,
+                                             const std::size_t NextBodyBegin)
+            {
+                Ranges[CurrentSection].push_back(Buffer.substr(BodyBegin, LineBegin - BodyBegin));
+                CurrentSection = Section;
+                BodyBegin = NextBodyBegin;
+                return true;
+            });
+            Ranges[CurrentSection].push_back(Buffer.substr(BodyBegin));
+            return Ranges;
+        }
+
+        /**
+         *  Calls OnHeader(Name, LineBegin, BodyBegin) for every section header at or after From, which must be the
+         *  start of a line inside CurrentSection. Scanning stops when OnHeader returns false.
+         */
+        template <typename Fn>
+        static void ForEachHeader(const std::string_view Buffer, std::size_t From, std::string_view CurrentSection,
+                                  const Fn& OnHeader)
+        {
+            while ((From = Buffer.find('[', From)) != std::string_view::npos)
+            {
+                const std::size_t LineBegin = From ? Buffer.rfind('\n', From - 1) + 1 : 0;
+                const std::size_t LineEnd = std::min(Buffer.find('\n', From), Buffer.size());
+
+                // '[' has to start the line, after indentation everywhere but in [Events]
+                const std::string_view Indent = Buffer.substr(LineBegin, From - LineBegin);
+                const bool IsEvents = CurrentSection == "Events";
+                if ((IsEvents && !Indent.empty()) || Indent.find_first_not_of(' ') != std::string_view::npos)
+                {
+                    From = LineEnd;
+                    continue;
+                }
+
+                std::string_view Header = Buffer.substr(From, LineEnd - From);
+                if (!Header.empty() && Header.back() == '\r') Header.remove_suffix(1);
+                Header = Utilities::Trim(Header, true);
+                if (Header.size() >= MINIMUM_LINE_CHARACTERS && Header.back() == ']')
+                {
+                    CurrentSection = Header.substr(1, Header.size() - 2);
+                    if (!OnHeader(CurrentSection, LineBegin, std::min(LineEnd + 1, Buffer.size()))) return;
+                }
+                From = LineEnd;
+            }
+        }
+
+        // Tokenizes the body ranges of one section, as returned by FindSections
+        static Lines TokenizeSection(const std::vector<std::string_view>& Ranges, const bool IsEvents)
+        {
+            if (Ranges.empty()) return {};
+
+            // One index over the whole span; the gaps between ranges are simply never looked at
+            const char* SpanBegin = Ranges.front().data();
+            const std::string_view Span(SpanBegin, Ranges.back().data() + Ranges.back().size() - SpanBegin);
+            auto Index = std::make_shared<const StructuralIndex>(Span);
+
+            Lines Result(Index);
+            const auto& Newlines = Index->Newlines;
+            for (const std::string_view Range : Ranges)
+            {
+                const auto RangeBegin = static_cast<std::uint32_t>(Range.data() - SpanBegin);
+                const auto RangeEnd = static_cast<std::uint32_t>(RangeBegin + Range.size());
+                auto Newline = std::lower_bound(Newlines.begin(), Newlines.end(), RangeBegin);
+
+                for (std::uint32_t Begin = RangeBegin; Begin < RangeEnd;)
+                {
+                    const std::uint32_t End = Newline != Newlines.end() && *Newline < RangeEnd ? *Newline++ : RangeEnd;
+                    std::string_view CurrentLine = Span.substr(Begin, End - Begin);
+                    Begin = End + 1;
+
+                    if (!CurrentLine.empty() && CurrentLine.back() == '\r') CurrentLine.remove_suffix(1);
+
+                    const std::string_view Trimmed = Utilities::Trim(CurrentLine);
+                    if (Trimmed.size() < MINIMUM_LINE_CHARACTERS) continue;
+                    if (Trimmed[0] == '/' && Trimmed[1] == '/') continue; // is comment
+
+                    Result.push_back(IsEvents ? Utilities::Trim(CurrentLine, true) : Trimmed);
+                }
+            }
+            return Result;
+        }
+
+        // Whether TokenizeSection would return any line, stopping at the first one
+        static bool HasLines(const std::vector<std::string_view>& Ranges)
+        {
+            for (std::string_view Range : Ranges)
+            {
+                while (!Range.empty())
+                {
+                    const std::size_t End = std::min(Range.find('\n'), Range.size());
+                    std::string_view Line = Range.substr(0, End);
+                    if (!Line.empty() && Line.back() == '\r') Line.remove_suffix(1);
+                    const std::string_view Trimmed = Utilities::Trim(Line);
+                    if (Trimmed.size() >= MINIMUM_LINE_CHARACTERS && !(Trimmed[0] == '/' && Trimmed[1] == '/'))
+                        return true;
+                    Range.remove_prefix(std::min(End + 1, Range.size()));
+                }
+            }
+            return false;
+        }
+
+        // Lines of a section, empty if the section is missing
+        [[nodiscard]] const Lines& operator[](const std::string_view Section) const
+        {
+            static const Lines Empty = {};
+            const auto Iterator = this->Sections.find(Section);
+            return Iterator != this->Sections.end() ? Iterator->second : Empty;
+        }
+
+        // Reads a whole file into one buffer; empty if it cannot be opened
+        static std::string ReadFile(const std::string& Path)
+        {
+            std::ifstream Stream(Path, std::ios::binary | std::ios::ate);
+            if (!Stream.good()) return {};
+
+            std::string Buffer(static_cast<std::size_t>(Stream.tellg()), '\0');
+            Stream.seekg(0);
+            Stream.read(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+            return Buffer;
+        }
+
+        // Same, feeding Hash every chunk right after it was read, while it is still in cache
+        static std::string ReadFile(const std::string& Path, Md5& Hash)
+        {
+            std::ifstream Stream(Path, std::ios::binary | std::ios::ate);
+            if (!Stream.good()) return {};
+
+            std::string Buffer(static_cast<std::size_t>(Stream.tellg()), '\0');
+            Stream.seekg(0);
+            for (std::size_t Offset = 0; Offset < Buffer.size(); Offset += CHUNK_SIZE)
+            {
+                const std::size_t Size = std::min(CHUNK_SIZE, Buffer.size() - Offset);
+                Stream.read(Buffer.data() + Offset, static_cast<std::streamsize>(Size));
+                Hash.Update(std::string_view(Buffer).substr(Offset, Size));
+            }
+            return Buffer;
+        }
+
+        /**
+         *  Reads Path only until every section in Wanted has been closed by the header that follows it, so the
+         *  returned buffer ends right before that header. Reads the whole file when a wanted section is last or
+         *  missing. A wanted section that appears a second time after that point is not read.
+         */
+        static std::string ReadFile(const std::string& Path, const std::vector<std::string_view>& Wanted)
+        {
+            std::ifstream Stream(Path, std::ios::binary);
+            if (!Stream.good()) return {};
+            return ReadStream(Stream, Wanted);
+        }
+
+        // Reads Stream to its end
+        static std::string ReadStream(std::istream& Stream)
+        {
+            std::string Buffer;
+            while (Stream)
+            {
+                const std::size_t Size = Buffer.size();
+                Buffer.resize(Size + CHUNK_SIZE);
+                Stream.read(Buffer.data() + Size, CHUNK_SIZE);
+                Buffer.resize(Size + static_cast<std::size_t>(Stream.gcount()));
+            }
+            return Buffer;
+        }
+
+        // Reads Stream to its end, feeding Hash every chunk as it comes in
+        static std::string ReadStream(std::istream& Stream, Md5& Hash)
+        {
+            std::string Buffer;
+            while (Stream)
+            {
+                const std::size_t Size = Buffer.size();
+                Buffer.resize(Size + CHUNK_SIZE);
+                Stream.read(Buffer.data() + Size, CHUNK_SIZE);
+                Buffer.resize(Size + static_cast<std::size_t>(Stream.gcount()));
+                Hash.Update(std::string_view(Buffer).substr(Size));
+            }
+            return Buffer;
+        }
+
+        // Same as ReadFile(Path, Wanted), from the current position of Stream
+        static std::string ReadStream(std::istream& Stream, const std::vector<std::string_view>& Wanted)
+        {
+            std::string Buffer;
+            std::string CurrentSection; // owned, Buffer grows under it
+            std::size_t Scanned = 0; // start of the first line not scanned for headers yet
+            std::size_t Closed = 0;
+            std::vector<bool> Seen(Wanted.size());
+            while (Stream)
+            {
+                const std::size_t Size = Buffer.size();
+                Buffer.resize(Size + CHUNK_SIZE);
+                Stream.read(Buffer.data() + Size, CHUNK_SIZE);
+                Buffer.resize(Size + static_cast<std::size_t>(Stream.gcount()));
+
+                // only complete lines, a header may be cut at the end of the chunk
+                const std::size_t LastNewline = Buffer.rfind('\n');
+                if (LastNewline == std::string::npos || LastNewline + 1 <= Scanned) continue;
+
+                std::size_t Stop = std::string::npos;
+                ForEachHeader(std::string_view(Buffer).substr(0, LastNewline + 1), Scanned, CurrentSection,
+                              [&](const std::string_view Section, const std::size_t LineBegin, std::size_t)
+                              {
+                                  for (std::size_t i = 0; i < Wanted.size(); i++)
+                                      if (!Seen[i] && Wanted[i] == CurrentSection)
+                                      {
+                                          Seen[i] = true;
+                                          ++Closed;
+                                      }
+                                  CurrentSection = Section;
+                                  if (Closed < Wanted.size()) return true;
+                                  Stop = LineBegin;
+                                  return false;
+                              });
+                if (Stop != std::string::npos)
+                {
+                    Buffer.resize(Stop);
+                    return Buffer;
+                }
+                Scanned = LastNewline + 1;
+            }
+            return Buffer;
+        }
+
+    public:
+        std::unordered_map<std::string_view, Lines> Sections = {};
+    };
+}
@@ -1,9 +1,14 @@
 #pragma once
 #define POCKETLZMA_LZMA_C_DEFINE
+#include <cstddef>
+#include <istream>
+#include <span>
 #include <string>
 #include <vector>
+#include "Instrumentation.hpp"
 #include "Utilities.hpp"
 #include "Reader/Reader.hpp"
+#include "Reader/FrameParser.hpp"
 #include "Structures/Replay/ReplayAction.hpp"
 #include "Dependencies/pocketlzma/pocketlzma.hpp"
 
@@ -19,7 +24,31 @@ namespace OsuParser
             {
                 return;
             }
+            this->Parse();
+        }
+
+        // Parses a .osr held in memory, in place; Buffer only has to outlive the constructor
+        explicit Replay(const std::span<const std::byte> Buffer)
+        {
+            this->Reset();
+            this->m_Reader.SetBuffer(Buffer);
+            this->Parse();
+        }
+
+        // Reads a .osr from the current position of Stream
+        explicit Replay(std::istream& Stream)
+        {
+            this->Reset();
+            if(!m_Reader.SetStream(Stream))
+            {
+                return;
+            }
+            this->Parse();
+        }
 
+    private:
+        void Parse()
+        {
             this->ReplayMode = this->m_Reader.ReadType<std::uint8_t>();
             this->Version = this->m_Reader.ReadType<std::uint32_t>();
             this->BeatmapHash = this->m_Reader.ReadString();
@@ -40,42 +69,32 @@ namespace OsuParser
             this->ReplayLength = this->m_Reader.ReadType<std::uint32_t>();
 
             if(this->ReplayLength > 0)
-            {   
-                std::uint8_t* ReplayBytes = new std::uint8_t[ReplayLength];
-                this->m_Reader.GetStream().read(reinterpret_cast<char*>(ReplayBytes), ReplayLength);
-                
-                std::vector<std::uint8_t> DecompressedBytes = {};
-                plz::PocketLzma LZMA;
-                LZMA.decompress(ReplayBytes, ReplayLength, DecompressedBytes);
-                DecompressedBytes[ReplayLength - 1] = '\0';
-            
-                std::string ReplayString = reinterpret_cast<char*>(DecompressedBytes.data());
-                std::vector<std::string> ActionStrings = Utilities::Split(ReplayString, ',');
-                std::int64_t TotalSongTime = 0;
+            {
+                std::vector<std::byte> Scratch;
+                std::span<const std::byte> ReplayBytes;
+                {
+                    OSU_PARSER_PHASE(Instrumentation::Phase::FileRead);
+                    ReplayBytes = this->m_Reader.ReadSpan(this->ReplayLength, Scratch);
+                }
 
-                for(const std::string& Action : ActionStrings)
+                std::vector<std::uint8_t> DecompressedBytes = {};
                 {
-                    std::vector<std::string> SplitAction = Utilities::Split(Action, '|');
-                    if(SplitAction.size() == 4)
-                    {
-                        ReplayAction Action;
-                        Action.Offset = std::stol(SplitAction[0]);
-                        Action.X = std::stof(SplitAction[1]);
-                        Action.Y = std::stof(SplitAction[2]);
-                        Action.Keys = std::stoi(SplitAction[3]);
-                        if(Action.Offset == -12345 || Action.Offset < 0 || (!Action.Offset && !TotalSongTime))
-                            continue;
-                        TotalSongTime += Action.Offset;
-                        Action.Offset = TotalSongTime;
-                        this->Actions.push_back(Action);
-                    }
+                    OSU_PARSER_PHASE(Instrumentation::Phase::LzmaDecode);
+                    plz::PocketLzma LZMA;
+                    LZMA.decompress(reinterpret_cast<const std::uint8_t*>(ReplayBytes.data()), ReplayBytes.size(),
+                                    DecompressedBytes);
                 }
 
+                OSU_PARSER_PHASE(Instrumentation::Phase::FrameParse);
+                FrameParser Frames;
+                Frames.Push(reinterpret_cast<const char*>(DecompressedBytes.data()), DecompressedBytes.size());
+                Frames.Finish();
+                this->Actions = std::move(Frames.Actions);
+
                 this->OnlineScoreID = this->m_Reader.ReadType<std::uint64_t>();
-                delete[] ReplayBytes;
             }
         }
-    private:
+
         void Reset() {}
     public:
         std::uint8_t ReplayMode;
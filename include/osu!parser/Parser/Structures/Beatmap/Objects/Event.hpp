@@ -3,13 +3,23 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <cstdint>
 #include <variant>
-#include <sstream>
+#include <ostream>
 #include <stack>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <optional>
+#include <stdexcept>
 #include "osu!parser/Parser/Structures/Beatmap/Sections/VariableSection.hpp"
+#include "osu!parser/Parser/Instrumentation.hpp"
 #include "osu!parser/Parser/Utilities.hpp"
+#include "osu!parser/Parser/Reader/Tokenizer.hpp"
+#include "osu!parser/Parser/Reader/FieldReader.hpp"
+#include "osu!parser/Parser/Writer/TextWriter.hpp"
 
 namespace OsuParser::Beatmap::Objects::Event
 {
@@ -25,7 +35,7 @@ namespace OsuParser::Beatmap::Objects::Event
                 Sprite, Animation, Sample
             };
 
-            inline EventObjectType get_event_type_from_string(std::string str)
+            inline std::optional<EventObjectType> try_get_event_type_from_string(std::string str)
             {
                 std::ranges::transform(str, str.begin(),
                                        [](const unsigned char c) { return std::tolower(c); });
@@ -41,6 +51,12 @@ namespace OsuParser::Beatmap::Objects::Event
                     return EventObjectType::Background;
                 if (str == "video" || str == "1")
                     return EventObjectType::Video;
+                return std::nullopt;
+            }
+
+            inline EventObjectType get_event_type_from_string(const std::string& str)
+            {
+                if (const auto value = try_get_event_type_from_string(str)) return *value;
                 throw std::invalid_argument("Invalid event object type: " + str);
             }
 
@@ -69,10 +85,10 @@ namespace OsuParser::Beatmap::Objects::Event
                 {
                     enum class ImageLayer : std::uint8_t
                     {
-                        Background = 0, Fail = 1, Pass = 2, Foreground = 3
+                        Background = 0, Fail = 1, Pass = 2, Foreground = 3, Overlay = 4
                     };
 
-                    inline ImageLayer from_string(std::string str)
+                    inline std::optional<ImageLayer> try_from_string(std::string str)
                     {
                         std::ranges::transform(str, str.begin(),
                                                [](const unsigned char& c) { return std::tolower(c); });
@@ -84,6 +100,14 @@ namespace OsuParser::Beatmap::Objects::Event
                             return ImageLayer::Pass;
                         if (str == "foreground" || str == "3")
                             return ImageLayer::Foreground;
+                        if (str == "overlay" || str == "4")
+                            return ImageLayer::Overlay;
+                        return std::nullopt;
+                    }
+
+                    inline ImageLayer from_string(const std::string& str)
+                    {
+                        if (const auto value = try_from_string(str)) return *value;
                         throw std::invalid_argument("Invalid image layer: " + str);
                     }
 
@@ -95,6 +119,7 @@ namespace OsuParser::Beatmap::Objects::Event
                         case ImageLayer::Fail: return "Fail";
                         case ImageLayer::Pass: return "Pass";
                         case ImageLayer::Foreground: return "Foreground";
+                        case ImageLayer::Overlay: return "Overlay";
                         }
                         return {};
                     }
@@ -116,7 +141,7 @@ namespace OsuParser::Beatmap::Objects::Event
                         CentreRight = 7, BottomLeft = 8, BottomRight = 9
                     };
 
-                    inline Origin from_string(std::string str)
+                    inline std::optional<Origin> try_from_string(std::string str)
                     {
                         std::ranges::transform(str, str.begin(),
                                                [](const unsigned char c) { return std::tolower(c); });
@@ -140,6 +165,12 @@ namespace OsuParser::Beatmap::Objects::Event
                             return Origin::BottomLeft;
                         if (str == "bottomright")
                             return Origin::BottomRight;
+                        return std::nullopt;
+                    }
+
+                    inline Origin from_string(const std::string& str)
+                    {
+                        if (const auto value = try_from_string(str)) return *value;
                         throw std::invalid_argument("Invalid origin: " + str);
                     }
 
@@ -263,7 +294,19 @@ namespace OsuParser::Beatmap::Objects::Event
         {
             const Type::Commands::EventCommandType type;
             int32_t startTime = 0; // not default value
-            [[nodiscard]] virtual std::string to_string(const uint32_t& depth) const = 0;
+
+            // Writes the command line and the ones nested under it, indented by depth
+            virtual void write(TextWriter& writer, uint32_t depth) const = 0;
+
+            [[nodiscard]] std::string to_string(const uint32_t& depth) const
+            {
+                TextWriter writer;
+                writer.SetLineEnding("\n");
+                write(writer, depth);
+                std::string text = writer.Take();
+                if (!text.empty()) text.pop_back();
+                return text;
+            }
 
             explicit BaseCommand(const Type::Commands::EventCommandType& command_type) : type(command_type)
             {
@@ -279,13 +322,28 @@ namespace OsuParser::Beatmap::Objects::Event
 
         [[nodiscard]] inline std::string to_string(const Commands& commands, const uint32_t& depth = 1)
         {
-            std::ostringstream oss;
+            std::string text;
             for (const auto& command : commands)
             {
-                oss << '\n';
-                oss << command->to_string(depth);
+                text += '\n';
+                text += command->to_string(depth);
             }
-            return oss.str();
+            return text;
+        }
+
+        inline void write_indent(TextWriter& writer, const uint32_t depth)
+        {
+            for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) writer << ' ';
+        }
+
+        // "F,easing,startTime,endTime" for the commands with an easing; an end time equal to the start is left empty
+        inline void write_command_start(TextWriter& writer, const uint32_t depth, const std::string_view name,
+                                        const Type::Commands::Args::Easing::Easing easing, const int32_t startTime,
+                                        const int32_t endTime)
+        {
+            write_indent(writer, depth);
+            writer << name << ',' << static_cast<uint32_t>(easing) << ',' << startTime << ',';
+            if (endTime != startTime) writer << endTime;
         }
 
         struct FadeCommand final : BaseCommand
@@ -295,32 +353,29 @@ namespace OsuParser::Beatmap::Objects::Event
             double startOpacity, endOpacity;
             std::vector<double> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "F," << easing << ',' << startTime << ',' << endTime << ','
-                    << startOpacity;
-                if (startOpacity != endOpacity)
-                    oss << ',' << endOpacity;
-                for (const auto& value : sequence) oss << ',' << value;
-                return oss.str();
+                write_command_start(writer, depth, "F", easing, startTime, endTime);
+                writer << ',' << startOpacity;
+                if (startOpacity != endOpacity) writer << ',' << endOpacity;
+                for (const auto& value : sequence) writer << ',' << value;
+                writer.NewLine();
             }
 
-            explicit FadeCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit FadeCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Fade)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endOpacity = startOpacity = std::stod(line[4]);
-                if (line.size() > 5 && !line[5].empty()) endOpacity = std::stod(line[5]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endOpacity = startOpacity = line.Get<double>(4);
+                if (line.size() > 5 && !line[5].empty()) endOpacity = line.Get<double>(5);
                 else return;
 
-                for (auto begin = line.begin() + 6; begin != line.end(); ++begin)
+                for (std::size_t i = 6; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(std::stod(*begin));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(line.Get<double>(i));
                 }
             }
         };
@@ -332,35 +387,32 @@ namespace OsuParser::Beatmap::Objects::Event
             double startX, startY, endX, endY;
             std::vector<std::pair<double, double>> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "M," << easing << ',' << startTime << ',' << endTime << ','
-                    << startX << ',' << startY;
-                if (startX != endX || startY != endY)
-                    oss << ',' << endX << ',' << endY;
-                for (const auto& [x, y] : sequence)
-                    oss << ',' << x << ',' << y;
-                return oss.str();
+                write_command_start(writer, depth, "M", easing, startTime, endTime);
+                writer << ',' << startX << ',' << startY;
+                if (startX != endX || startY != endY) writer << ',' << endX << ',' << endY;
+                for (const auto& [x, y] : sequence) writer << ',' << x << ',' << y;
+                writer.NewLine();
             }
 
-            explicit MoveCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit MoveCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Move)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endX = startX = std::stod(line[4]);
-                endY = startY = std::stod(line[5]);
-                if (line.size() > 6 && !line[6].empty()) endX = std::stod(line[6]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endX = startX = line.Get<double>(4);
+                endY = startY = line.Get<double>(5);
+                if (line.size() > 6 && !line[6].empty()) endX = line.Get<double>(6);
                 else return;
-                if (line.size() > 7 && !line[7].empty()) endY = std::stod(line[7]);
+                if (line.size() > 7 && !line[7].empty()) endY = line.Get<double>(7);
                 else return;
-                for (auto begin = line.begin() + 8; begin != line.end(); ++begin)
+                for (std::size_t i = 8; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.emplace_back(std::stod(*begin), std::stod(*(++begin)));
+                    if (line[i].empty()) continue;
+                    const double first = line.Get<double>(i);
+                    sequence.emplace_back(first, line.Get<double>(++i));
                 }
             }
         };
@@ -372,31 +424,29 @@ namespace OsuParser::Beatmap::Objects::Event
             double startX, endX;
             std::vector<double> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "MX," << easing << ',' << startTime << ',' << endTime << ',' << startX;
-                if (startX != endX)
-                    oss << ',' << endX;
-                for (const auto& x : sequence) oss << ',' << x;
-                return oss.str();
+                write_command_start(writer, depth, "MX", easing, startTime, endTime);
+                writer << ',' << startX;
+                if (startX != endX) writer << ',' << endX;
+                for (const auto& x : sequence) writer << ',' << x;
+                writer.NewLine();
             }
 
-            explicit MoveXCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit MoveXCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::MoveX)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endX = startX = std::stod(line[4]);
-                if (line.size() > 5 && !line[5].empty()) endX = std::stod(line[5]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endX = startX = line.Get<double>(4);
+                if (line.size() > 5 && !line[5].empty()) endX = line.Get<double>(5);
                 else return;
 
-                for (auto begin = line.begin() + 6; begin != line.end(); ++begin)
+                for (std::size_t i = 6; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(std::stod(*begin));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(line.Get<double>(i));
                 }
             }
         };
@@ -408,32 +458,29 @@ namespace OsuParser::Beatmap::Objects::Event
             double startY, endY;
             std::vector<double> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "MY," << easing << ',' << startTime << ',' << endTime << ',' << startY;
-                if (startY != endY)
-                    oss << ',' << endY;
-                for (const auto& y : sequence)
-                    oss << ',' << y;
-                return oss.str();
+                write_command_start(writer, depth, "MY", easing, startTime, endTime);
+                writer << ',' << startY;
+                if (startY != endY) writer << ',' << endY;
+                for (const auto& y : sequence) writer << ',' << y;
+                writer.NewLine();
             }
 
-            explicit MoveYCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit MoveYCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::MoveY)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endY = startY = std::stod(line[4]);
-                if (line.size() > 5 && !line[5].empty()) endY = std::stod(line[5]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endY = startY = line.Get<double>(4);
+                if (line.size() > 5 && !line[5].empty()) endY = line.Get<double>(5);
                 else return;
 
-                for (auto begin = line.begin() + 6; begin != line.end(); ++begin)
+                for (std::size_t i = 6; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(std::stod(*begin));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(line.Get<double>(i));
                 }
             }
         };
@@ -445,32 +492,29 @@ namespace OsuParser::Beatmap::Objects::Event
             double startScale, endScale;
             std::vector<double> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "S," << easing << ',' << startTime << ',' << endTime << ',' << startScale;
-                if (startScale != endScale)
-                    oss << ',' << endScale;
-                for (const auto& value : sequence)
-                    oss << ',' << value;
-                return oss.str();
+                write_command_start(writer, depth, "S", easing, startTime, endTime);
+                writer << ',' << startScale;
+                if (startScale != endScale) writer << ',' << endScale;
+                for (const auto& value : sequence) writer << ',' << value;
+                writer.NewLine();
             }
 
-            explicit ScaleCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit ScaleCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Scale)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endScale = startScale = std::stod(line[4]);
-                if (line.size() > 5 && !line[5].empty()) endScale = std::stod(line[5]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endScale = startScale = line.Get<double>(4);
+                if (line.size() > 5 && !line[5].empty()) endScale = line.Get<double>(5);
                 else return;
 
-                for (auto begin = line.begin() + 6; begin != line.end(); ++begin)
+                for (std::size_t i = 6; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(std::stod(*begin));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(line.Get<double>(i));
                 }
             }
         };
@@ -482,35 +526,32 @@ namespace OsuParser::Beatmap::Objects::Event
             double startXScale, startYScale, endXScale, endYScale;
             std::vector<std::pair<double, double>> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "V," << easing << ',' << startTime << ',' << endTime << ','
-                    << startXScale << ',' << startYScale;
-                if (startXScale != endXScale || startYScale != endYScale)
-                    oss << ',' << endXScale << ',' << endYScale;
-                for (const auto& [x, y] : sequence)
-                    oss << ',' << x << ',' << y;
-                return oss.str();
+                write_command_start(writer, depth, "V", easing, startTime, endTime);
+                writer << ',' << startXScale << ',' << startYScale;
+                if (startXScale != endXScale || startYScale != endYScale) writer << ',' << endXScale << ',' << endYScale;
+                for (const auto& [x, y] : sequence) writer << ',' << x << ',' << y;
+                writer.NewLine();
             }
 
-            explicit VectorScaleCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit VectorScaleCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::VectorScale)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endXScale = startXScale = std::stod(line[4]);
-                endYScale = startYScale = std::stod(line[5]);
-                if (line.size() > 6 && !line[6].empty()) endXScale = std::stod(line[6]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endXScale = startXScale = line.Get<double>(4);
+                endYScale = startYScale = line.Get<double>(5);
+                if (line.size() > 6 && !line[6].empty()) endXScale = line.Get<double>(6);
                 else return;
-                if (line.size() > 7 && !line[7].empty()) endYScale = std::stod(line[7]);
+                if (line.size() > 7 && !line[7].empty()) endYScale = line.Get<double>(7);
                 else return;
-                for (auto begin = line.begin() + 8; begin != line.end(); ++begin)
+                for (std::size_t i = 8; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.emplace_back(std::stod(*begin), std::stod(*(++begin)));
+                    if (line[i].empty()) continue;
+                    const double first = line.Get<double>(i);
+                    sequence.emplace_back(first, line.Get<double>(++i));
                 }
             }
         };
@@ -522,32 +563,29 @@ namespace OsuParser::Beatmap::Objects::Event
             double startRotate, endRotate;
             std::vector<double> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "R," << easing << ',' << startTime << ',' << endTime << ',' << startRotate;
-                if (startRotate != endRotate)
-                    oss << ',' << endRotate;
-                for (const auto& value : sequence)
-                    oss << ',' << value;
-                return oss.str();
+                write_command_start(writer, depth, "R", easing, startTime, endTime);
+                writer << ',' << startRotate;
+                if (startRotate != endRotate) writer << ',' << endRotate;
+                for (const auto& value : sequence) writer << ',' << value;
+                writer.NewLine();
             }
 
-            explicit RotateCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit RotateCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Rotate)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endRotate = startRotate = std::stod(line[4]);
-                if (line.size() > 5 && !line[5].empty()) endRotate = std::stod(line[5]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endRotate = startRotate = line.Get<double>(4);
+                if (line.size() > 5 && !line[5].empty()) endRotate = line.Get<double>(5);
                 else return;
 
-                for (auto begin = line.begin() + 6; begin != line.end(); ++begin)
+                for (std::size_t i = 6; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(std::stod(*begin));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(line.Get<double>(i));
                 }
             }
         };
@@ -559,38 +597,36 @@ namespace OsuParser::Beatmap::Objects::Event
             int32_t startR, startG, startB, endR, endG, endB;
             std::vector<std::tuple<int32_t, int32_t, int32_t>> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "C," << easing << ',' << startTime << ',' << endTime << ','
-                    << startR << ',' << startG << ',' << startB;
-                if (startR != endR || startG != endG || startB != endB)
-                    oss << ',' << endR << ',' << endG << ',' << endB;
-                for (const auto& [r, g, b] : sequence)
-                    oss << ',' << r << ',' << g << ',' << b;
-                return oss.str();
+                write_command_start(writer, depth, "C", easing, startTime, endTime);
+                writer << ',' << startR << ',' << startG << ',' << startB;
+                if (startR != endR || startG != endG || startB != endB) writer << ',' << endR << ',' << endG << ',' << endB;
+                for (const auto& [r, g, b] : sequence) writer << ',' << r << ',' << g << ',' << b;
+                writer.NewLine();
             }
 
-            explicit ColorCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit ColorCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Color)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
-                endR = startR = std::stoi(line[4]);
-                endG = startG = std::stoi(line[5]);
-                endB = startB = std::stoi(line[6]);
-                if (line.size() > 7 && !line[7].empty()) endR = std::stoi(line[7]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                endR = startR = line.Get<int32_t>(4);
+                endG = startG = line.Get<int32_t>(5);
+                endB = startB = line.Get<int32_t>(6);
+                if (line.size() > 7 && !line[7].empty()) endR = line.Get<int32_t>(7);
                 else return;
-                if (line.size() > 8 && !line[8].empty()) endG = std::stoi(line[8]);
+                if (line.size() > 8 && !line[8].empty()) endG = line.Get<int32_t>(8);
                 else return;
-                if (line.size() > 9 && !line[9].empty()) endB = std::stoi(line[9]);
+                if (line.size() > 9 && !line[9].empty()) endB = line.Get<int32_t>(9);
                 else return;
-                for (auto begin = line.begin() + 10; begin != line.end(); ++begin)
+                for (std::size_t i = 10; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.emplace_back(std::stoi(*begin), std::stoi(*(++begin)), std::stoi(*(++begin)));
+                    if (line[i].empty()) continue;
+                    const int32_t r = line.Get<int32_t>(i);
+                    const int32_t g = line.Get<int32_t>(++i);
+                    sequence.emplace_back(r, g, line.Get<int32_t>(++i));
                 }
             }
         };
@@ -602,27 +638,30 @@ namespace OsuParser::Beatmap::Objects::Event
             Type::Commands::Args::Parameter::Parameter parameter;
             std::vector<Type::Commands::Args::Parameter::Parameter> sequence;
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "P," << easing << ',' << startTime << ',' << endTime << ',' << parameter;
-                for (const auto& value : sequence)
-                    oss << ',' << value;
-                return oss.str();
+                write_command_start(writer, depth, "P", easing, startTime, endTime);
+                writer << ',' << static_cast<char>(parameter);
+                for (const auto& value : sequence) writer << ',' << static_cast<char>(value);
+                writer.NewLine();
             }
 
-            explicit ParameterCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit ParameterCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Parameter)
             {
-                easing = static_cast<Type::Commands::Args::Easing::Easing>(std::stoi(line[1]));
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
+                easing = static_cast<Type::Commands::Args::Easing::Easing>(line.Get<int32_t>(1));
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
+                if (line[4].empty())
+                {
+                    line.Fail(4, line[4], ParseErrorCode::MissingField);
+                    return;
+                }
                 parameter = static_cast<Type::Commands::Args::Parameter::Parameter>(line[4].front());
-                for (auto begin = line.begin() + 5; begin != line.end(); ++begin)
+                for (std::size_t i = 5; i < line.size(); ++i)
                 {
-                    if (begin->empty()) continue;
-                    sequence.push_back(static_cast<Type::Commands::Args::Parameter::Parameter>(begin->front()));
+                    if (line[i].empty()) continue;
+                    sequence.push_back(static_cast<Type::Commands::Args::Parameter::Parameter>(line[i].front()));
                 }
             }
         };
@@ -632,26 +671,19 @@ namespace OsuParser::Beatmap::Objects::Event
             int32_t loopCount;
             CommandsPtr commands = std::make_shared<Commands>();
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "L," << startTime << ',' << loopCount;
-
-                const auto new_depth = depth + 1;
-                for (const auto& command : *commands)
-                {
-                    oss << '\n';
-                    oss << command->to_string(new_depth);
-                }
-                return oss.str();
+                write_indent(writer, depth);
+                writer << "L," << startTime << ',' << loopCount;
+                writer.NewLine();
+                for (const auto& command : *commands) command->write(writer, depth + 1);
             }
 
-            explicit LoopCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit LoopCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Loop)
             {
-                startTime = std::stoi(line[1]);
-                loopCount = std::stoi(line[2]);
+                startTime = line.Get<int32_t>(1);
+                loopCount = line.Get<int32_t>(2);
             }
         };
 
@@ -661,33 +693,25 @@ namespace OsuParser::Beatmap::Objects::Event
             std::string triggerType;
             CommandsPtr commands = std::make_shared<Commands>();
 
-            [[nodiscard]] std::string to_string(const uint32_t& depth) const override
+            void write(TextWriter& writer, const uint32_t depth) const override
             {
-                std::ostringstream oss;
-                for (uint32_t current_depth = 1; current_depth <= depth; ++current_depth) oss << ' ';
-                oss << "T," << triggerType << ',' << startTime;
-                if (startTime != endTime)
-                    oss << ',' << endTime;
-
-                const auto new_depth = depth + 1;
-                for (const auto& command : *commands)
-                {
-                    oss << '\n';
-                    oss << command->to_string(new_depth);
-                }
-                return oss.str();
+                write_indent(writer, depth);
+                writer << "T," << triggerType << ',' << startTime;
+                if (startTime != endTime) writer << ',' << endTime;
+                writer.NewLine();
+                for (const auto& command : *commands) command->write(writer, depth + 1);
             }
 
-            explicit TriggerCommand(const std::vector<std::string>& line) : BaseCommand(
+            explicit TriggerCommand(FieldReader& line) : BaseCommand(
                 Type::Commands::EventCommandType::Trigger)
             {
                 triggerType = line[1];
-                endTime = startTime = std::stoi(line[2]);
-                if (!line[3].empty()) endTime = std::stoi(line[3]);
+                endTime = startTime = line.Get<int32_t>(2);
+                if (!line[3].empty()) endTime = line.Get<int32_t>(3);
             }
         };
 
-        inline size_t get_line_depth(const std::string& raw_event_arg)
+        inline size_t get_line_depth(const std::string_view raw_event_arg)
         {
             if (raw_event_arg.front() != ' ' && raw_event_arg.front() != '_') return 0;
             return std::max(
@@ -704,7 +728,19 @@ namespace OsuParser::Beatmap::Objects::Event
         {
             const Type::Objects::EventObjectType type;
 
-            [[nodiscard]] virtual std::string to_string(uint32_t& current_depth) const = 0;
+            // Writes the object line and its commands
+            virtual void write(TextWriter& writer) const = 0;
+
+            // The depth argument is kept for existing callers; the commands indent themselves
+            [[nodiscard]] std::string to_string(uint32_t&) const
+            {
+                TextWriter writer;
+                writer.SetLineEnding("\n");
+                write(writer);
+                std::string text = writer.Take();
+                if (!text.empty()) text.pop_back();
+                return text;
+            }
 
             explicit Object(const Type::Objects::EventObjectType& event) : type(event)
             {
@@ -715,26 +751,36 @@ namespace OsuParser::Beatmap::Objects::Event
 
         using ObjectPtr = std::shared_ptr<Object>;
 
+        // Named field through one of the try_from_string functions; an unknown name is reported to line
+        template <typename Fn>
+        auto read_name(FieldReader& line, const std::size_t index, const Fn& try_from_string)
+        {
+            const auto value = try_from_string(std::string(line[index]));
+            if (!value)
+                line.Fail(index, line[index],
+                          index < line.size() ? ParseErrorCode::InvalidValue : ParseErrorCode::MissingField);
+            return value.value_or(typename decltype(value)::value_type{});
+        }
+
         struct BackgroundObject final : Object
         {
             const int32_t startTime = 0;
             std::string filename;
             int32_t x_offset = 0, y_offset = 0;
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << startTime << ',' << filename << ',' << x_offset << ',' << y_offset;
-                return oss.str();
+                writer << "0," << startTime << ",\"" << filename << "\"," << x_offset << ',' << y_offset;
+                writer.NewLine();
             }
 
-            explicit BackgroundObject(const std::vector<std::string>& line) : Object(
+            explicit BackgroundObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Background)
             {
                 if (line.size() < 3) return;
                 filename = Utilities::Trim(line[2], false, '"');
-                if (line.size() > 3 && !line[3].empty()) x_offset = std::stoi(line[3]);
-                if (line.size() > 4 && !line[4].empty()) y_offset = std::stoi(line[4]);
+                if (line.size() > 3 && !line[3].empty()) x_offset = line.Get<int32_t>(3);
+                if (line.size() > 4 && !line[4].empty()) y_offset = line.Get<int32_t>(4);
             }
         };
 
@@ -744,20 +790,21 @@ namespace OsuParser::Beatmap::Objects::Event
             std::string filename;
             int32_t x_offset = 0, y_offset = 0;
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << startTime << ',' << filename << ',' << x_offset << ',' << y_offset;
-                return oss.str();
+                writer << "Video," << startTime << ",\"" << filename << '"';
+                if (x_offset || y_offset) writer << ',' << x_offset << ',' << y_offset;
+                writer.NewLine();
             }
 
-            explicit VideoObject(const std::vector<std::string>& line) : Object(
+            explicit VideoObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Video)
             {
                 if (line.size() < 3) return;
+                if (!line[1].empty()) startTime = line.Get<int32_t>(1);
                 filename = Utilities::Trim(line[2], false, '"');
-                if (line.size() > 3 && !line[3].empty()) x_offset = std::stoi(line[3]);
-                if (line.size() > 4 && !line[4].empty()) y_offset = std::stoi(line[4]);
+                if (line.size() > 3 && !line[3].empty()) x_offset = line.Get<int32_t>(3);
+                if (line.size() > 4 && !line[4].empty()) y_offset = line.Get<int32_t>(4);
             }
         };
 
@@ -765,19 +812,17 @@ namespace OsuParser::Beatmap::Objects::Event
         {
             int32_t startTime = 0, endTime = 0;
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << startTime << ',' << endTime;
-                return oss.str();
+                writer << "2," << startTime << ',' << endTime;
+                writer.NewLine();
             }
 
-            explicit BreakObject(const std::vector<std::string>& line) : Object(
+            explicit BreakObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Break)
             {
-                if (line.size() < 3) return;
-                startTime = std::stoi(line[1]);
-                endTime = std::stoi(line[2]);
+                startTime = line.Get<int32_t>(1);
+                endTime = line.Get<int32_t>(2);
             }
         };
 
@@ -789,24 +834,22 @@ namespace OsuParser::Beatmap::Objects::Event
             double x, y;
             Commands::CommandsPtr commands = std::make_shared<Commands::Commands>();
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << layer << ',' << origin << ',' << '"' << filepath << '"' << ',' << x << ',' << y;
-                oss << Commands::to_string(*commands, ++current_depth);
-                --current_depth;;
-                return oss.str();
+                writer << "Sprite," << Type::Objects::Args::Layer::to_string(layer) << ','
+                    << Type::Objects::Args::Origin::to_string(origin) << ",\"" << filepath << "\"," << x << ',' << y;
+                writer.NewLine();
+                for (const auto& command : *commands) command->write(writer, 1);
             }
 
-            explicit SpriteObject(const std::vector<std::string>& line) : Object(
+            explicit SpriteObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Sprite)
             {
-                if (line.size() <= 5) return;
-                layer = Type::Objects::Args::Layer::from_string(line[1]);
-                origin = Type::Objects::Args::Origin::from_string(line[2]);
+                layer = read_name(line, 1, Type::Objects::Args::Layer::try_from_string);
+                origin = read_name(line, 2, Type::Objects::Args::Origin::try_from_string);
                 filepath = Utilities::Trim(line[3], false, '"');
-                x = std::stod(line[4]);
-                y = std::stod(line[5]);
+                x = line.Get<double>(4);
+                y = line.Get<double>(5);
             }
         };
 
@@ -821,29 +864,27 @@ namespace OsuParser::Beatmap::Objects::Event
             Type::Objects::Args::Loop::Loop looptype = Type::Objects::Args::Loop::Loop::LoopForever;
             Commands::CommandsPtr commands = std::make_shared<Commands::Commands>();
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << layer << ',' << origin << ',' << '"' << filepath << '"' << ',' << x << ',' << y;
-                oss << ',' << frameCount << ',' << frameDelay << ',' << looptype;
-                oss << Commands::to_string(*commands, ++current_depth);
-                --current_depth;;
-                return oss.str();
+                writer << "Animation," << Type::Objects::Args::Layer::to_string(layer) << ','
+                    << Type::Objects::Args::Origin::to_string(origin) << ",\"" << filepath << "\"," << x << ',' << y << ','
+                    << frameCount << ',' << frameDelay << ',' << Type::Objects::Args::Loop::to_string(looptype);
+                writer.NewLine();
+                for (const auto& command : *commands) command->write(writer, 1);
             }
 
-            explicit AnimationObject(const std::vector<std::string>& line) : Object(
+            explicit AnimationObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Animation)
             {
-                if (line.size() <= 7) return;
-                layer = Type::Objects::Args::Layer::from_string(line[1]);
-                origin = Type::Objects::Args::Origin::from_string(line[2]);
+                layer = read_name(line, 1, Type::Objects::Args::Layer::try_from_string);
+                origin = read_name(line, 2, Type::Objects::Args::Origin::try_from_string);
                 filepath = Utilities::Trim(line[3], false, '"');
-                x = std::stod(line[4]);
-                y = std::stod(line[5]);
-                frameCount = std::stoi(line[6]);
-                frameDelay = std::stod(line[7]);
+                x = line.Get<double>(4);
+                y = line.Get<double>(5);
+                frameCount = line.Get<int32_t>(6);
+                frameDelay = line.Get<double>(7);
                 if (line.size() > 8 && !line[8].empty())
-                    looptype = Type::Objects::Args::Loop::from_string(line[8]);
+                    looptype = Type::Objects::Args::Loop::from_string(std::string(line[8]));
             }
         };
 
@@ -854,22 +895,20 @@ namespace OsuParser::Beatmap::Objects::Event
             std::string filepath;
             uint8_t volume = 100;
 
-            [[nodiscard]] std::string to_string(uint32_t& current_depth) const override
+            void write(TextWriter& writer) const override
             {
-                std::ostringstream oss;
-                oss << type << ',' << time << ',' << layer_num << ',' << '"' << filepath << '"'
-                    << ',' << static_cast<uint32_t>(volume);
-                return oss.str();
+                writer << "Sample," << time << ',' << static_cast<uint32_t>(layer_num) << ",\"" << filepath << "\","
+                    << static_cast<uint32_t>(volume);
+                writer.NewLine();
             }
 
-            explicit SampleObject(const std::vector<std::string>& line) : Object(
+            explicit SampleObject(FieldReader& line) : Object(
                 Type::Objects::EventObjectType::Sample)
             {
-                if (line.size() < 4) return;
-                time = std::stoi(line[1]);
-                layer_num = Type::Objects::Args::Layer::from_string(line[2]);
+                time = line.Get<int32_t>(1);
+                layer_num = read_name(line, 2, Type::Objects::Args::Layer::try_from_string);
                 filepath = Utilities::Trim(line[3], false, '"');
-                if (line.size() > 4 && !line[4].empty()) volume = static_cast<uint8_t>(std::stoi(line[4]));
+                if (line.size() > 4 && !line[4].empty()) volume = static_cast<uint8_t>(line.Get<int32_t>(4));
             }
         };
     }
@@ -878,101 +917,182 @@ namespace OsuParser::Beatmap::Objects::Event
     {
         std::vector<Objects::ObjectPtr> objects;
 
-        void Parse(std::vector<std::string>& lines, const Sections::Variable::VariableSection& variables = {})
+        /**
+         *  Appends the objects of lines with their commands, and returns how many lines were taken. A line with a
+         *  bad field is left out along with every command nested under it, and reported to log; in Strict mode
+         *  parsing stops there and the error is returned.
+         */
+        Expected<std::size_t> Parse(const Lines& lines, const Sections::Variable::VariableSection& variables = {},
+                                    ParseLog* log = nullptr)
         {
-            if (!variables.Variables.empty())
-                for (auto& line : lines) variables.ProvideVariable(line);
-
-            std::stack<Commands::CommandsWeakPtr> levels;
-            for (auto& line : lines)
+            std::deque<std::string> substituted_lines; // owns lines that had variables replaced
+            std::stack<Commands::CommandsWeakPtr> levels; // an empty entry swallows the commands of a skipped line
+            FieldReader fields(lines, "Events");
+            std::size_t taken = 0;
+            for (const std::string_view raw_line : lines)
             {
-                std::vector<std::string> SplitObject = Utilities::Split(line, ',');
+                std::string_view line = raw_line;
+                if (!variables.Variables.empty() && line.find('$') != std::string_view::npos)
+                {
+                    OSU_PARSER_PHASE_TOTAL(Instrumentation::Phase::VariableSubstitution);
+                    variables.ProvideVariable(substituted_lines.emplace_back(line));
+                    line = substituted_lines.back();
+                }
 
-                const auto depth = Commands::get_line_depth(SplitObject.front());
-                SplitObject.front().erase(0, depth); // remove all leading spaces
+                const auto depth = Commands::get_line_depth(line);
+                line.remove_prefix(std::min(depth, line.size())); // remove all leading spaces
+                fields.Read(line, ',', line.data() == raw_line.data() + depth
+                                           ? std::string_view{}
+                                           : raw_line.substr(std::min(depth, raw_line.size())));
                 while (depth < levels.size()) levels.pop();
 
+                Commands::CommandsPtr children; // where the lines nested under this one go, if they may have any
                 if (!levels.empty()) // => Command line
                 {
-                    auto commands = levels.top().lock();
-                    if (SplitObject[0] == "F") // Fade
-                        commands->emplace_back(std::make_shared<Commands::FadeCommand>(SplitObject));
-                    else if (SplitObject[0] == "M") // Move
-                        commands->emplace_back(std::make_shared<Commands::MoveCommand>(SplitObject));
-                    else if (SplitObject[0] == "MX") // MoveX
-                        commands->emplace_back(std::make_shared<Commands::MoveXCommand>(SplitObject));
-                    else if (SplitObject[0] == "MY") // MoveY
-                        commands->emplace_back(std::make_shared<Commands::MoveYCommand>(SplitObject));
-                    else if (SplitObject[0] == "S") // Scale
-                        commands->emplace_back(std::make_shared<Commands::ScaleCommand>(SplitObject));
-                    else if (SplitObject[0] == "V") // VectorScale
-                        commands->emplace_back(std::make_shared<Commands::VectorScaleCommand>(SplitObject));
-                    else if (SplitObject[0] == "R") // Rotate
-                        commands->emplace_back(std::make_shared<Commands::RotateCommand>(SplitObject));
-                    else if (SplitObject[0] == "C") // Color
-                        commands->emplace_back(std::make_shared<Commands::ColorCommand>(SplitObject));
-                    else if (SplitObject[0] == "P") // Parameter
-                        commands->emplace_back(std::make_shared<Commands::ParameterCommand>(SplitObject));
-                    else if (SplitObject[0] == "L") // Loop
+                    const auto commands = levels.top().lock();
+                    if (!commands) continue; // nested under a skipped line
+
+                    Commands::CommandPtr command;
+                    if (fields[0] == "F") // Fade
+                        command = std::make_shared<Commands::FadeCommand>(fields);
+                    else if (fields[0] == "M") // Move
+                        command = std::make_shared<Commands::MoveCommand>(fields);
+                    else if (fields[0] == "MX") // MoveX
+                        command = std::make_shared<Commands::MoveXCommand>(fields);
+                    else if (fields[0] == "MY") // MoveY
+                        command = std::make_shared<Commands::MoveYCommand>(fields);
+                    else if (fields[0] == "S") // Scale
+                        command = std::make_shared<Commands::ScaleCommand>(fields);
+                    else if (fields[0] == "V") // VectorScale
+                        command = std::make_shared<Commands::VectorScaleCommand>(fields);
+                    else if (fields[0] == "R") // Rotate
+                        command = std::make_shared<Commands::RotateCommand>(fields);
+                    else if (fields[0] == "C") // Color
+                        command = std::make_shared<Commands::ColorCommand>(fields);
+                    else if (fields[0] == "P") // Parameter
+                        command = std::make_shared<Commands::ParameterCommand>(fields);
+                    else if (fields[0] == "L") // Loop
                     {
-                        const auto parent_command = std::make_shared<Commands::LoopCommand>(SplitObject);
-                        commands->emplace_back(parent_command);
-                        levels.push(parent_command->commands);
+                        const auto parent_command = std::make_shared<Commands::LoopCommand>(fields);
+                        children = parent_command->commands;
+                        command = parent_command;
                     }
-                    else if (SplitObject[0] == "T") // Trigger
+                    else if (fields[0] == "T") // Trigger
                     {
-                        const auto parent_command = std::make_shared<Commands::TriggerCommand>(SplitObject);
-                        commands->emplace_back(std::make_shared<Commands::TriggerCommand>(SplitObject));
-                        levels.push(parent_command->commands);
+                        const auto parent_command = std::make_shared<Commands::TriggerCommand>(fields);
+                        children = parent_command->commands;
+                        command = parent_command;
                     }
+                    else continue; // unknown commands are ignored
+
+                    if (!fields.Failed()) commands->emplace_back(std::move(command));
                 }
                 else // => Objects line
                 {
-                    switch (Type::Objects::get_event_type_from_string(SplitObject[0])) // event
+                    const auto type = Type::Objects::try_get_event_type_from_string(std::string(fields[0]));
+                    if (!type) fields.Fail(0, fields[0], ParseErrorCode::InvalidValue);
+                    else
                     {
-                    case Type::Objects::EventObjectType::Background:
-                        objects.emplace_back(std::make_shared<Objects::BackgroundObject>(SplitObject));
-                        break;
-                    case Type::Objects::EventObjectType::Video:
-                        objects.emplace_back(std::make_shared<Objects::VideoObject>(SplitObject));
-                        break;
-                    case Type::Objects::EventObjectType::Break:
-                        objects.emplace_back(std::make_shared<Objects::BreakObject>(SplitObject));
-                        break;
-                    case Type::Objects::EventObjectType::Sample:
-                        objects.emplace_back(std::make_shared<Objects::SampleObject>(SplitObject));
-                        break;
-                    case Type::Objects::EventObjectType::Sprite:
+                        Objects::ObjectPtr object;
+                        switch (*type) // event
                         {
-                            const auto parent_object = std::make_shared<Objects::SpriteObject>(SplitObject);
-                            objects.emplace_back(parent_object);
-                            levels.push(parent_object->commands);
+                        case Type::Objects::EventObjectType::Background:
+                            object = std::make_shared<Objects::BackgroundObject>(fields);
+                            break;
+                        case Type::Objects::EventObjectType::Video:
+                            object = std::make_shared<Objects::VideoObject>(fields);
+                            break;
+                        case Type::Objects::EventObjectType::Break:
+                            object = std::make_shared<Objects::BreakObject>(fields);
+                            break;
+                        case Type::Objects::EventObjectType::Sample:
+                            object = std::make_shared<Objects::SampleObject>(fields);
+                            break;
+                        case Type::Objects::EventObjectType::Sprite:
+                            {
+                                const auto parent_object = std::make_shared<Objects::SpriteObject>(fields);
+                                children = parent_object->commands;
+                                object = parent_object;
+                            }
+                            break;
+                        case Type::Objects::EventObjectType::Animation:
+                            {
+                                const auto parent_object = std::make_shared<Objects::AnimationObject>(fields);
+                                children = parent_object->commands;
+                                object = parent_object;
+                            }
+                            break;
                         }
-                        break;
-                    case Type::Objects::EventObjectType::Animation:
-                        {
-                            const auto parent_object = std::make_shared<Objects::AnimationObject>(SplitObject);
-                            objects.emplace_back(parent_object);
-                            levels.push(parent_object->commands);
-                        }
-                        break;
+                        if (!fields.Failed()) objects.emplace_back(std::move(object));
                     }
                 }
+
+                if (fields.Failed())
+                {
+                    if (!ParseLog::Skip(log, fields.GetError())) return Unexpected{fields.GetError()};
+                    if (children) levels.emplace();
+                    continue;
+                }
+                if (children) levels.push(children);
+                ++taken;
             }
+            return taken;
         }
 
-        [[nodiscard]] std::string to_string() const
+        /**
+         *  The lines of [Events] the way osu! lays them out, without the header: backgrounds and videos, breaks,
+         *  the storyboard layers and the samples, each group under its comment line. Objects keep their order
+         *  within a group.
+         */
+        void write(TextWriter& writer) const
         {
-            std::ostringstream oss;
-            oss << "[Events]";
-            uint32_t current_depth = 0;
-            for (const auto& object_ptr : objects)
+            using Type::Objects::EventObjectType;
+            const auto write_group = [&](const std::string_view comment, const auto& belongs)
+            {
+                writer << comment;
+                writer.NewLine();
+                for (const auto& object : objects)
+                    if (belongs(*object)) object->write(writer);
+            };
+
+            write_group("//Background and Video events", [](const Objects::Object& object)
+            {
+                return object.type == EventObjectType::Background || object.type == EventObjectType::Video;
+            });
+            write_group("//Break Periods", [](const Objects::Object& object)
+            {
+                return object.type == EventObjectType::Break;
+            });
+            static constexpr std::array<std::string_view, 5> layer_comments = {
+                "//Storyboard Layer 0 (Background)", "//Storyboard Layer 1 (Fail)", "//Storyboard Layer 2 (Pass)",
+                "//Storyboard Layer 3 (Foreground)", "//Storyboard Layer 4 (Overlay)"
+            };
+            for (std::size_t layer = 0; layer < layer_comments.size(); ++layer)
             {
-                oss << '\n';
-                oss << object_ptr->to_string(current_depth);
+                write_group(layer_comments[layer], [layer](const Objects::Object& object)
+                {
+                    if (object.type == EventObjectType::Sprite)
+                        return static_cast<std::size_t>(static_cast<const Objects::SpriteObject&>(object).layer) == layer;
+                    if (object.type == EventObjectType::Animation)
+                        return static_cast<std::size_t>(static_cast<const Objects::AnimationObject&>(object).layer) == layer;
+                    return false;
+                });
             }
-            oss << '\n' << "// end"; // mark end of events (to make sure osu! can read it)
-            return oss.str();
+            write_group("//Storyboard Sound Samples", [](const Objects::Object& object)
+            {
+                return object.type == EventObjectType::Sample;
+            });
+        }
+
+        [[nodiscard]] std::string to_string() const
+        {
+            TextWriter writer;
+            writer.SetLineEnding("\n");
+            writer << "[Events]";
+            writer.NewLine();
+            for (const auto& object_ptr : objects) object_ptr->write(writer);
+            writer << "// end"; // mark end of events (to make sure osu! can read it)
+            return writer.Take();
         }
 
         friend std::ostream& operator<<(std::ostream& os, const Events& events)
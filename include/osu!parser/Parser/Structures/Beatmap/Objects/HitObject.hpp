@@ -2,7 +2,13 @@
 #include <algorithm>
 #include <optional>
 #include <bitset>
+#include <cmath>
+#include <string_view>
+#include <osu!parser/Parser/Instrumentation.hpp>
 #include <osu!parser/Parser/Utilities.hpp>
+#include <osu!parser/Parser/Reader/Tokenizer.hpp>
+#include <osu!parser/Parser/Reader/FieldReader.hpp>
+#include <osu!parser/Parser/Writer/TextWriter.hpp>
 #include "TimingPoint.hpp"
 
 namespace OsuParser::Beatmap::Objects::HitObject
@@ -19,6 +25,8 @@ namespace OsuParser::Beatmap::Objects::HitObject
         bool Whistle = false;
         bool Finish = false;
         bool Clap = false;
+        // Normal was set because no bit was (osu! writes 0 for that); ToInt() gives 0 again while nothing else is set
+        bool NormalImplied = false;
 
         void Import(const std::int32_t HitSound)
         {
@@ -29,13 +37,14 @@ namespace OsuParser::Beatmap::Objects::HitObject
             Finish = bitmap[2];
             Clap = bitmap[3];
 
-            if (!Normal && !Whistle && !Finish && !Clap) Normal = true;
+            NormalImplied = !Normal && !Whistle && !Finish && !Clap;
+            if (NormalImplied) Normal = true;
         }
 
         [[nodiscard]] std::int32_t ToInt() const
         {
             auto bitmap = std::bitset<4>(0);
-            bitmap[0] = Normal;
+            bitmap[0] = Normal && !(NormalImplied && !Whistle && !Finish && !Clap);
             bitmap[1] = Whistle;
             bitmap[2] = Finish;
             bitmap[3] = Clap;
@@ -56,32 +65,49 @@ namespace OsuParser::Beatmap::Objects::HitObject
     protected:
         static constexpr char DELIMETER = ':';
 
+        static std::int32_t Number(const std::vector<std::string_view>& List, const std::size_t Index,
+                                   FieldReader* Fields, const std::size_t Field)
+        {
+            if (!Fields) return Index < List.size() ? Utilities::ToInt(List[Index]) : 0;
+            if (Index >= List.size())
+            {
+                Fields->Fail(Field, {}, ParseErrorCode::MissingField);
+                return 0;
+            }
+            return Fields->Parse<std::int32_t>(List[Index], Field);
+        }
+
     public:
         SampleSet NormalSet = SampleSet::NO_CUSTOM;
         SampleSet AdditionSet = SampleSet::NO_CUSTOM;
 
-        virtual void Import(const std::string& EdgeSet)
+        // Bad numbers are reported to Fields as errors in field Field when given, read as 0 otherwise
+        virtual void Import(const std::string_view EdgeSet, FieldReader* Fields = nullptr, const std::size_t Field = 0)
         {
             if (EdgeSet.empty())
                 return; // not written
             const auto list = Utilities::Split(EdgeSet, DELIMETER);
-            NormalSet = static_cast<SampleSet>(std::stoi(list[0]));
-            AdditionSet = static_cast<SampleSet>(std::stoi(list[1]));
+            NormalSet = static_cast<SampleSet>(Number(list, 0, Fields, Field));
+            AdditionSet = static_cast<SampleSet>(Number(list, 1, Fields, Field));
         }
 
         [[nodiscard]] virtual std::string ToString() const
         {
-            std::string SampleStr;
-            SampleStr.append(std::to_string(static_cast<std::int32_t>(NormalSet)));
-            SampleStr.push_back(DELIMETER);
-            SampleStr.append(std::to_string(static_cast<std::int32_t>(AdditionSet)));
-            return SampleStr;
+            TextWriter Writer;
+            this->Write(Writer);
+            return Writer.Take();
+        }
+
+        // "normalSet:additionSet"
+        virtual void Write(TextWriter& Writer) const
+        {
+            Writer << static_cast<std::int32_t>(NormalSet) << DELIMETER << static_cast<std::int32_t>(AdditionSet);
         }
 
 
         SliderSample() = default;
         virtual ~SliderSample() = default;
-        explicit SliderSample(const std::string& SampleStr) { SliderSample::Import(SampleStr); }
+        explicit SliderSample(const std::string_view SampleStr) { SliderSample::Import(SampleStr); }
     };
     struct HitSample final : SliderSample
     {
@@ -93,35 +119,29 @@ namespace OsuParser::Beatmap::Objects::HitObject
         int Volume = 0;
         std::string Filename{};
 
-        void Import(const std::string& HitSampleStr) override
+        void Import(const std::string_view HitSampleStr, FieldReader* Fields = nullptr,
+                    const std::size_t Field = 0) override
         {
             if (HitSampleStr.empty())
                 return; // not written
             const auto list = Utilities::Split(HitSampleStr, DELIMETER);
-            NormalSet = static_cast<SampleSet>(std::stoi(list[0]));
-            AdditionSet = static_cast<SampleSet>(std::stoi(list[1]));
-            Index = std::stoi(list[2]);
-            Volume = std::stoi(list[3]);
+            NormalSet = static_cast<SampleSet>(Number(list, 0, Fields, Field));
+            AdditionSet = static_cast<SampleSet>(Number(list, 1, Fields, Field));
+            // files before v12 stop after the sets
+            if (list.size() > 2) Index = Number(list, 2, Fields, Field);
+            if (list.size() > 3) Volume = Number(list, 3, Fields, Field);
             if (list.size() > 4) Filename = list[4];
         }
 
-        [[nodiscard]] std::string ToString() const override
+        // "normalSet:additionSet:index:volume:filename"
+        void Write(TextWriter& Writer) const override
         {
-            std::string SampleStr;
-            SampleStr.append(std::to_string(static_cast<std::int32_t>(NormalSet)));
-            SampleStr.push_back(DELIMETER);
-            SampleStr.append(std::to_string(static_cast<std::int32_t>(AdditionSet)));
-            SampleStr.push_back(DELIMETER);
-            SampleStr.append(std::to_string(Index));
-            SampleStr.push_back(DELIMETER);
-            SampleStr.append(std::to_string(Volume));
-            SampleStr.push_back(DELIMETER);
-            if (!Filename.empty()) SampleStr.append(Filename);
-            return SampleStr;
+            Writer << static_cast<std::int32_t>(NormalSet) << DELIMETER << static_cast<std::int32_t>(AdditionSet)
+                << DELIMETER << Index << DELIMETER << Volume << DELIMETER << Filename;
         }
 
         HitSample() = default;
-        explicit HitSample(const std::string& HitSampleStr) { HitSample::Import(HitSampleStr); }
+        explicit HitSample(const std::string_view HitSampleStr) { HitSample::Import(HitSampleStr); }
     };
 
     struct HitObject
@@ -133,7 +153,7 @@ namespace OsuParser::Beatmap::Objects::HitObject
             bool Spinner = false;
             bool HoldNote = false; // osu!mania
             bool IsNewCombo = false;
-            std::int32_t ColourHax = 0;
+            std::int32_t ColourHax = 0; // combo colours to skip on a new combo, 0-7
 
             void Import(const std::int32_t Value)
             {
@@ -143,11 +163,13 @@ namespace OsuParser::Beatmap::Objects::HitObject
                 Spinner = bitset[3];
                 HoldNote = bitset[7];
                 IsNewCombo = bitset[2];
+                ColourHax = (Value >> 4) & 7;
+            }
 
-                const auto bit4 = bitset[4];
-                const auto bit5 = bitset[5];
-                const auto bit6 = bitset[6];
-                ColourHax = bit4 | bit5 | bit6;
+            [[nodiscard]] std::int32_t ToInt() const
+            {
+                return (HitCircle ? 1 : 0) | (Slider ? 2 : 0) | (IsNewCombo ? 4 : 0) | (Spinner ? 8 : 0)
+                    | (ColourHax & 7) << 4 | (HoldNote ? 128 : 0);
             }
 
             Type() = default;
@@ -169,22 +191,43 @@ namespace OsuParser::Beatmap::Objects::HitObject
                 Type type = Type::BEZIER;
                 std::vector<Point> Points = {};
 
-                void Import(const std::string& CurveString)
+                // Bad points are reported to Fields as errors in field Field when given, read as 0 otherwise
+                void Import(const std::string_view CurveString, FieldReader* Fields = nullptr,
+                            const std::size_t Field = 0)
                 {
-                    std::vector<std::string> Curves = Utilities::Split(CurveString, '|');
-
-                    type = static_cast<Type>(Curves.front().front());
-                    Curves.erase(Curves.begin()); // Curves become CurvePoints
+                    if (CurveString.empty())
+                    {
+                        if (Fields) Fields->Fail(Field, CurveString, ParseErrorCode::MissingField);
+                        return;
+                    }
+                    const std::vector<std::string_view> Curves = Utilities::Split(CurveString, '|');
 
-                    for (const std::string& CurvePoint : Curves)
+                    type = static_cast<Type>(Curves.front().empty() ? 'B' : Curves.front().front());
+                    Points.reserve(Curves.size() - 1);
+                    for (auto CurvePoint = Curves.begin() + 1; CurvePoint != Curves.end(); ++CurvePoint)
                     {
-                        const auto SplitPoint = Utilities::Split(CurvePoint, ':');
-                        Points.emplace_back(std::stoi(SplitPoint[0]), std::stoi(SplitPoint[1]));
+                        const auto SplitPoint = Utilities::Split(*CurvePoint, ':');
+                        if (SplitPoint.size() < 2)
+                        {
+                            if (Fields) Fields->Fail(Field, *CurvePoint, ParseErrorCode::MissingField);
+                            return;
+                        }
+                        if (Fields)
+                            Points.emplace_back(Fields->Parse<std::int32_t>(SplitPoint[0], Field),
+                                                Fields->Parse<std::int32_t>(SplitPoint[1], Field));
+                        else Points.emplace_back(Utilities::ToInt(SplitPoint[0]), Utilities::ToInt(SplitPoint[1]));
                     }
                 }
 
+                // "B|x:y|x:y"
+                void Write(TextWriter& Writer) const
+                {
+                    Writer << static_cast<char>(type);
+                    for (const Point& CurvePoint : Points) Writer << '|' << CurvePoint.x << ':' << CurvePoint.y;
+                }
+
                 Curve() = default;
-                explicit Curve(const std::string& CurveString) { Import(CurveString); }
+                explicit Curve(const std::string_view CurveString) { Import(CurveString); }
             };
 
             std::int32_t Slides = 1; // aka Repeats
@@ -192,6 +235,7 @@ namespace OsuParser::Beatmap::Objects::HitObject
             Curve Curve;
             std::vector<Additions> edgeSounds;
             std::vector<SliderSample> edgeSets;
+            bool HasEdgeSounds = true; // whether the line had edgeSounds and edgeSets (they are filled in when not)
         };
 
         Point Pos {0, 0};
@@ -201,41 +245,91 @@ namespace OsuParser::Beatmap::Objects::HitObject
         std::optional<SliderParams> SliderParameters = std::nullopt;
         std::optional<double> EndTime = std::nullopt; // Bonus
         HitSample Hitsample;
+        bool HasHitSample = true; // whether the line had a hitSample; files before v10 leave it out
+
+        // The .osu line of the object, without the line ending
+        void Write(TextWriter& Writer) const
+        {
+            Writer << Pos.x << ',' << Pos.y << ',' << Time << ',' << type.ToInt() << ',' << Hitsound.ToInt();
+            const auto End = static_cast<std::int32_t>(EndTime.value_or(Time));
+            if (type.HoldNote)
+            {
+                Writer << ',' << End;
+                if (!HasHitSample) return;
+                Writer << ':';
+                Hitsample.Write(Writer);
+                return;
+            }
+            if (type.Slider && SliderParameters)
+            {
+                Writer << ',';
+                SliderParameters->Curve.Write(Writer);
+                Writer << ',' << SliderParameters->Slides << ',' << SliderParameters->Length;
+                if (!SliderParameters->HasEdgeSounds) return;
+                Writer << ',';
+                for (std::size_t i = 0; i < SliderParameters->edgeSounds.size(); i++)
+                    Writer << (i ? "|" : "") << SliderParameters->edgeSounds[i].ToInt();
+                Writer << ',';
+                for (std::size_t i = 0; i < SliderParameters->edgeSets.size(); i++)
+                {
+                    if (i) Writer << '|';
+                    SliderParameters->edgeSets[i].Write(Writer);
+                }
+            }
+            else if (type.Spinner) Writer << ',' << End;
+            if (!HasHitSample) return;
+            Writer << ',';
+            Hitsample.Write(Writer);
+        }
     };
     struct HitObjects
     {
         std::vector<HitObject> data;
-        void Parse(const std::vector<std::string>& lines, const bool sort = true)
+        /**
+         *  Appends the objects of lines and returns how many were taken. A line with a bad field is left out and
+         *  reported to Log; in Strict mode parsing stops there and the error is returned.
+         */
+        Expected<std::size_t> Parse(const Lines& lines, const bool sort = true, ParseLog* Log = nullptr)
         {
-            for (const std::string& ObjectString : lines)
+            data.reserve(data.size() + lines.size());
+            const std::size_t First = data.size();
+            FieldReader Fields(lines, "HitObjects");
+            std::optional<ParseError> Stopped;
+            for (const std::string_view ObjectString : lines)
             {
                 HitObject Object;
-                const auto SplitObject = Utilities::Split(ObjectString, ',');
-                Object.Pos = {std::stoi(SplitObject[0]), std::stoi(SplitObject[1])};
-                Object.Time = std::stoi(SplitObject[2]);
-                Object.type = HitObject::Type(std::stoi(SplitObject[3]));
-                Object.Hitsound = Additions(std::stoi(SplitObject[4]));
+                Fields.Read(ObjectString);
+                Object.Pos = {Fields.Get<std::int32_t>(0), Fields.Get<std::int32_t>(1)};
+                Object.Time = Fields.Get<std::int32_t>(2);
+                Object.type = HitObject::Type(Fields.Get<std::int32_t>(3));
+                Object.Hitsound = Additions(Fields.Get<std::int32_t>(4));
 
                 // Parsing objectParams
                 if (Object.type.Slider)
                 {
                     Object.SliderParameters.emplace();
 
-                    Object.SliderParameters->Curve.Import(SplitObject[5]);
-                    Object.SliderParameters->Slides = std::stoi(SplitObject[6]);
-                    Object.SliderParameters->Length = std::stod(SplitObject[7]);
-                    if (SplitObject.size() >= 10)
+                    Object.SliderParameters->Curve.Import(Fields[5], &Fields, 5);
+                    Object.SliderParameters->Slides = Fields.Get<std::int32_t>(6);
+                    Object.SliderParameters->Length = Fields.Get<double>(7);
+                    Object.SliderParameters->HasEdgeSounds = Fields.size() >= 10;
+                    if (Fields.size() >= 10)
                     {
-                        const auto EdgeSoundsStr = Utilities::Split(SplitObject[8], '|');
-                        const auto EdgeSetsStr = Utilities::Split(SplitObject[9], '|');
+                        const auto EdgeSoundsStr = lines.Split(Fields[8], '|');
+                        const auto EdgeSetsStr = lines.Split(Fields[9], '|');
 
                         for (size_t i = 0; i < EdgeSoundsStr.size(); i++)
                         {
-                            Object.SliderParameters->edgeSounds.emplace_back(std::stoi(EdgeSoundsStr[i]));
-                            Object.SliderParameters->edgeSets.emplace_back(EdgeSetsStr[i]);
+                            Object.SliderParameters->edgeSounds.emplace_back(
+                                Fields.Parse<std::int32_t>(EdgeSoundsStr[i], 8));
+                            Object.SliderParameters->edgeSets.emplace_back();
+                            if (i < EdgeSetsStr.size())
+                                Object.SliderParameters->edgeSets.back().Import(EdgeSetsStr[i], &Fields, 9);
                         }
                     }
-                    while (Object.SliderParameters->edgeSounds.size() <= Object.SliderParameters->Slides)
+                    // a negative count cannot be trusted to end the loop below
+                    if (Object.SliderParameters->Slides < 0) Fields.Fail(6, Fields[6], ParseErrorCode::OutOfRange);
+                    while (!Fields.Failed() && Object.SliderParameters->edgeSounds.size() <= static_cast<std::size_t>(Object.SliderParameters->Slides))
                     {
                         Object.SliderParameters->edgeSounds.emplace_back(Object.Hitsound);
                         Object.SliderParameters->edgeSets.emplace_back(Object.Hitsample);
@@ -243,81 +337,72 @@ namespace OsuParser::Beatmap::Objects::HitObject
                 }
                 else if (Object.type.Spinner)
                 {
-                    Object.EndTime = std::stoi(SplitObject[5]);
+                    Object.EndTime = Fields.Get<std::int32_t>(5);
                 }
 
                 // Parsing Hitsample
                 if (Object.type.HoldNote)
                 {
-                    auto list = Utilities::Split(SplitObject[5], ':', true);
-                    Object.EndTime = std::stoi(list.front());
-                    Object.Hitsample.Import(list.back());
+                    auto list = Utilities::Split(Fields[5], ':', true);
+                    Object.EndTime = Fields.Parse<std::int32_t>(list.front(), 5);
+                    Object.Hitsample.Import(list.back(), &Fields, 5);
+                    Object.HasHitSample = Fields[5].find(':') != std::string_view::npos;
                 }
                 else {
-                    if (Object.type.Slider && SplitObject.size() >= 11)
-                        Object.Hitsample.Import(SplitObject[10]);
-                    else if (Object.type.Spinner && SplitObject.size() >= 7)
-                        Object.Hitsample.Import(SplitObject[6]);
-                    else if (Object.type.HitCircle && SplitObject.size() >= 6)
-                        Object.Hitsample.Import(SplitObject[5]);
+                    const std::size_t HitSampleField = Object.type.Slider ? 10 : Object.type.Spinner ? 6 : 5;
+                    Object.HasHitSample = Fields.size() > HitSampleField;
+                    if (Object.HasHitSample) Object.Hitsample.Import(Fields[HitSampleField], &Fields, HitSampleField);
                 }
 
-                data.push_back(Object);
+                if (Fields.Failed())
+                {
+                    if (ParseLog::Skip(Log, Fields.GetError())) continue;
+                    Stopped = Fields.GetError();
+                    break;
+                }
+                data.push_back(std::move(Object));
             }
 
-            if (sort) std::ranges::sort(data, [](const HitObject& A, const HitObject& B) { return A.Time < B.Time; });
+            if (sort)
+                std::ranges::stable_sort(data, [](const HitObject& A, const HitObject& B) { return A.Time < B.Time; });
+            if (Stopped) return Unexpected{std::move(*Stopped)};
+            return data.size() - First;
         }
-        void Parse(
+        Expected<std::size_t> Parse(
             // hit object will have endTime
-            const std::vector<std::string>& lines,
+            const Lines& lines,
             const double& SliderMultiplier,
-            const TimingPoint::TimingPoints& sorted_timing_points)
+            const TimingPoint::TimingPoints& sorted_timing_points,
+            ParseLog* Log = nullptr)
         {
-            Parse(lines, true);
-
-            // Get Timing Point
-            std::vector<TimingPoint::TimingPoint> UninheritedTimingPoints = {};
-            std::vector<TimingPoint::TimingPoint> InheritedTimingPoints = {};
-            for (const auto& TimingPoint : sorted_timing_points.data)
-            {
-                if (TimingPoint.Uninherited)
-                    UninheritedTimingPoints.push_back(TimingPoint);
-                else InheritedTimingPoints.push_back(TimingPoint);
-            }
+            auto Parsed = Parse(lines, true, Log);
+            OSU_PARSER_PHASE(Instrumentation::Phase::SliderEndTimes);
 
+            // objects are sorted now, so one cursor walks the timeline alongside them
+            const TimingPoint::Timeline Timeline(sorted_timing_points);
+            TimingPoint::Timeline::Cursor Cursor = Timeline.GetCursor();
             for (auto& HitObject : data)
             {
-                if (!HitObject.type.HoldNote)
+                if (HitObject.type.HoldNote) continue;
+                if (HitObject.type.HitCircle) HitObject.EndTime = HitObject.Time;
+                else if (HitObject.type.Slider && HitObject.SliderParameters && Timeline.HasUninherited())
                 {
-                    if (HitObject.type.HitCircle)
-                    {
-                        HitObject.EndTime = HitObject.Time;
-                    }
-                    else if (HitObject.type.Slider && !UninheritedTimingPoints.empty())
-                    {
-                        TimingPoint::TimingPoint currentTimeAsTimingPoint;
-                        currentTimeAsTimingPoint.Time = HitObject.Time;
-
-                        // Get BeatLength
-                        auto CurrentUninheritedTimingPoint =
-                            std::ranges::lower_bound(UninheritedTimingPoints, currentTimeAsTimingPoint);
-                        if (CurrentUninheritedTimingPoint == UninheritedTimingPoints.end())
-                            CurrentUninheritedTimingPoint = UninheritedTimingPoints.begin();
-                        const double_t BeatLength = CurrentUninheritedTimingPoint->BeatLength;
-
-                        // Get SV
-                        double_t SV;
-                        auto CurrentInheritedTimingPoint =
-                            std::ranges::lower_bound(InheritedTimingPoints, currentTimeAsTimingPoint);
-                        if (CurrentInheritedTimingPoint == InheritedTimingPoints.end()) SV = 1;
-                        else SV = 100.0 / std::abs(CurrentInheritedTimingPoint->BeatLength);
-
-                        HitObject.EndTime =
-                            static_cast<double>(HitObject.Time) + HitObject.SliderParameters->Length
-                            / (SliderMultiplier * 100 * SV) * BeatLength * HitObject.SliderParameters->Slides;
-                    }
+                    const TimingPoint::Timeline::State& State = Cursor.Advance(HitObject.Time);
+                    HitObject.EndTime = static_cast<double>(HitObject.Time) + HitObject.SliderParameters->Length
+                        / State.GetPixelsPerBeat(SliderMultiplier) * State.BeatLength
+                        * HitObject.SliderParameters->Slides;
                 }
             }
+            return Parsed;
+        }
+
+        void Write(TextWriter& Writer) const
+        {
+            for (const HitObject& Object : data)
+            {
+                Object.Write(Writer);
+                Writer.NewLine();
+            }
         }
     };
 } // namespace Parser
@@ -0,0 +1,554 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "HitObject.hpp"
+
+namespace OsuParser::Beatmap::Objects::HitObject
+{
+    class PackedHitObjects;
+
+    /**
+     *  One object of PackedHitObjects, read through accessors. Valid while the container is alive and unchanged;
+     *  Unpack() gives a HitObject that is not tied to it.
+     */
+    class HitObjectView
+    {
+    public:
+        HitObjectView(const PackedHitObjects& Objects, const std::size_t Index) : m_Objects(&Objects), m_Index(Index)
+        {
+        }
+
+        [[nodiscard]] std::int32_t GetTime() const;
+        [[nodiscard]] std::optional<double> GetEndTime() const;
+        [[nodiscard]] Point GetPosition() const;
+        [[nodiscard]] HitObject::Type GetType() const;
+        [[nodiscard]] bool IsCircle() const;
+        [[nodiscard]] bool IsSlider() const;
+        [[nodiscard]] bool IsSpinner() const;
+        [[nodiscard]] bool IsHoldNote() const;
+        [[nodiscard]] bool IsNewCombo() const;
+        [[nodiscard]] Additions GetHitsound() const;
+
+        // hitSample: whether the line had one, and its fields (all 0 and no filename when it did not)
+        [[nodiscard]] bool HasHitSample() const;
+        [[nodiscard]] SampleSet GetNormalSet() const;
+        [[nodiscard]] SampleSet GetAdditionSet() const;
+        [[nodiscard]] std::int32_t GetSampleIndex() const;
+        [[nodiscard]] std::int32_t GetVolume() const;
+        [[nodiscard]] std::string_view GetFilename() const;
+
+        // Slider parameters; 0 or empty for anything that is not a slider
+        [[nodiscard]] HitObject::SliderParams::Curve::Type GetCurveType() const;
+        [[nodiscard]] std::span<const Point> GetCurvePoints() const;
+        [[nodiscard]] std::int32_t GetSlides() const;
+        [[nodiscard]] double GetLength() const;
+        [[nodiscard]] std::size_t GetEdgeCount() const;
+        [[nodiscard]] Additions GetEdgeSound(std::size_t Edge) const;
+        [[nodiscard]] SliderSample GetEdgeSet(std::size_t Edge) const;
+
+        [[nodiscard]] HitObject Unpack() const;
+
+        [[nodiscard]] std::size_t GetIndex() const
+        {
+            return this->m_Index;
+        }
+
+    private:
+        const PackedHitObjects* m_Objects;
+        std::size_t m_Index;
+    };
+
+    /**
+     *  Hit objects in a compact layout, for keeping many maps in memory: a 24 byte record per object (time, end
+     *  time, position, type, hitsound and sample sets), with slider parameters, curve points and hit samples that
+     *  carry an index, volume or filename in side tables referenced from it. A map of circles takes about a ninth of
+     *  what HitObjects does.
+     *
+     *  Pack a parsed map with PackedHitObjects(Map.HitObjects) and clear Map.HitObjects afterwards, or Parse() the
+     *  lines directly. Unpack() gives the HitObjects back unchanged, and Write() writes the same lines.
+     */
+    class PackedHitObjects
+    {
+    public:
+        static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+        // The per-object record
+        struct Record
+        {
+            std::int32_t Time = 0;
+            std::int32_t EndTime = 0; // truncated; exact for sliders in their side table
+            std::int32_t X = 0;
+            std::int32_t Y = 0;
+            std::uint8_t Type = 0; // as written in the file
+            std::uint8_t Hitsound = 0; // SOUND_* and FLAG_* bits
+            SampleSet NormalSet = SampleSet::NO_CUSTOM;
+            SampleSet AdditionSet = SampleSet::NO_CUSTOM;
+            std::uint32_t Extra = NONE; // Sliders entry for sliders, Samples entry for other objects
+        };
+
+        // Hitsound bits of a Record, and of an Edge, above the normal/whistle/finish/clap bits
+        static constexpr std::uint8_t SOUND_NORMAL_IMPLIED = 1 << 4;
+        static constexpr std::uint8_t FLAG_HAS_HIT_SAMPLE = 1 << 5;
+        static constexpr std::uint8_t FLAG_HAS_END_TIME = 1 << 6;
+        static constexpr std::uint8_t FLAG_SLIDER = 1 << 7; // Extra is a Sliders entry
+
+        struct Slider
+        {
+            double Length = 0;
+            double EndTime = 0;
+            std::int32_t Slides = 1;
+            std::uint32_t FirstPoint = 0;
+            std::uint32_t PointCount = 0;
+            std::uint32_t FirstEdge = 0;
+            std::uint32_t EdgeCount = 0;
+            std::uint32_t Sample = NONE; // Samples entry, if the hit sample has one
+            HitObject::SliderParams::Curve::Type CurveType = HitObject::SliderParams::Curve::Type::BEZIER;
+            bool HasEdgeSounds = true;
+        };
+
+        struct Edge
+        {
+            std::uint8_t Sound = 0;
+            SampleSet NormalSet = SampleSet::NO_CUSTOM;
+            SampleSet AdditionSet = SampleSet::NO_CUSTOM;
+        };
+
+        // The hit sample fields past the two sets, only stored when one of them is set
+        struct Sample
+        {
+            std::int32_t Index = 0;
+            std::int32_t Volume = 0;
+            std::uint32_t FilenameOffset = 0; // into the filename pool
+            std::uint32_t FilenameSize = 0;
+        };
+
+        // Dereferences to a view by value, so it is a forward iterator to ranges but only an input iterator to the
+        // older iterator_traits based algorithms, which expect a real reference
+        class Iterator
+        {
+        public:
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = HitObjectView;
+            using difference_type = std::ptrdiff_t;
+            using reference = HitObjectView;
+            using pointer = void;
+
+            Iterator() = default;
+            Iterator(const PackedHitObjects& Objects, const std::size_t Index) : m_Objects(&Objects), m_Index(Index)
+            {
+            }
+
+            HitObjectView operator*() const { return {*this->m_Objects, this->m_Index}; }
+            Iterator& operator++()
+            {
+                ++this->m_Index;
+                return *this;
+            }
+            Iterator operator++(int)
+            {
+                Iterator Previous = *this;
+                ++this->m_Index;
+                return Previous;
+            }
+            bool operator==(const Iterator& Other) const { return this->m_Index == Other.m_Index; }
+
+        private:
+            const PackedHitObjects* m_Objects = nullptr;
+            std::size_t m_Index = 0;
+        };
+
+        PackedHitObjects() = default;
+        explicit PackedHitObjects(const HitObjects& Objects)
+        {
+            this->Append(Objects);
+        }
+
+        /**
+         *  Parses lines the way HitObjects::Parse does and packs the result; only the objects of one call are ever
+         *  held unpacked.
+         */
+        Expected<std::size_t> Parse(const Lines& ObjectLines, const bool Sort = true, ParseLog* Log = nullptr)
+        {
+            HitObjects Parsed;
+            auto Result = Parsed.Parse(ObjectLines, false, Log);
+            this->Append(Parsed);
+            if (Sort) this->Sort();
+            return Result;
+        }
+
+        // With slider end times, see HitObjects::Parse
+        Expected<std::size_t> Parse(const Lines& ObjectLines, const double SliderMultiplier,
+                                    const TimingPoint::TimingPoints& SortedTimingPoints, ParseLog* Log = nullptr)
+        {
+            HitObjects Parsed;
+            auto Result = Parsed.Parse(ObjectLines, SliderMultiplier, SortedTimingPoints, Log);
+            this->Append(Parsed);
+            this->Sort();
+            return Result;
+        }
+
+        void Append(const HitObjects& Objects)
+        {
+            this->m_Records.reserve(this->m_Records.size() + Objects.data.size());
+            for (const HitObject& Object : Objects.data) this->Push(Object);
+        }
+
+        void Push(const HitObject& Object)
+        {
+            Record Packed;
+            Packed.Time = Object.Time;
+            Packed.EndTime = static_cast<std::int32_t>(Object.EndTime.value_or(Object.Time));
+            Packed.X = Object.Pos.x;
+            Packed.Y = Object.Pos.y;
+            Packed.Type = static_cast<std::uint8_t>(Object.type.ToInt());
+            Packed.Hitsound = PackSound(Object.Hitsound) | (Object.HasHitSample ? FLAG_HAS_HIT_SAMPLE : 0)
+                | (Object.EndTime ? FLAG_HAS_END_TIME : 0) | (Object.SliderParameters ? FLAG_SLIDER : 0);
+            Packed.NormalSet = Object.Hitsample.NormalSet;
+            Packed.AdditionSet = Object.Hitsample.AdditionSet;
+
+            const std::uint32_t SampleEntry = this->PushSample(Object.Hitsample);
+            if (Object.SliderParameters)
+            {
+                const HitObject::SliderParams& Parameters = *Object.SliderParameters;
+                Slider Packing;
+                Packing.Length = Parameters.Length;
+                Packing.EndTime = Object.EndTime.value_or(Object.Time);
+                Packing.Slides = Parameters.Slides;
+                Packing.FirstPoint = static_cast<std::uint32_t>(this->m_Points.size());
+                Packing.PointCount = static_cast<std::uint32_t>(Parameters.Curve.Points.size());
+                Packing.FirstEdge = static_cast<std::uint32_t>(this->m_Edges.size());
+                Packing.EdgeCount = static_cast<std::uint32_t>(Parameters.edgeSounds.size());
+                Packing.Sample = SampleEntry;
+                Packing.CurveType = Parameters.Curve.type;
+                Packing.HasEdgeSounds = Parameters.HasEdgeSounds;
+                this->m_Points.insert(this->m_Points.end(), Parameters.Curve.Points.begin(),
+                                      Parameters.Curve.Points.end());
+                for (std::size_t i = 0; i < Parameters.edgeSounds.size(); i++)
+                {
+                    const SliderSample Set = i < Parameters.edgeSets.size() ? Parameters.edgeSets[i] : SliderSample{};
+                    this->m_Edges.push_back({PackSound(Parameters.edgeSounds[i]), Set.NormalSet, Set.AdditionSet});
+                }
+                Packed.Extra = static_cast<std::uint32_t>(this->m_Sliders.size());
+                this->m_Sliders.push_back(Packing);
+            }
+            else Packed.Extra = SampleEntry;
+            this->m_Records.push_back(Packed);
+        }
+
+        // Orders the records by time, keeping the order of objects at the same time
+        void Sort()
+        {
+            std::ranges::stable_sort(this->m_Records, {}, &Record::Time);
+        }
+
+        [[nodiscard]] std::size_t size() const { return this->m_Records.size(); }
+        [[nodiscard]] bool empty() const { return this->m_Records.empty(); }
+        [[nodiscard]] HitObjectView operator[](const std::size_t Index) const { return {*this, Index}; }
+        [[nodiscard]] Iterator begin() const { return {*this, 0}; }
+        [[nodiscard]] Iterator end() const { return {*this, this->m_Records.size()}; }
+
+        // Index of the first object at or after Time, size() if there is none
+        [[nodiscard]] std::size_t LowerBound(const std::int32_t Time) const
+        {
+            return static_cast<std::size_t>(
+                std::ranges::lower_bound(this->m_Records, Time, {}, &Record::Time) - this->m_Records.begin());
+        }
+
+        [[nodiscard]] std::span<const Record> GetRecords() const { return this->m_Records; }
+        [[nodiscard]] const Record& GetRecord(const std::size_t Index) const { return this->m_Records[Index]; }
+
+        // The side table entry of a slider
+        [[nodiscard]] const Slider* GetSlider(const std::size_t Index) const
+        {
+            const Record& Object = this->m_Records[Index];
+            return Object.Hitsound & FLAG_SLIDER ? &this->m_Sliders[Object.Extra] : nullptr;
+        }
+
+        [[nodiscard]] const Sample* GetSample(const std::size_t Index) const
+        {
+            const Record& Object = this->m_Records[Index];
+            if (const Slider* Parameters = this->GetSlider(Index))
+                return Parameters->Sample != NONE ? &this->m_Samples[Parameters->Sample] : nullptr;
+            return Object.Extra != NONE ? &this->m_Samples[Object.Extra] : nullptr;
+        }
+
+        [[nodiscard]] std::span<const Point> GetPoints(const Slider& Parameters) const
+        {
+            return std::span(this->m_Points).subspan(Parameters.FirstPoint, Parameters.PointCount);
+        }
+
+        [[nodiscard]] std::span<const Edge> GetEdges(const Slider& Parameters) const
+        {
+            return std::span(this->m_Edges).subspan(Parameters.FirstEdge, Parameters.EdgeCount);
+        }
+
+        [[nodiscard]] std::string_view GetFilename(const Sample& Entry) const
+        {
+            return std::string_view(this->m_Filenames).substr(Entry.FilenameOffset, Entry.FilenameSize);
+        }
+
+        [[nodiscard]] HitObjects Unpack() const
+        {
+            HitObjects Objects;
+            Objects.data.reserve(this->m_Records.size());
+            for (std::size_t i = 0; i < this->m_Records.size(); i++) Objects.data.push_back((*this)[i].Unpack());
+            return Objects;
+        }
+
+        // The same lines HitObjects::Write writes for the unpacked objects
+        void Write(TextWriter& Writer) const
+        {
+            for (std::size_t i = 0; i < this->m_Records.size(); i++)
+            {
+                (*this)[i].Unpack().Write(Writer);
+                Writer.NewLine();
+            }
+        }
+
+        // Bytes held by the records and side tables, capacity included
+        [[nodiscard]] std::size_t GetMemoryUsage() const
+        {
+            return this->m_Records.capacity() * sizeof(Record) + this->m_Sliders.capacity() * sizeof(Slider)
+                + this->m_Points.capacity() * sizeof(Point) + this->m_Edges.capacity() * sizeof(Edge)
+                + this->m_Samples.capacity() * sizeof(Sample) + this->m_Filenames.capacity();
+        }
+
+        void ShrinkToFit()
+        {
+            this->m_Records.shrink_to_fit();
+            this->m_Sliders.shrink_to_fit();
+            this->m_Points.shrink_to_fit();
+            this->m_Edges.shrink_to_fit();
+            this->m_Samples.shrink_to_fit();
+            this->m_Filenames.shrink_to_fit();
+        }
+
+        void Clear()
+        {
+            *this = {};
+        }
+
+        static std::uint8_t PackSound(const Additions& Sound)
+        {
+            return static_cast<std::uint8_t>((Sound.Normal ? 1 : 0) | (Sound.Whistle ? 2 : 0) | (Sound.Finish ? 4 : 0)
+                                             | (Sound.Clap ? 8 : 0))
+                | (Sound.NormalImplied ? SOUND_NORMAL_IMPLIED : 0);
+        }
+
+        static Additions UnpackSound(const std::uint8_t Bits)
+        {
+            Additions Sound;
+            Sound.Normal = Bits & 1;
+            Sound.Whistle = Bits & 2;
+            Sound.Finish = Bits & 4;
+            Sound.Clap = Bits & 8;
+            Sound.NormalImplied = Bits & SOUND_NORMAL_IMPLIED;
+            return Sound;
+        }
+
+    private:
+        std::uint32_t PushSample(const HitSample& Hitsample)
+        {
+            if (!Hitsample.Index && !Hitsample.Volume && Hitsample.Filename.empty()) return NONE;
+            Sample Entry;
+            Entry.Index = Hitsample.Index;
+            Entry.Volume = Hitsample.Volume;
+            Entry.FilenameOffset = static_cast<std::uint32_t>(this->m_Filenames.size());
+            Entry.FilenameSize = static_cast<std::uint32_t>(Hitsample.Filename.size());
+            this->m_Filenames += Hitsample.Filename;
+            this->m_Samples.push_back(Entry);
+            return static_cast<std::uint32_t>(this->m_Samples.size() - 1);
+        }
+
+        std::vector<Record> m_Records;
+        std::vector<Slider> m_Sliders;
+        std::vector<Point> m_Points;
+        std::vector<Edge> m_Edges;
+        std::vector<Sample> m_Samples;
+        std::string m_Filenames;
+    };
+
+    static_assert(std::forward_iterator<PackedHitObjects::Iterator>);
+    static_assert(std::ranges::forward_range<PackedHitObjects>);
+
+    inline std::int32_t HitObjectView::GetTime() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Time;
+    }
+
+    inline std::optional<double> HitObjectView::GetEndTime() const
+    {
+        const PackedHitObjects::Record& Object = this->m_Objects->GetRecord(this->m_Index);
+        if (!(Object.Hitsound & PackedHitObjects::FLAG_HAS_END_TIME)) return std::nullopt;
+        if (const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index))
+            return Parameters->EndTime;
+        return Object.EndTime;
+    }
+
+    inline Point HitObjectView::GetPosition() const
+    {
+        const PackedHitObjects::Record& Object = this->m_Objects->GetRecord(this->m_Index);
+        return {Object.X, Object.Y};
+    }
+
+    inline HitObject::Type HitObjectView::GetType() const
+    {
+        return HitObject::Type(this->m_Objects->GetRecord(this->m_Index).Type);
+    }
+
+    inline bool HitObjectView::IsCircle() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Type & 1;
+    }
+
+    inline bool HitObjectView::IsSlider() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Type & 2;
+    }
+
+    inline bool HitObjectView::IsSpinner() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Type & 8;
+    }
+
+    inline bool HitObjectView::IsHoldNote() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Type & 128;
+    }
+
+    inline bool HitObjectView::IsNewCombo() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Type & 4;
+    }
+
+    inline Additions HitObjectView::GetHitsound() const
+    {
+        return PackedHitObjects::UnpackSound(this->m_Objects->GetRecord(this->m_Index).Hitsound);
+    }
+
+    inline bool HitObjectView::HasHitSample() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).Hitsound & PackedHitObjects::FLAG_HAS_HIT_SAMPLE;
+    }
+
+    inline SampleSet HitObjectView::GetNormalSet() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).NormalSet;
+    }
+
+    inline SampleSet HitObjectView::GetAdditionSet() const
+    {
+        return this->m_Objects->GetRecord(this->m_Index).AdditionSet;
+    }
+
+    inline std::int32_t HitObjectView::GetSampleIndex() const
+    {
+        const PackedHitObjects::Sample* Entry = this->m_Objects->GetSample(this->m_Index);
+        return Entry ? Entry->Index : 0;
+    }
+
+    inline std::int32_t HitObjectView::GetVolume() const
+    {
+        const PackedHitObjects::Sample* Entry = this->m_Objects->GetSample(this->m_Index);
+        return Entry ? Entry->Volume : 0;
+    }
+
+    inline std::string_view HitObjectView::GetFilename() const
+    {
+        const PackedHitObjects::Sample* Entry = this->m_Objects->GetSample(this->m_Index);
+        return Entry ? this->m_Objects->GetFilename(*Entry) : std::string_view{};
+    }
+
+    inline HitObject::SliderParams::Curve::Type HitObjectView::GetCurveType() const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return Parameters ? Parameters->CurveType : HitObject::SliderParams::Curve::Type::BEZIER;
+    }
+
+    inline std::span<const Point> HitObjectView::GetCurvePoints() const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return Parameters ? this->m_Objects->GetPoints(*Parameters) : std::span<const Point>{};
+    }
+
+    inline std::int32_t HitObjectView::GetSlides() const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return Parameters ? Parameters->Slides : 0;
+    }
+
+    inline double HitObjectView::GetLength() const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return Parameters ? Parameters->Length : 0;
+    }
+
+    inline std::size_t HitObjectView::GetEdgeCount() const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return Parameters ? Parameters->EdgeCount : 0;
+    }
+
+    inline Additions HitObjectView::GetEdgeSound(const std::size_t Edge) const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        return PackedHitObjects::UnpackSound(this->m_Objects->GetEdges(*Parameters)[Edge].Sound);
+    }
+
+    inline SliderSample HitObjectView::GetEdgeSet(const std::size_t Edge) const
+    {
+        const PackedHitObjects::Slider* Parameters = this->m_Objects->GetSlider(this->m_Index);
+        const PackedHitObjects::Edge& Packed = this->m_Objects->GetEdges(*Parameters)[Edge];
+        SliderSample Set;
+        Set.NormalSet = Packed.NormalSet;
+        Set.AdditionSet = Packed.AdditionSet;
+        return Set;
+    }
+
+    inline HitObject HitObjectView::Unpack() const
+    {
+        const PackedHitObjects::Record& Packed = this->m_Objects->GetRecord(this->m_Index);
+        HitObject Object;
+        Object.Pos = {Packed.X, Packed.Y};
+        Object.Time = Packed.Time;
+        Object.type = HitObject::Type(Packed.Type);
+        Object.Hitsound = PackedHitObjects::UnpackSound(Packed.Hitsound);
+        Object.EndTime = this->GetEndTime();
+        Object.HasHitSample = Packed.Hitsound & PackedHitObjects::FLAG_HAS_HIT_SAMPLE;
+        Object.Hitsample.NormalSet = Packed.NormalSet;
+        Object.Hitsample.AdditionSet = Packed.AdditionSet;
+        if (const PackedHitObjects::Sample* Entry = this->m_Objects->GetSample(this->m_Index))
+        {
+            Object.Hitsample.Index = Entry->Index;
+            Object.Hitsample.Volume = Entry->Volume;
+            Object.Hitsample.Filename = this->m_Objects->GetFilename(*Entry);
+        }
+        if (const PackedHitObjects::Slider* Packing = this->m_Objects->GetSlider(this->m_Index))
+        {
+            HitObject::SliderParams& Parameters = Object.SliderParameters.emplace();
+            Parameters.Slides = Packing->Slides;
+            Parameters.Length = Packing->Length;
+            Parameters.Curve.type = Packing->CurveType;
+            const std::span<const Point> Points = this->m_Objects->GetPoints(*Packing);
+            Parameters.Curve.Points.assign(Points.begin(), Points.end());
+            Parameters.HasEdgeSounds = Packing->HasEdgeSounds;
+            Parameters.edgeSounds.reserve(Packing->EdgeCount);
+            Parameters.edgeSets.reserve(Packing->EdgeCount);
+            for (std::size_t i = 0; i < Packing->EdgeCount; i++)
+            {
+                Parameters.edgeSounds.push_back(this->GetEdgeSound(i));
+                Parameters.edgeSets.push_back(this->GetEdgeSet(i));
+            }
+        }
+        return Object;
+    }
+}
@@ -1,7 +1,13 @@
 #pragma once
 #include <algorithm>
 #include <bitset>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include <osu!parser/Parser/Utilities.hpp>
+#include <osu!parser/Parser/Reader/Tokenizer.hpp>
+#include <osu!parser/Parser/Reader/FieldReader.hpp>
+#include <osu!parser/Parser/Writer/TextWriter.hpp>
 
 namespace OsuParser::Beatmap::Objects::TimingPoint
 {
@@ -44,12 +50,19 @@ namespace OsuParser::Beatmap::Objects::TimingPoint
         std::int32_t Time{};
         std::double_t BeatLength{};
         std::int32_t Meter{};
-        SampleSet SampleSet{};
+        Objects::TimingPoint::SampleSet SampleSet{};
         std::int32_t SampleIndex{};
         std::int32_t Volume{};
         bool Uninherited{};
         Effect Effects{};
 
+        // "time,beatLength,meter,sampleSet,sampleIndex,volume,uninherited,effects", without the line ending
+        void Write(TextWriter& Writer) const
+        {
+            Writer << Time << ',' << BeatLength << ',' << Meter << ',' << static_cast<std::int32_t>(SampleSet) << ','
+                << SampleIndex << ',' << Volume << ',' << Uninherited << ',' << Effects.to_int();
+        }
+
         bool operator<(const TimingPoint& other) const { return Time < other.Time; }
         bool operator>(const TimingPoint& other) const { return Time > other.Time; }
         bool operator==(const TimingPoint& other) const { return Time == other.Time; }
@@ -61,23 +74,198 @@ namespace OsuParser::Beatmap::Objects::TimingPoint
     struct TimingPoints
     {
         std::vector<TimingPoint> data{};
-        void Parse(const std::vector<std::string>& lines, const bool sort = true)
+        /**
+         *  Appends the points of lines and returns how many were taken. A line with a bad field is left out and
+         *  reported to Log; in Strict mode parsing stops there and the error is returned.
+         */
+        Expected<std::size_t> Parse(const Lines& lines, const bool sort = true, ParseLog* Log = nullptr)
         {
-            for (const auto& line : lines)
+            data.reserve(data.size() + lines.size());
+            const std::size_t first = data.size();
+            FieldReader fields(lines, "TimingPoints");
+            for (const std::string_view line : lines)
             {
                 TimingPoint point;
-                const auto split = Utilities::Split(line, ',');
-                point.Time = std::stoi(split[0]);
-                point.BeatLength = std::stod(split[1]);
-                point.Meter = std::stoi(split[2]);
-                point.SampleSet = static_cast<SampleSet>(std::stoi(split[3]));
-                point.SampleIndex = std::stoi(split[4]);
-                point.Volume = std::stoi(split[5]);
-                point.Uninherited = (std::stoi(split[6]) == 1);
-                if (split.size() >= 8) point.Effects.Import(std::stoi(split[7]));
+                fields.Read(line);
+                point.Time = fields.Get<std::int32_t>(0);
+                point.BeatLength = fields.Get<double>(1);
+                // files older than v6 stop after the beat length
+                point.Meter = fields.Get<std::int32_t>(2, 4);
+                point.SampleSet = static_cast<SampleSet>(fields.Get<std::int32_t>(3, 0));
+                point.SampleIndex = fields.Get<std::int32_t>(4, 0);
+                point.Volume = fields.Get<std::int32_t>(5, 100);
+                point.Uninherited = (fields.Get<std::int32_t>(6, 1) == 1);
+                point.Effects.Import(fields.Get<std::int32_t>(7, 0));
+                if (fields.Failed())
+                {
+                    if (ParseLog::Skip(Log, fields.GetError())) continue;
+                    if (sort) std::ranges::stable_sort(data);
+                    return Unexpected{fields.GetError()};
+                }
                 data.push_back(std::move(point));
             }
-            if (sort) std::ranges::sort(data);
+            // stable: an uninherited and an inherited point often share a time, and keep their order
+            if (sort) std::ranges::stable_sort(data);
+            return data.size() - first;
+        }
+
+        void Write(TextWriter& Writer) const
+        {
+            for (const TimingPoint& point : data)
+            {
+                point.Write(Writer);
+                Writer.NewLine();
+            }
         }
     };
+
+    /**
+     *  What the timing points say at any time: beat length and meter from the last uninherited point, slider
+     *  velocity from the last inherited one (reset to 1 by an uninherited point), sample set, volume and kiai from
+     *  the last point of either kind. Before the first point the first uninherited beat length and the first
+     *  point's samples apply, as in osu!.
+     *
+     *  Every point is resolved once on construction, so At() is a binary search and a Cursor walking forward
+     *  through sorted times costs O(1) per step.
+     */
+    class Timeline
+    {
+    public:
+        struct State
+        {
+            std::int32_t Time = std::numeric_limits<std::int32_t>::min(); // of the point this state starts at
+            std::double_t BeatLength = 0; // 0 when there is no uninherited point at all
+            std::double_t SliderVelocity = 1; // multiplier, 0.1 to 10
+            std::int32_t Meter = 4;
+            Objects::TimingPoint::SampleSet SampleSet = SampleSet::NO_CUSTOM;
+            std::int32_t SampleIndex = 0;
+            std::int32_t Volume = 100;
+            bool Kiai = false;
+
+            // Slider velocity in osu! pixels per beat, for the difficulty's SliderMultiplier
+            [[nodiscard]] std::double_t GetPixelsPerBeat(const std::double_t SliderMultiplier) const
+            {
+                return SliderMultiplier * 100 * SliderVelocity;
+            }
+        };
+
+        // Walks forward through the timeline; times given to Advance() should not decrease
+        class Cursor
+        {
+        public:
+            explicit Cursor(const Timeline& Owner) : m_Owner(&Owner) {}
+
+            const State& Advance(const std::int32_t Time)
+            {
+                const std::vector<State>& States = this->m_Owner->m_States;
+                // going back is allowed, it just costs a search
+                if (this->m_Index > 0 && Time < States[this->m_Index].Time)
+                    this->m_Index = this->m_Owner->Find(Time);
+                while (this->m_Index + 1 < States.size() && States[this->m_Index + 1].Time <= Time) ++this->m_Index;
+                return States[this->m_Index];
+            }
+
+        private:
+            const Timeline* m_Owner;
+            std::size_t m_Index = 0;
+        };
+
+        Timeline() : m_States(1) {}
+
+        // Points must be sorted by time, as TimingPoints::Parse leaves them
+        explicit Timeline(const TimingPoints& Points)
+        {
+            const auto FirstUninherited = std::ranges::find_if(Points.data, &TimingPoint::Uninherited);
+            this->m_HasUninherited = FirstUninherited != Points.data.end();
+
+            // the state before the first point
+            State Current;
+            if (this->m_HasUninherited)
+            {
+                Current.BeatLength = FirstUninherited->BeatLength;
+                Current.Meter = FirstUninherited->Meter;
+            }
+            if (!Points.data.empty())
+            {
+                Current.SampleSet = Points.data.front().SampleSet;
+                Current.SampleIndex = Points.data.front().SampleIndex;
+                Current.Volume = Points.data.front().Volume;
+            }
+            this->m_States.reserve(Points.data.size() + 1);
+            this->m_States.push_back(Current);
+
+            bool InheritedAtTime = false; // whether a point at Current.Time set the slider velocity
+            for (const TimingPoint& Point : Points.data)
+            {
+                const bool SameTime = this->m_States.size() > 1 && this->m_States.back().Time == Point.Time;
+                if (!SameTime) InheritedAtTime = false;
+                Current.Time = Point.Time;
+                if (Point.Uninherited)
+                {
+                    Current.BeatLength = Point.BeatLength;
+                    Current.Meter = Point.Meter;
+                    // an inherited point at the same time keeps its velocity, whichever line comes first
+                    if (!InheritedAtTime) Current.SliderVelocity = 1;
+                }
+                else
+                {
+                    Current.SliderVelocity = GetSliderVelocity(Point.BeatLength);
+                    InheritedAtTime = true;
+                }
+                Current.SampleSet = Point.SampleSet;
+                Current.SampleIndex = Point.SampleIndex;
+                Current.Volume = Point.Volume;
+                Current.Kiai = Point.Effects.kiai;
+
+                // otherwise a later point at the same time wins
+                if (SameTime) this->m_States.back() = Current;
+                else this->m_States.push_back(Current);
+            }
+        }
+
+        // What applies at Time
+        [[nodiscard]] const State& At(const std::int32_t Time) const
+        {
+            return this->m_States[this->Find(Time)];
+        }
+
+        [[nodiscard]] Cursor GetCursor() const
+        {
+            return Cursor(*this);
+        }
+
+        // Whether any point sets a beat length; without one, beat lengths are 0
+        [[nodiscard]] bool HasUninherited() const
+        {
+            return this->m_HasUninherited;
+        }
+
+        // One state per distinct point time, after the one before the first point
+        [[nodiscard]] const std::vector<State>& GetStates() const
+        {
+            return this->m_States;
+        }
+
+        // The multiplier an inherited point's negative beat length stands for
+        static std::double_t GetSliderVelocity(const std::double_t BeatLength)
+        {
+            if (!(BeatLength < 0)) return 1;
+            return std::clamp(100.0 / -BeatLength, 0.1, 10.0);
+        }
+
+    private:
+        [[nodiscard]] std::size_t Find(const std::int32_t Time) const
+        {
+            // the last state starting at or before Time; the first one covers everything before
+            const auto After = std::upper_bound(this->m_States.begin() + 1, this->m_States.end(), Time,
+                                                [](const std::int32_t Value, const State& Point)
+                                                {
+                                                    return Value < Point.Time;
+                                                });
+            return static_cast<std::size_t>(After - this->m_States.begin()) - 1;
+        }
+
+        std::vector<State> m_States;
+        bool m_HasUninherited = false;
+    };
 }
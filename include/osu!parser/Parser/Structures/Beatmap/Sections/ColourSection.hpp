@@ -9,46 +9,102 @@ namespace OsuParser::Beatmap::Sections::Colour
 {
 	struct Colour
 	{
-		int32_t r;
-		int32_t g;
-		int32_t b;
+		int32_t r = 0;
+		int32_t g = 0;
+		int32_t b = 0;
 
+		Colour(const int32_t r, const int32_t g, const int32_t b) : r(r), g(g), b(b)
+		{
+		}
+
+		// Components that are missing or not numbers read as 0
 		Colour(const std::string& value)
 		{
-			const auto vtr = Utilities::Split(Utilities::Trim(value), ',');
-			this->r = std::stoi(vtr[0]);
-			this->g = std::stoi(vtr[1]);
-			this->b = std::stoi(vtr[2]);
+			const auto vtr = Utilities::Split(Utilities::Trim(std::string_view(value)), ',');
+			if (vtr.size() > 0) this->r = Utilities::ToInt(vtr[0]);
+			if (vtr.size() > 1) this->g = Utilities::ToInt(vtr[1]);
+			if (vtr.size() > 2) this->b = Utilities::ToInt(vtr[2]);
 		}
 	};
 
 	class ColourSection final : public Section
 	{
-		std::optional<Colour> GetColour(const std::string& name)
+		// A key that reads "r,g,b" into Member; a bad or missing component leaves it empty and is reported
+		template <std::optional<Colour> ColourSection::*Member>
+		static constexpr Key<ColourSection> BindColour(const std::string_view name)
+		{
+			return {name, [](ColourSection& target, const std::string_view value)
+			{
+				target.*Member = target.ReadColour(value);
+			}, [](const ColourSection& source, TextWriter& writer)
+			{
+				const Colour& colour = *(source.*Member);
+				writer << colour.r << ',' << colour.g << ',' << colour.b;
+			}, [](const ColourSection& source)
+			{
+				return (source.*Member).has_value();
+			}};
+		}
+
+		std::optional<Colour> ReadColour(const std::string_view value)
 		{
-			const auto value = this->GetAttribute(name);
-			if (value.empty()) return std::nullopt;
-			return Colour(value);
+			const auto parts = Utilities::Split(value, ',');
+			int32_t components[3] = {};
+			for (size_t i = 0; i < 3; i++)
+			{
+				if (i >= parts.size())
+				{
+					this->Report({}, ParseErrorCode::MissingField, value.data() + value.size());
+					return std::nullopt;
+				}
+				const auto component = Utilities::ParseNumber<int32_t>(parts[i]);
+				if (!component)
+				{
+					this->Report(parts[i], component.error());
+					return std::nullopt;
+				}
+				components[i] = *component;
+			}
+			return Colour(components[0], components[1], components[2]);
+		}
+
+		static const auto& Keys()
+		{
+			static constexpr KeyTable KEYS(std::array{
+				BindColour<&ColourSection::Combo1>("Combo1"),
+				BindColour<&ColourSection::Combo2>("Combo2"),
+				BindColour<&ColourSection::Combo3>("Combo3"),
+				BindColour<&ColourSection::Combo4>("Combo4"),
+				BindColour<&ColourSection::Combo5>("Combo5"),
+				BindColour<&ColourSection::Combo6>("Combo6"),
+				BindColour<&ColourSection::Combo7>("Combo7"),
+				BindColour<&ColourSection::Combo8>("Combo8"),
+				BindColour<&ColourSection::SliderTrackOverride>("SliderTrackOverride"),
+				BindColour<&ColourSection::SliderBorder>("SliderBorder"),
+			});
+			return KEYS;
 		}
 
 	public:
 		ColourSection() = default;
-		void Parse(std::vector<std::string>& Lines) override
+		Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) override
 		{
-			this->LoadAttributes(Lines);
+			return this->ParseKeys(*this, Keys(), Lines, "Colours", Log);
+		}
 
-			this->Combo1 = GetColour("Combo1");
-			this->Combo2 = GetColour("Combo2");
-			this->Combo3 = GetColour("Combo3");
-			this->Combo4 = GetColour("Combo4");
-			this->Combo5 = GetColour("Combo5");
-			this->Combo6 = GetColour("Combo6");
-			this->Combo7 = GetColour("Combo7");
-			this->Combo8 = GetColour("Combo8");
-			this->SliderTrackOverride = GetColour("SliderTrackOverride");
-			this->SliderBorder = GetColour("SliderBorder");
+		void Write(TextWriter& Writer) const override
+		{
+			this->WriteKeys(*this, Keys(), Writer, " : ");
 		}
 
+		// Whether the map has any colour of its own, which is when osu! writes the section
+		[[nodiscard]] bool HasColours() const
+		{
+			return this->Combo1 || this->Combo2 || this->Combo3 || this->Combo4 || this->Combo5 || this->Combo6
+				|| this->Combo7 || this->Combo8 || this->SliderTrackOverride || this->SliderBorder;
+		}
+
+	public:
 		std::optional<Colour> Combo1 = std::nullopt;
 		std::optional<Colour> Combo2 = std::nullopt;
 		std::optional<Colour> Combo3 = std::nullopt;
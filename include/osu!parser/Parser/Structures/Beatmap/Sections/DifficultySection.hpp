@@ -6,25 +6,29 @@ namespace OsuParser::Beatmap::Sections::Difficulty
 {
     class DifficultySection final : public Section
     {
+        static const auto& Keys()
+        {
+            static constexpr KeyTable KEYS(std::array{
+                Bind<&DifficultySection::HPDrainRate>("HPDrainRate"),
+                Bind<&DifficultySection::CircleSize>("CircleSize"),
+                Bind<&DifficultySection::OverallDifficulty>("OverallDifficulty"),
+                Bind<&DifficultySection::ApproachRate>("ApproachRate"),
+                Bind<&DifficultySection::SliderMultiplier>("SliderMultiplier"),
+                Bind<&DifficultySection::SliderTickRate>("SliderTickRate"),
+            });
+            return KEYS;
+        }
+
     public:
         DifficultySection() = default;
-        void Parse(std::vector<std::string>& Lines) override
+        Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) override
         {
-            this->LoadAttributes(Lines);
-
-            const auto HPDrainRateStr = this->GetAttribute("HPDrainRate");
-            const auto CircleSizeStr = this->GetAttribute("CircleSize");
-            const auto OverallDifficultyStr = this->GetAttribute("OverallDifficulty");
-            const auto ApproachRateStr = this->GetAttribute("ApproachRate");
-            const auto SliderMultiplierStr = this->GetAttribute("SliderMultiplier");
-            const auto SliderTickRateStr = this->GetAttribute("SliderTickRate");
+            return this->ParseKeys(*this, Keys(), Lines, "Difficulty", Log);
+        }
 
-            if (!HPDrainRateStr.empty()) HPDrainRate = std::stod(HPDrainRateStr);
-            if (!CircleSizeStr.empty()) CircleSize = std::stod(CircleSizeStr);
-            if (!OverallDifficultyStr.empty()) OverallDifficulty = std::stod(OverallDifficultyStr);
-            if (!ApproachRateStr.empty()) ApproachRate = std::stod(ApproachRateStr);
-            if (!SliderMultiplierStr.empty()) SliderMultiplier = std::stod(SliderMultiplierStr);
-            if (!SliderTickRateStr.empty()) SliderTickRate = std::stod(SliderTickRateStr);
+        void Write(TextWriter& Writer) const override
+        {
+            this->WriteKeys(*this, Keys(), Writer, ":");
         }
 
         double HPDrainRate = 0;
@@ -7,18 +7,29 @@ namespace OsuParser::Beatmap::Sections::Editor
 {
     class EditorSection final : public Section
     {
+        static const auto& Keys()
+        {
+            static constexpr KeyTable KEYS(std::array{
+                Bind<&EditorSection::DistanceSpacing>("DistanceSpacing"),
+                Bind<&EditorSection::BeatDivisor>("BeatDivisor"),
+                Bind<&EditorSection::GridSize>("GridSize"),
+                Bind<&EditorSection::TimelineZoom>("TimelineZoom"),
+            });
+            return KEYS;
+        }
+
     public:
         EditorSection()
         {
         }
-        void Parse(std::vector<std::string>& Lines) override
+        Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) override
         {
-            this->LoadAttributes(Lines);
+            return this->ParseKeys(*this, Keys(), Lines, "Editor", Log);
+        }
 
-            this->DistanceSpacing = this->GetAttribute("DistanceSpacing");
-            this->BeatDivisor = this->GetAttribute("BeatDivisor");
-            this->GridSize = this->GetAttribute("GridSize");
-            this->TimelineZoom = this->GetAttribute("TimelineZoom");
+        void Write(TextWriter& Writer) const override
+        {
+            this->WriteKeys(*this, Keys(), Writer, ": ");
         }
 
     public:
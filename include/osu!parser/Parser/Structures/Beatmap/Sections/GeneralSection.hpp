@@ -1,6 +1,7 @@
 #pragma once
+#include <cmath>
 #include <vector>
-#include "Structures/Beatmap/Objects/TimingPoint.hpp"
+#include "osu!parser/Parser/Structures/Beatmap/Objects/TimingPoint.hpp"
 #include "Section.hpp"
 
 namespace OsuParser::Beatmap::Sections::General
@@ -32,92 +33,79 @@ namespace OsuParser::Beatmap::Sections::General
 
     class GeneralSection final : public Section
     {
-    public:
-        GeneralSection() = default;
+        static constexpr std::array<std::string_view, 4> SAMPLE_SETS = {"None", "Normal", "Soft", "Drum"};
+        static constexpr std::array<std::string_view, 3> OVERLAY_POSITIONS = {"NoChange", "Below", "Above"};
 
-        void Parse(std::vector<std::string>& Lines) override
+        static const auto& Keys()
         {
-            this->LoadAttributes(Lines);
-            this->AudioFilename = this->GetAttribute("AudioFilename");
-            if (std::string audioLeadInStr = this->GetAttribute("AudioLeadIn"); !audioLeadInStr.empty()) this->AudioLeadIn = std::stoi(audioLeadInStr);
-            if (std::string previewTimeStr = this->GetAttribute("PreviewTime"); !previewTimeStr.empty())
-                this->PreviewTime = std::stoi(previewTimeStr);
-            if (std::string countdownStr = this->GetAttribute("Countdown"); !countdownStr.empty())
-            {
-                switch (std::stoi(countdownStr))
+            static constexpr KeyTable KEYS(std::array{
+                Bind<&GeneralSection::AudioFilename>("AudioFilename"),
+                Bind<&GeneralSection::AudioLeadIn>("AudioLeadIn"),
+                Bind<&GeneralSection::PreviewTime>("PreviewTime"),
+                Key<GeneralSection>{"Countdown", [](GeneralSection& Target, const std::string_view Value)
+                {
+                    if (const auto Countdown = Target.Number<int32_t>(Value); Countdown && *Countdown >= 0 && *Countdown <= 3)
+                        Target.Countdown = static_cast<CountdownType>(*Countdown);
+                }, [](const GeneralSection& Source, TextWriter& Writer)
+                {
+                    Writer << static_cast<int32_t>(Source.Countdown);
+                }},
+                Key<GeneralSection>{"SampleSet", [](GeneralSection& Target, const std::string_view Value)
                 {
-                case 0: this->Countdown = CountdownType::NO_COUNTDOWN;
-                    break;
-                case 1: this->Countdown = CountdownType::NORMAL;
-                    break;
-                case 2: this->Countdown = CountdownType::HALF;
-                    break;
-                case 3: this->Countdown = CountdownType::DOUBLE;
-                    break;
-                default: break;
-                }
-            }
-            if (std::string sampleSetStr = this->GetAttribute("SampleSet"); !sampleSetStr.empty())
-            {
-                if (sampleSetStr == "Normal")
+                    if (Value == "Normal") Target.SampleSet = SampleSet::NORMAL;
+                    else if (Value == "Soft") Target.SampleSet = SampleSet::SOFT;
+                    else if (Value == "Drum") Target.SampleSet = SampleSet::DRUM;
+                }, [](const GeneralSection& Source, TextWriter& Writer)
                 {
-                    this->SampleSet = SampleSet::NORMAL;
-                }
-                else if (sampleSetStr == "Soft")
+                    Writer << SAMPLE_SETS[static_cast<std::size_t>(Source.SampleSet) & 3];
+                }},
+                Bind<&GeneralSection::StackLeniency>("StackLeniency"),
+                Key<GeneralSection>{"Mode", [](GeneralSection& Target, const std::string_view Value)
                 {
-                    this->SampleSet = SampleSet::SOFT;
-                }
-                else if (sampleSetStr == "Drum")
+                    if (const auto Mode = Target.Number<int32_t>(Value); Mode && *Mode >= 0 && *Mode <= 3)
+                        Target.Mode = static_cast<ModeType>(*Mode);
+                }, [](const GeneralSection& Source, TextWriter& Writer)
                 {
-                    this->SampleSet = SampleSet::DRUM;
-                }
-            }
-            if (std::string stackLeniencyStr = this->GetAttribute("StackLeniency"); !stackLeniencyStr.empty())
-                this->StackLeniency = std::stod(stackLeniencyStr);
-            if (std::string modeStr = this->GetAttribute("Mode"); !modeStr.empty())
-            {
-                switch (std::stoi(modeStr))
+                    Writer << static_cast<int32_t>(Source.Mode);
+                }},
+                Bind<&GeneralSection::LetterboxInBreaks>("LetterboxInBreaks"),
+                Bind<&GeneralSection::UseSkinSprites>("UseSkinSprites"),
+                // osu! writes the name, older files have the number
+                Key<GeneralSection>{"OverlayPosition", [](GeneralSection& Target, const std::string_view Value)
                 {
-                case 0: this->Mode = ModeType::OSU_STANDARD;
-                    break;
-                case 1: this->Mode = ModeType::OSU_TAIKO;
-                    break;
-                case 2: this->Mode = ModeType::OSU_CATCH;
-                    break;
-                case 3: this->Mode = ModeType::OSU_MANIA;
-                    break;
-                default: break;
-                }
-            }
-            std::string letterboxInBreaksStr = this->GetAttribute("LetterboxInBreaks");
-            this->LetterboxInBreaks = (!letterboxInBreaksStr.empty() && std::stoi(letterboxInBreaksStr) != 0);
-            std::string useSkinSpritesStr = this->GetAttribute("UseSkinSprites");
-            this->UseSkinSprites = (!useSkinSpritesStr.empty() && std::stoi(useSkinSpritesStr) != 0);
-            if (std::string overlayPosStr = this->GetAttribute("OverlayPosition"); !overlayPosStr.empty())
-            {
-                switch (std::stoi(overlayPosStr))
+                    for (std::size_t Position = 0; Position < OVERLAY_POSITIONS.size(); Position++)
+                    {
+                        if (Value != OVERLAY_POSITIONS[Position]) continue;
+                        Target.OverlayPosition = static_cast<OverlayPositionType>(Position);
+                        return;
+                    }
+                    if (const auto Position = Target.Number<int32_t>(Value); Position && *Position >= 0 && *Position <= 2)
+                        Target.OverlayPosition = static_cast<OverlayPositionType>(*Position);
+                }, [](const GeneralSection& Source, TextWriter& Writer)
                 {
-                case 0: this->OverlayPosition = OverlayPositionType::NO_CHANGE;
-                    break;
-                case 1: this->OverlayPosition = OverlayPositionType::BELOW;
-                    break;
-                case 2: this->OverlayPosition = OverlayPositionType::ABOVE;
-                    break;
-                default: break;
-                }
-            }
-            this->SkinPreference = this->GetAttribute("SkinPreference");
-            std::string epilepsyWarningStr = this->GetAttribute("EpilepsyWarning");
-            this->EpilepsyWarning = (!epilepsyWarningStr.empty() && std::stoi(epilepsyWarningStr) != 0);
-            if (std::string countdownOffsetStr = this->GetAttribute("CountdownOffset"); !countdownOffsetStr.empty())
-                this->CountdownOffset = std::stoi(countdownOffsetStr);
-            std::string specialStyleStr = this->GetAttribute("SpecialStyle");
-            this->SpecialStyle = (!specialStyleStr.empty() && std::stoi(specialStyleStr) != 0);
-            std::string widescreenStoryboardStr = this->GetAttribute("WidescreenStoryboard");
-            this->WidescreenStoryboard = (!widescreenStoryboardStr.empty() && std::stoi(widescreenStoryboardStr) != 0);
-            std::string samplesMatchPlaybackRateStr = this->GetAttribute("SamplesMatchPlaybackRate");
-            this->SamplesMatchPlaybackRate = (!samplesMatchPlaybackRateStr.empty() && std::stoi(
-                samplesMatchPlaybackRateStr) != 0);
+                    Writer << OVERLAY_POSITIONS[static_cast<std::size_t>(Source.OverlayPosition) % 3];
+                }},
+                Bind<&GeneralSection::SkinPreference>("SkinPreference"),
+                Bind<&GeneralSection::EpilepsyWarning>("EpilepsyWarning"),
+                Bind<&GeneralSection::CountdownOffset>("CountdownOffset"),
+                Bind<&GeneralSection::SpecialStyle>("SpecialStyle"),
+                Bind<&GeneralSection::WidescreenStoryboard>("WidescreenStoryboard"),
+                Bind<&GeneralSection::SamplesMatchPlaybackRate>("SamplesMatchPlaybackRate"),
+            });
+            return KEYS;
+        }
+
+    public:
+        GeneralSection() = default;
+
+        Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) override
+        {
+            return this->ParseKeys(*this, Keys(), Lines, "General", Log);
+        }
+
+        void Write(TextWriter& Writer) const override
+        {
+            this->WriteKeys(*this, Keys(), Writer, ": ");
         }
 
     public:
@@ -125,7 +113,7 @@ namespace OsuParser::Beatmap::Sections::General
         int32_t AudioLeadIn = 0;
         int32_t PreviewTime = -1;
         CountdownType Countdown = CountdownType::NORMAL;
-        SampleSet SampleSet = SampleSet::NORMAL;
+        Objects::TimingPoint::SampleSet SampleSet = SampleSet::NORMAL;
         double_t StackLeniency = 0.7;
         ModeType Mode = ModeType::OSU_STANDARD;
         bool LetterboxInBreaks = false;
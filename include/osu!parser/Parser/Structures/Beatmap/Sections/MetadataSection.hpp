@@ -7,24 +7,45 @@ namespace OsuParser::Beatmap::Sections::Metadata
 {
     class MetadataSection final : public Section
     {
+        static const auto& Keys()
+        {
+            static constexpr KeyTable KEYS(std::array{
+                Bind<&MetadataSection::Title>("Title"),
+                Bind<&MetadataSection::TitleUnicode>("TitleUnicode"),
+                Bind<&MetadataSection::Artist>("Artist"),
+                Bind<&MetadataSection::ArtistUnicode>("ArtistUnicode"),
+                Bind<&MetadataSection::Creator>("Creator"),
+                Bind<&MetadataSection::Version>("Version"),
+                Bind<&MetadataSection::Source>("Source"),
+                Key<MetadataSection>{"Tags", [](MetadataSection& Target, const std::string_view Value)
+                {
+                    Target.Tags = Utilities::Split(std::string(Value), ' ');
+                }, [](const MetadataSection& Source, TextWriter& Writer)
+                {
+                    for (std::size_t Index = 0; Index < Source.Tags.size(); Index++)
+                    {
+                        if (Index) Writer << ' ';
+                        Writer << Source.Tags[Index];
+                    }
+                }},
+                Bind<&MetadataSection::BeatmapID>("BeatmapID"),
+                Bind<&MetadataSection::BeatmapSetID>("BeatmapSetID"),
+            });
+            return KEYS;
+        }
+
     public:
         MetadataSection()
         {
         }
-        void Parse(std::vector<std::string>& Lines) override
+        Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) override
         {
-            this->LoadAttributes(Lines);
+            return this->ParseKeys(*this, Keys(), Lines, "Metadata", Log);
+        }
 
-            this->Title = this->GetAttribute("Title");
-            this->TitleUnicode = this->GetAttribute("TitleUnicode");
-            this->Artist = this->GetAttribute("Artist");
-            this->ArtistUnicode = this->GetAttribute("ArtistUnicode");
-            this->Creator = this->GetAttribute("Creator");
-            this->Version = this->GetAttribute("Version");
-            this->Source = this->GetAttribute("Source");
-            this->BeatmapID = this->GetAttribute("BeatmapID");
-            this->BeatmapSetID = this->GetAttribute("BeatmapSetID");
-            this->Tags = Utilities::Split(this->GetAttribute("Tags"), ' ');
+        void Write(TextWriter& Writer) const override
+        {
+            this->WriteKeys(*this, Keys(), Writer, ":");
         }
 
     public:
@@ -1,48 +1,254 @@
 #pragma once
-#include <map>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <osu!parser/Parser/ParseError.hpp>
 #include <osu!parser/Parser/Utilities.hpp>
+#include <osu!parser/Parser/Reader/Tokenizer.hpp>
+#include <osu!parser/Parser/Writer/TextWriter.hpp>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace OsuParser::Beatmap::Sections
 {
+    // One known key of a section: what to do with its value, and how to write it back
+    template <typename Owner>
+    struct Key
+    {
+        std::string_view Name;
+        void (*Apply)(Owner& Target, std::string_view Value) = nullptr;
+        void (*Write)(const Owner& Source, TextWriter& Writer) = nullptr;
+        bool (*Present)(const Owner& Source) = nullptr; // for keys only written when set; null = always written
+    };
+
+    /**
+     *  Compile-time perfect hash over the keys of a section.
+     *
+     *  The constructor searches for a seed under which every key lands in its own slot, so Find() costs one hash
+     *  of the looked-up name and one string compare. It is consteval: a key set without a seed fails the build.
+     */
+    template <typename Owner, std::size_t N>
+    class KeyTable
+    {
+    public:
+        static constexpr std::size_t SLOTS = std::bit_ceil(N * 4);
+
+        consteval explicit KeyTable(const std::array<Key<Owner>, N>& Keys) : m_Keys(Keys)
+        {
+            for (std::uint32_t Seed = 0; Seed < 100000; Seed++)
+            {
+                this->m_Slots = {};
+                bool Collision = false;
+                for (std::size_t Index = 0; Index < N && !Collision; Index++)
+                {
+                    std::uint8_t& Slot = this->m_Slots[Hash(Keys[Index].Name, Seed) & (SLOTS - 1)];
+                    Collision = Slot != 0;
+                    Slot = static_cast<std::uint8_t>(Index + 1);
+                }
+                if (Collision) continue;
+                this->m_Seed = Seed;
+                return;
+            }
+            throw "no perfect hash seed for this key set";
+        }
+
+        [[nodiscard]] constexpr const Key<Owner>* Find(const std::string_view Name) const
+        {
+            const std::uint8_t Slot = this->m_Slots[Hash(Name, this->m_Seed) & (SLOTS - 1)];
+            if (!Slot || this->m_Keys[Slot - 1].Name != Name) return nullptr;
+            return &this->m_Keys[Slot - 1];
+        }
+
+        // In the order they were declared
+        [[nodiscard]] constexpr const std::array<Key<Owner>, N>& GetKeys() const
+        {
+            return this->m_Keys;
+        }
+
+    private:
+        static_assert(N < 255, "slots hold one byte");
+
+        // FNV-1a, seeded
+        static constexpr std::uint32_t Hash(const std::string_view Name, const std::uint32_t Seed)
+        {
+            std::uint32_t Value = 2166136261u ^ (Seed * 0x9E3779B9u);
+            for (const char Character : Name)
+            {
+                Value ^= static_cast<std::uint8_t>(Character);
+                Value *= 16777619u;
+            }
+            return Value ^ (Value >> 15);
+        }
+
+        std::array<Key<Owner>, N> m_Keys;
+        std::array<std::uint8_t, SLOTS> m_Slots = {}; // index into m_Keys + 1, 0 = empty
+        std::uint32_t m_Seed = 0;
+    };
+
     class Section
     {
     public:
         virtual ~Section() = default;
-        virtual void Parse(std::vector<std::string>& Lines) = 0;
+
+        /**
+         *  Returns how many "Key: Value" lines were read. A malformed number keeps its default and is reported to
+         *  Log; in Strict mode the first one is also returned as the error, and the lines after it are not read.
+         */
+        virtual Expected<std::size_t> Parse(const Lines& Lines, ParseLog* Log = nullptr) = 0;
+
+        /**
+         *  Writes the "Key: Value" lines of the section, without its header. A parsed section writes the keys the
+         *  file had, in its order, with the current values; keys it does not know are written back as they were
+         *  read. A section that was never parsed writes every key it knows, one parsed from no lines writes none.
+         *  Keys that are only written when they are set (colours) are also added when they were set after parsing.
+         */
+        virtual void Write(TextWriter& Writer) const = 0;
 
     protected:
-        std::string GetAttribute(const std::string& Key)
+        /**
+         *  A key that stores its value in Member: strings as they are, numbers parsed (and reported when they are
+         *  malformed), bools as a non-zero integer.
+         */
+        template <auto Member>
+        static constexpr auto Bind(const std::string_view Name)
         {
-            return !this->m_SectionMap[Key].empty() ? this->m_SectionMap[Key] : "";
-            // if not found, should return empty string because may be "N/A" is known as a valid value
-            // you can check by using std::string::empty()
+            using Owner = typename MemberOf<decltype(Member)>::Owner;
+            using T = typename MemberOf<decltype(Member)>::Type;
+            return Key<Owner>{
+                Name, [](Owner& Target, const std::string_view Value)
+                {
+                    if constexpr (std::is_same_v<T, std::string>) Target.*Member = Value;
+                    else if constexpr (std::is_same_v<T, bool>)
+                        Target.*Member = Target.template Number<std::int32_t>(Value).value_or(0) != 0;
+                    else if (const auto Number = Target.template Number<T>(Value)) Target.*Member = *Number;
+                },
+                [](const Owner& Source, TextWriter& Writer) { Writer << Source.*Member; }
+            };
         }
 
-        void LoadAttributes(const std::vector<std::string>& Lines)
+        /**
+         *  Reads every "Key: Value" line of Lines in one pass, handing each value to its entry in Keys as a view
+         *  into the line. Lines without ':', unknown keys and empty values are skipped; a repeated key is applied
+         *  again, so the last one wins. In Strict mode reading stops at the first value that fails.
+         */
+        template <typename Owner, std::size_t N>
+        Expected<std::size_t> ParseKeys(Owner& Target, const KeyTable<Owner, N>& Keys, const Lines& Lines,
+                                        const std::string_view Name, ParseLog* Log)
         {
-            for (const std::string& Line : Lines)
+            this->m_Lines = &Lines;
+            this->m_Name = Name;
+            this->m_Log = Log;
+            this->m_Failure.reset();
+            this->m_Order.clear();
+            this->m_Order.reserve(Lines.size());
+            this->m_Parsed = true;
+
+            std::size_t Read = 0;
+            for (const std::string_view Line : Lines)
             {
-                if (Line.find(':') == std::string::npos)
+                const auto Colon = Line.find(':');
+                if (Colon == std::string_view::npos) continue;
+                ++Read;
+                const Key<Owner>* Entry = Keys.Find(Utilities::Trim(Line.substr(0, Colon)));
+                if (!Entry)
                 {
+                    this->m_Order.push_back({{}, std::string(Line)});
                     continue;
                 }
-                std::vector<std::string> SplitLine = Utilities::Split(Line, ':', true);
-                for (auto &str: SplitLine) str = Utilities::Trim(str);
+                this->m_Order.push_back({Entry->Name, {}});
+                const std::string_view Value = Utilities::Trim(Line.substr(Colon + 1));
+                if (!Value.empty()) Entry->Apply(Target, Value);
+                if (this->m_Failure) break; // only set in Strict mode
+            }
+
+            this->m_Lines = nullptr;
+            this->m_Log = nullptr;
+            if (this->m_Failure) return Unexpected{std::move(*this->m_Failure)};
+            return Read;
+        }
+
+        // The lines Write() describes, each one "Name" + Separator + value
+        template <typename Owner, std::size_t N>
+        void WriteKeys(const Owner& Source, const KeyTable<Owner, N>& Keys, TextWriter& Writer,
+                       const std::string_view Separator) const
+        {
+            std::array<bool, N> Written = {};
+            const auto WriteKey = [&](const Key<Owner>& Entry)
+            {
+                Written[&Entry - Keys.GetKeys().data()] = true;
+                if (Entry.Present && !Entry.Present(Source)) return;
+                Writer << Entry.Name << Separator;
+                Entry.Write(Source, Writer);
+                Writer.NewLine();
+            };
 
-                if (SplitLine.size() > 1)
+            for (const auto& [Name, Unknown] : this->m_Order)
+            {
+                if (const Key<Owner>* Entry = Name.empty() ? nullptr : Keys.Find(Name)) WriteKey(*Entry);
+                else
                 {
-                    this->InsertAttribute(SplitLine[0], Utilities::Trim(SplitLine[1]));
+                    Writer << Unknown;
+                    Writer.NewLine();
                 }
             }
+            // everything when nothing was parsed, otherwise only what was set since
+            for (const Key<Owner>& Entry : Keys.GetKeys())
+                if (!Written[&Entry - Keys.GetKeys().data()] && (!this->m_Parsed || Entry.Present)) WriteKey(Entry);
+        }
+
+        // Value as a number; empty when it is malformed, which is reported. Only valid inside ParseKeys
+        template <typename T>
+        std::optional<T> Number(const std::string_view Value)
+        {
+            const auto Parsed = Utilities::ParseNumber<T>(Value);
+            if (Parsed) return *Parsed;
+            this->Report(Value, Parsed.error());
+            return std::nullopt;
         }
 
-        void InsertAttribute(const std::string& Key, const std::string& Value)
+        // Reports Text, a view into the value being applied; Position overrides where it is (for missing parts)
+        void Report(const std::string_view Text, const ParseErrorCode Code, const char* Position = nullptr)
         {
-            this->m_SectionMap[Key] = Value;
+            ParseError Error;
+            Error.Section = this->m_Name;
+            Error.Field = 1;
+            Error.Code = Code;
+            Error.Text = Text;
+            if (this->m_Lines)
+            {
+                const Lines::Location Location = this->m_Lines->Locate(Position ? Position : Text.data());
+                Error.Line = Location.Line;
+                Error.Column = Location.Column;
+            }
+            if (!ParseLog::Skip(this->m_Log, Error) && !this->m_Failure) this->m_Failure = std::move(Error);
         }
 
     private:
-        std::map<std::string, std::string> m_SectionMap = {};
+        template <typename>
+        struct MemberOf;
+
+        template <typename C, typename T>
+        struct MemberOf<T C::*>
+        {
+            using Owner = C;
+            using Type = T;
+        };
+
+        // A line ParseKeys read: the name of a known key (a view of its table entry), or the whole unknown line
+        struct ReadKey
+        {
+            std::string_view Name;
+            std::string Unknown;
+        };
+
+        std::vector<ReadKey> m_Order;
+        bool m_Parsed = false;
+        const Lines* m_Lines = nullptr;
+        std::string_view m_Name;
+        ParseLog* m_Log = nullptr;
+        std::optional<ParseError> m_Failure;
     };
-} // namespace Parser
\ No newline at end of file
+} // namespace Parser
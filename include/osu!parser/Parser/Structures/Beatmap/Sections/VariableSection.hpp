@@ -1,6 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "Section.hpp"
 
 namespace OsuParser::Beatmap::Sections::Variable
@@ -9,16 +11,36 @@ namespace OsuParser::Beatmap::Sections::Variable
     {
         std::unordered_map<std::string, std::string> Variables;
 
-        void Parse(std::vector<std::string>& Lines) override
+        // Returns how many "$name=value" lines were read
+        Expected<std::size_t> Parse(const Lines& Lines, ParseLog* = nullptr) override
         {
-            this->LoadAttributes(Lines);
-
-            for (const auto& line : Lines)
+            std::size_t Read = 0;
+            for (const std::string_view line : Lines)
             {
                 if (const auto parts = Utilities::Split(line, '=', true);
                     parts.size() >= 2)
-                    Variables[Utilities::Trim(parts[0])] = Utilities::Trim(parts[1]);
+                {
+                    auto [it, added] = Variables.insert_or_assign(std::string(Utilities::Trim(parts[0])),
+                                                                  std::string(Utilities::Trim(parts[1])));
+                    if (added) m_Order.push_back(it->first);
+                    ++Read;
+                }
             }
+            return Read;
+        }
+
+        // "$name=value" lines, in the order they were read; variables added since come after them
+        void Write(TextWriter& Writer) const override
+        {
+            const auto write = [&Writer](const std::string& name, const std::string& value)
+            {
+                Writer << name << '=' << value;
+                Writer.NewLine();
+            };
+            for (const std::string& name : m_Order)
+                if (const auto it = Variables.find(name); it != Variables.end()) write(name, it->second);
+            for (const auto& [name, value] : Variables)
+                if (std::ranges::find(m_Order, name) == m_Order.end()) write(name, value);
         }
 
         [[nodiscard]] std::string GetVariable(const std::string& name) const
@@ -33,21 +55,25 @@ namespace OsuParser::Beatmap::Sections::Variable
 
         void ProvideVariable(std::string& line) const
         {
-            for (auto begin = line.begin(); begin != line.end(); ++begin)
+            for (auto begin = line.find('$'); begin != std::string::npos; begin = line.find('$', begin))
             {
-                while (begin != line.end() && *begin == '$')
-                {
-                    auto end = begin + 1;
-                    while (end != line.end() && *end != ',') ++end;
+                auto end = line.find(',', begin);
+                if (end == std::string::npos) end = line.size();
 
-                    if (const auto it = Variables.find(std::string(begin, end));
-                        it == Variables.end())
-                    {
-                        begin = end;
-                    }
-                    else line.replace(begin, end, it->second);
+                if (const auto it = Variables.find(line.substr(begin, end - begin));
+                    it == Variables.end())
+                {
+                    begin = end;
+                }
+                else
+                {
+                    line.replace(begin, end - begin, it->second);
+                    begin += it->second.size();
                 }
             }
         }
+
+    private:
+        std::vector<std::string> m_Order;
     };
 }
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+namespace OsuParser
+{
+    enum class Mod : std::uint32_t
+    {
+        None = 0,
+        NoFail = 1 << 0,
+        Easy = 1 << 1,
+        TouchDevice = 1 << 2,
+        Hidden = 1 << 3,
+        HardRock = 1 << 4,
+        SuddenDeath = 1 << 5,
+        DoubleTime = 1 << 6,
+        Relax = 1 << 7,
+        HalfTime = 1 << 8,
+        Nightcore = 1 << 9, // always set together with DoubleTime
+        Flashlight = 1 << 10,
+        Autoplay = 1 << 11,
+        SpunOut = 1 << 12,
+        Autopilot = 1 << 13,
+        Perfect = 1 << 14, // always set together with SuddenDeath
+        ScoreV2 = 1 << 29
+    };
+
+    inline bool HasMod(const std::uint32_t Mods, const Mod Flag)
+    {
+        return (Mods & static_cast<std::uint32_t>(Flag)) != 0;
+    }
+
+    // Playback rate of the song relative to the map's own time
+    inline double GetClockRate(const std::uint32_t Mods)
+    {
+        if (HasMod(Mods, Mod::DoubleTime)) return 1.5;
+        if (HasMod(Mods, Mod::HalfTime)) return 0.75;
+        return 1.0;
+    }
+
+    // HR/EZ scaling applied to CS/OD/AR/HP
+    inline double ApplyDifficultyMods(const double Value, const std::uint32_t Mods, const double HardRockFactor = 1.4)
+    {
+        if (HasMod(Mods, Mod::HardRock)) return Value * HardRockFactor < 10.0 ? Value * HardRockFactor : 10.0;
+        if (HasMod(Mods, Mod::Easy)) return Value * 0.5;
+        return Value;
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OsuParser
+{
+    /**
+     *  Fixed set of worker threads running index loops with range stealing.
+     *
+     *  Run(Count, Function) deals [0, Count) out as one contiguous range per worker. A worker takes indices from
+     *  the front of its own range; once it is empty it steals the back half of another worker's range, so uneven
+     *  items (a 5 MB storyboard next to a 2 KB map) do not leave threads idle. Ranges are guarded by a lock per
+     *  worker, which is only contended while stealing.
+     */
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool(std::uint32_t Threads = 0)
+        {
+            if (!Threads) Threads = std::max(1u, std::thread::hardware_concurrency());
+            this->m_Queues = std::make_unique<Queue[]>(Threads);
+            this->m_Workers.reserve(Threads);
+            for (std::uint32_t Worker = 0; Worker < Threads; Worker++)
+                this->m_Workers.emplace_back([this, Worker] { this->WorkerLoop(Worker); });
+        }
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard Lock(this->m_Lock);
+                this->m_Stopping = true;
+            }
+            this->m_Wake.notify_all();
+            for (auto& Thread : this->m_Workers) Thread.join();
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        [[nodiscard]] std::uint32_t GetThreadCount() const
+        {
+            return static_cast<std::uint32_t>(this->m_Workers.size());
+        }
+
+        // Calls Function(Index, Worker) for every Index in [0, Count) and blocks until all calls returned
+        void Run(const std::size_t Count, std::function<void(std::size_t, std::uint32_t)> Function)
+        {
+            if (!Count) return;
+            std::lock_guard RunLock(this->m_RunLock); // one loop at a time
+            std::unique_lock Lock(this->m_Lock);
+            this->m_Function = std::move(Function);
+
+            const std::size_t Threads = this->m_Workers.size();
+            for (std::size_t Worker = 0; Worker < Threads; Worker++)
+            {
+                std::lock_guard QueueLock(this->m_Queues[Worker].Lock);
+                this->m_Queues[Worker].Begin = Count * Worker / Threads;
+                this->m_Queues[Worker].End = Count * (Worker + 1) / Threads;
+            }
+
+            this->m_Active = static_cast<std::uint32_t>(Threads);
+            this->m_Generation++;
+            this->m_Wake.notify_all();
+            this->m_Done.wait(Lock, [this] { return this->m_Active == 0; });
+            this->m_Function = nullptr;
+        }
+
+    private:
+        struct alignas(64) Queue
+        {
+            std::mutex Lock;
+            std::size_t Begin = 0;
+            std::size_t End = 0;
+        };
+
+        void WorkerLoop(const std::uint32_t Worker)
+        {
+            std::uint64_t SeenGeneration = 0;
+            while (true)
+            {
+                {
+                    std::unique_lock Lock(this->m_Lock);
+                    this->m_Wake.wait(Lock, [&]
+                    {
+                        return this->m_Stopping || this->m_Generation != SeenGeneration;
+                    });
+                    if (this->m_Stopping) return;
+                    SeenGeneration = this->m_Generation;
+                }
+
+                std::size_t Index;
+                while (this->Pop(Worker, Index) || this->Steal(Worker, Index)) this->m_Function(Index, Worker);
+
+                std::lock_guard Lock(this->m_Lock);
+                if (--this->m_Active == 0) this->m_Done.notify_all();
+            }
+        }
+
+        bool Pop(const std::uint32_t Worker, std::size_t& Index)
+        {
+            Queue& Own = this->m_Queues[Worker];
+            std::lock_guard Lock(Own.Lock);
+            if (Own.Begin == Own.End) return false;
+            Index = Own.Begin++;
+            return true;
+        }
+
+        bool Steal(const std::uint32_t Worker, std::size_t& Index)
+        {
+            const auto Threads = static_cast<std::uint32_t>(this->m_Workers.size());
+            for (std::uint32_t Offset = 1; Offset < Threads; Offset++)
+            {
+                Queue& Victim = this->m_Queues[(Worker + Offset) % Threads];
+                std::size_t Begin, End;
+                {
+                    std::lock_guard Lock(Victim.Lock);
+                    if (Victim.Begin == Victim.End) continue;
+                    End = Victim.End;
+                    Begin = Victim.Begin + (Victim.End - Victim.Begin) / 2; // back half, the victim keeps the front
+                    Victim.End = Begin;
+                }
+
+                // the own range is empty here and only its owner ever refills it
+                Index = Begin;
+                Queue& Own = this->m_Queues[Worker];
+                std::lock_guard Lock(Own.Lock);
+                Own.Begin = Begin + 1;
+                Own.End = End;
+                return true;
+            }
+            return false;
+        }
+
+        std::vector<std::thread> m_Workers;
+        std::unique_ptr<Queue[]> m_Queues;
+        std::function<void(std::size_t, std::uint32_t)> m_Function;
+
+        std::mutex m_RunLock;
+        std::mutex m_Lock;
+        std::condition_variable m_Wake;
+        std::condition_variable m_Done;
+        std::uint64_t m_Generation = 0;
+        std::uint32_t m_Active = 0;
+        bool m_Stopping = false;
+    };
+}
@@ -1,7 +1,20 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+#include "ParseError.hpp"
 
 namespace OsuParser::Utilities
 {
@@ -44,4 +57,122 @@ namespace OsuParser::Utilities
 
         return Input;
     }
+
+    // Same splitting rules as above (a trailing empty field is dropped), without copying: views point into Input
+    inline std::vector<std::string_view> Split(const std::string_view Input, const char Delimeter,
+                                               const bool onlyTwoPart = false)
+    {
+        std::vector<std::string_view> Output;
+        if (onlyTwoPart)
+        {
+            const auto Position = Input.find(Delimeter);
+            Output.push_back(Input.substr(0, Position));
+            Output.push_back(Position == std::string_view::npos ? std::string_view{} : Input.substr(Position + 1));
+            return Output;
+        }
+
+        std::size_t Begin = 0;
+        while (Begin < Input.size())
+        {
+            const auto Position = Input.find(Delimeter, Begin);
+            if (Position == std::string_view::npos)
+            {
+                Output.push_back(Input.substr(Begin));
+                break;
+            }
+            Output.push_back(Input.substr(Begin, Position - Begin));
+            Begin = Position + 1;
+        }
+        return Output;
+    }
+
+    inline std::string_view Trim(std::string_view Input, const bool onlyRight = false, const char& space = ' ')
+    {
+        const auto Last = Input.find_last_not_of(space);
+        Input = Last == std::string_view::npos ? std::string_view{} : Input.substr(0, Last + 1);
+        if (!onlyRight) Input.remove_prefix(std::min(Input.find_first_not_of(space), Input.size()));
+        return Input;
+    }
+
+    /**
+     *  Parses the whole of Input (surrounding spaces and a leading '+' allowed) with std::from_chars: no temporary
+     *  string, no locale, no exceptions. Integers written with a fraction or exponent ("256.5", "1e3") are accepted
+     *  and truncated toward zero, since some editors write coordinates and times that way.
+     */
+    template <typename T>
+    Expected<T, ParseErrorCode> ParseNumber(std::string_view Input)
+    {
+        Input = Trim(Input);
+        if (!Input.empty() && Input.front() == '+') Input.remove_prefix(1);
+        const char* Begin = Input.data();
+        const char* End = Input.data() + Input.size();
+
+        T Value{};
+        const auto [Stop, Error] = std::from_chars(Begin, End, Value);
+        if constexpr (std::is_integral_v<T>)
+        {
+            if (Error == std::errc{} && Stop != End && (*Stop == '.' || *Stop == 'e' || *Stop == 'E'))
+            {
+                double Real = 0;
+                const auto Result = std::from_chars(Begin, End, Real);
+                if (Result.ec == std::errc{} && Result.ptr == End)
+                {
+                    Real = std::trunc(Real);
+                    if (!(Real >= static_cast<double>(std::numeric_limits<T>::min())
+                        && Real <= static_cast<double>(std::numeric_limits<T>::max())))
+                        return Unexpected{ParseErrorCode::OutOfRange};
+                    return static_cast<T>(Real);
+                }
+            }
+        }
+        if (Error == std::errc::result_out_of_range) return Unexpected{ParseErrorCode::OutOfRange};
+        if (Error != std::errc{} || Stop != End) return Unexpected{ParseErrorCode::InvalidNumber};
+        return Value;
+    }
+
+    // 0 when Input is not a number; use ParseNumber to tell the two apart
+    inline std::int32_t ToInt(const std::string_view Input)
+    {
+        return ParseNumber<std::int32_t>(Input).value_or(0);
+    }
+
+    inline double ToDouble(const std::string_view Input)
+    {
+        return ParseNumber<double>(Input).value_or(0);
+    }
+
+    // Text as the byte span taken by the in-memory Beatmap/Replay/Database constructors
+    inline std::span<const std::byte> AsBytes(const std::string_view Input)
+    {
+        return {reinterpret_cast<const std::byte*>(Input.data()), Input.size()};
+    }
+
+    /**
+     *  Runs Function(Index, Worker) for every Index in [0, Count) on up to Threads threads (0 = hardware concurrency).
+     *  Items are dealt round-robin, so Worker can be used to index per-thread state without locking.
+     *  Returns the number of workers used.
+     */
+    template <typename Fn>
+    std::uint32_t ParallelFor(const std::size_t Count, std::uint32_t Threads, const Fn& Function)
+    {
+        if (!Threads) Threads = std::max(1u, std::thread::hardware_concurrency());
+        Threads = static_cast<std::uint32_t>(std::max<std::size_t>(1, std::min<std::size_t>(Threads, Count)));
+        if (Threads == 1)
+        {
+            for (std::size_t Index = 0; Index < Count; Index++) Function(Index, 0u);
+            return 1;
+        }
+
+        std::vector<std::thread> Workers;
+        Workers.reserve(Threads);
+        for (std::uint32_t Worker = 0; Worker < Threads; Worker++)
+        {
+            Workers.emplace_back([&, Worker]
+            {
+                for (std::size_t Index = Worker; Index < Count; Index += Threads) Function(Index, Worker);
+            });
+        }
+        for (auto& Thread : Workers) Thread.join();
+        return Threads;
+    }
 }
@@ -0,0 +1,128 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace OsuParser
+{
+    /**
+     *  Text output for the .osu writers: one growable buffer, numbers formatted with std::to_chars.
+     *
+     *  Without a sink everything stays in the buffer until Take(). With a sink the buffer is handed to it every
+     *  FlushSize bytes and on destruction, so writing a 5 MB storyboard never holds more than that in memory.
+     *  Floating point values are written as the shortest fixed notation that reads back to the same value, which
+     *  is how "333.333333333333" or "0.7" look in the file to begin with.
+     */
+    class TextWriter
+    {
+    public:
+        static constexpr std::size_t DEFAULT_FLUSH_SIZE = 64 * 1024;
+
+        TextWriter() = default;
+
+        explicit TextWriter(std::ostream& Sink, const std::size_t FlushSize = DEFAULT_FLUSH_SIZE)
+            : m_Sink(&Sink), m_FlushSize(FlushSize)
+        {
+            this->m_Buffer.reserve(FlushSize + 512);
+        }
+
+        ~TextWriter()
+        {
+            this->Flush();
+        }
+
+        TextWriter(const TextWriter&) = delete;
+        TextWriter& operator=(const TextWriter&) = delete;
+
+        // "\r\n" (what osu! writes) unless told otherwise
+        void SetLineEnding(const std::string_view LineEnding)
+        {
+            this->m_LineEnding = LineEnding;
+        }
+
+        [[nodiscard]] std::string_view GetLineEnding() const
+        {
+            return this->m_LineEnding;
+        }
+
+        void Reserve(const std::size_t Size)
+        {
+            this->m_Buffer.reserve(Size);
+        }
+
+        TextWriter& operator<<(const std::string_view Text)
+        {
+            this->m_Buffer.append(Text);
+            return *this;
+        }
+
+        TextWriter& operator<<(const char* Text)
+        {
+            return *this << std::string_view(Text);
+        }
+
+        TextWriter& operator<<(const std::string& Text)
+        {
+            return *this << std::string_view(Text);
+        }
+
+        TextWriter& operator<<(const char Character)
+        {
+            this->m_Buffer.push_back(Character);
+            return *this;
+        }
+
+        // Integers and floating point values; bools are written as 0 or 1
+        template <typename T> requires std::is_arithmetic_v<T> && (!std::is_same_v<T, char>)
+        TextWriter& operator<<(const T Value)
+        {
+            if constexpr (std::is_same_v<T, bool>) return *this << (Value ? '1' : '0');
+            else
+            {
+                // fixed notation of a double can take up to 309 digits before the point
+                char Digits[std::is_floating_point_v<T> ? 400 : 24];
+                std::to_chars_result Result;
+                if constexpr (std::is_floating_point_v<T>)
+                    Result = std::to_chars(Digits, Digits + sizeof(Digits), Value, std::chars_format::fixed);
+                else Result = std::to_chars(Digits, Digits + sizeof(Digits), Value);
+                this->m_Buffer.append(Digits, Result.ptr);
+                return *this;
+            }
+        }
+
+        // Ends the current line, and hands the buffer to the sink once it is large enough
+        void NewLine()
+        {
+            this->m_Buffer.append(this->m_LineEnding);
+            if (this->m_Sink && this->m_Buffer.size() >= this->m_FlushSize) this->Flush();
+        }
+
+        void Flush()
+        {
+            if (!this->m_Sink || this->m_Buffer.empty()) return;
+            this->m_Sink->write(this->m_Buffer.data(), static_cast<std::streamsize>(this->m_Buffer.size()));
+            this->m_Buffer.clear();
+        }
+
+        // What was written and not flushed yet
+        [[nodiscard]] std::string_view GetBuffer() const
+        {
+            return this->m_Buffer;
+        }
+
+        [[nodiscard]] std::string Take()
+        {
+            return std::move(this->m_Buffer);
+        }
+
+    private:
+        std::string m_Buffer;
+        std::ostream* m_Sink = nullptr;
+        std::size_t m_FlushSize = DEFAULT_FLUSH_SIZE;
+        std::string_view m_LineEnding = "\r\n";
+    };
+}